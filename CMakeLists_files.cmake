@@ -53,6 +53,7 @@ list(APPEND TEST_DATA_FILES
 	tests/data/equil_base.DATA
 	tests/data/equil_livegas.DATA
 	tests/data/equil_liveoil.DATA
+	tests/data/ebos_column.DATA
 	)
 
 list(APPEND TEST_SOURCE_FILES)
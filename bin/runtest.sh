@@ -12,7 +12,9 @@ usage() {
     echo "Usage:"
     echo
     echo "runTest.sh TEST_TYPE TEST_BINARY [TEST_ARGS]"
-    echo "where TEST_TYPE can either be --plain, --simulation or --parallel-simulation=\$NUM_CORES (is '$TEST_TYPE')."
+    echo "where TEST_TYPE can either be --plain, --simulation, --parallel-simulation=\$NUM_CORES,"
+    echo "--restart, --parallel-restart=\$NUM_CORES[:\$NUM_RESTART_CORES],"
+    echo "--case-cache or --parameters (is '$TEST_TYPE')."
 };
 
 validateResults() {
@@ -182,6 +184,103 @@ case "$TEST_TYPE" in
         exit 0
         ;;        
 
+    "--parallel-restart="*)
+        # the restart may use a different number of processes, e.g.,
+        # --parallel-restart=4:2
+        NUM_PROCS="${TEST_TYPE/--parallel-restart=/}"
+        NUM_RESTART_PROCS="${NUM_PROCS#*:}"
+        NUM_PROCS="${NUM_PROCS%%:*}"
+
+        echo "executing \"mpirun -np \"$NUM_PROCS\" $TEST_BINARY $TEST_ARGS\""
+        mpirun -np "$NUM_PROCS" "$TEST_BINARY" $TEST_ARGS | tee "test-$RND.log"
+        RET="${PIPESTATUS[0]}"
+        if test "$RET" != "0"; then
+            echo "Executing the binary failed!"
+            rm "test-$RND.log"
+            exit 1
+        fi
+        RESTART_TIME=$(grep "Serialize" "test-$RND.log" | tail -n 1 | sed "s/.*time=\([0-9.e+\-]*\).*/\1/")
+        rm "test-$RND.log"
+        if test -z "$RESTART_TIME"; then
+            echo "$TEST_BINARY did not write a restart file"
+            exit 1
+        fi
+
+        echo "restarting using $NUM_RESTART_PROCS processes"
+        if ! mpirun -np "$NUM_RESTART_PROCS" "$TEST_BINARY" $TEST_ARGS --restart-time="$RESTART_TIME" --newton-write-convergence=true; then
+            echo "Restarting $TEST_BINARY failed"
+            exit 1;
+        fi
+        exit 0
+        ;;
+
+    "--case-cache")
+        # run the simulation twice: the first run writes the case cache, the second
+        # one must use it and produce the same result
+        CACHE_DIR="case-cache-$RND"
+        mkdir -p "$CACHE_DIR"
+        CACHE_ARGS="--enable-ecl-case-cache=true --ecl-case-cache-directory=$CACHE_DIR"
+
+        echo "executing \"$TEST_BINARY $TEST_ARGS $CACHE_ARGS\""
+        "$TEST_BINARY" $TEST_ARGS $CACHE_ARGS | tee "test-$RND.log"
+        RET="${PIPESTATUS[0]}"
+        if test "$RET" != "0"; then
+            echo "Executing the binary failed!"
+            rm -rf "$CACHE_DIR" "test-$RND.log"
+            exit 1
+        fi
+
+        SIM_NAME=$(grep "Applying the initial solution of the" "test-$RND.log" | sed "s/.*\"\(.*\)\".*/\1/" | head -n1)
+        NUM_TIMESTEPS=$(( $(grep "Time step [0-9]* done" "test-$RND.log" | wc -l)))
+        FIRST_RESULT=$(printf "%s-%05i" "$SIM_NAME" "$NUM_TIMESTEPS")
+        FIRST_RESULT=$(ls -- "$FIRST_RESULT".*)
+        rm "test-$RND.log"
+        if ! test -r "$FIRST_RESULT"; then
+            echo "File $FIRST_RESULT does not exist or is not readable"
+            rm -rf "$CACHE_DIR"
+            exit 1
+        fi
+
+        # keep the result of the first run, the second one overwrites it
+        REFERENCE_RESULT="$CACHE_DIR/first-run.${FIRST_RESULT##*.}"
+        mv "$FIRST_RESULT" "$REFERENCE_RESULT"
+
+        "$TEST_BINARY" $TEST_ARGS $CACHE_ARGS | tee "test-$RND.log"
+        RET="${PIPESTATUS[0]}"
+        if test "$RET" != "0"; then
+            echo "Re-running $TEST_BINARY using the case cache failed"
+            rm -rf "$CACHE_DIR" "test-$RND.log"
+            exit 1
+        fi
+        if ! grep -q "Using the case cache" "test-$RND.log"; then
+            echo "$TEST_BINARY did not use the case cache written by the first run"
+            rm -rf "$CACHE_DIR" "test-$RND.log"
+            exit 1
+        fi
+
+        NUM_TIMESTEPS=$(( $(grep "Time step [0-9]* done" "test-$RND.log" | wc -l)))
+        TEST_RESULT=$(printf "%s-%05i" "$SIM_NAME" "$NUM_TIMESTEPS")
+        TEST_RESULT=$(ls -- "$TEST_RESULT".*)
+        rm "test-$RND.log"
+        if ! test -r "$TEST_RESULT"; then
+            echo "File $TEST_RESULT does not exist or is not readable"
+            rm -rf "$CACHE_DIR"
+            exit 1
+        fi
+
+        echo "######################"
+        echo "# Comparing results"
+        echo "######################"
+        if ! python "${MY_DIR}/fuzzycomparevtu.py" "$REFERENCE_RESULT" "$TEST_RESULT"; then
+            echo "The results of the runs with and without a case cache differ"
+            rm -rf "$CACHE_DIR"
+            exit 1
+        fi
+        rm -rf "$CACHE_DIR"
+        echo "Test successful"
+        exit 0
+        ;;
+
     "--parameters")
         HELP_MSG="$($TEST_BINARY --help | clipToHelpMessage)"
         if test "$(echo "$HELP_MSG" | grep -i usage)" == ''; then
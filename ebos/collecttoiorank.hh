@@ -42,6 +42,9 @@
 
 #include <dune/grid/common/mcmgmapper.hh>
 
+#include <algorithm>
+#include <iterator>
+#include <set>
 #include <stdexcept>
 
 namespace Ewoms
@@ -169,8 +172,12 @@ namespace Ewoms
         static const bool needsReordering = ! std::is_same<
             typename GridManager::Grid, typename GridManager::EquilGrid > :: value ;
 
-        CollectDataToIORank( const GridManager& gridManager )
-            : toIORankComm_( )
+        CollectDataToIORank( const GridManager& gridManager, const int maxFieldsPerExchange = 0 )
+            : toIORankComm_( ),
+              toIORankRemainderComm_( ),
+              cachedNumFields_( -1 ),
+              cachedNumRemainderFields_( -1 ),
+              maxFieldsPerExchange_( maxFieldsPerExchange )
         {
             // index maps only have to be build when reordering is needed
             if( ! needsReordering && ! isParallel() )
@@ -259,6 +266,8 @@ namespace Ewoms
 
                 // insert send and recv linkage to communicator
                 toIORankComm_.insertRequest( send, recv );
+                sendRanks_ = send;
+                recvRanks_ = recv;
 
                 // need an index map for each rank
                 indexMaps_.clear();
@@ -270,22 +279,28 @@ namespace Ewoms
             }
         }
 
+        typedef typename Opm::data::Solution::const_iterator CellDataIterator;
+
+        // packs and unpacks the fields of the local cell data in the range [begin, end)
         class PackUnPack : public P2PCommunicatorType::DataHandleInterface
         {
-            const Opm::data::Solution& localCellData_;
+            const CellDataIterator localBegin_;
+            const CellDataIterator localEnd_;
             Opm::data::Solution& globalCellData_;
 
             const IndexMapType& localIndexMap_;
             const IndexMapStorageType& indexMaps_;
 
         public:
-            PackUnPack( const Opm::data::Solution& localCellData,
+            PackUnPack( const CellDataIterator localBegin,
+                        const CellDataIterator localEnd,
                         Opm::data::Solution& globalCellData,
                         const IndexMapType& localIndexMap,
                         const IndexMapStorageType& indexMaps,
                         const size_t globalSize,
                         const bool isIORank )
-            : localCellData_( localCellData ),
+            : localBegin_( localBegin ),
+              localEnd_( localEnd ),
               globalCellData_( globalCellData ),
               localIndexMap_( localIndexMap ),
               indexMaps_( indexMaps )
@@ -293,7 +308,8 @@ namespace Ewoms
                 if( isIORank )
                 {
                     // add missing data to global cell data
-                    for (const auto& pair : localCellData_) {
+                    for (auto it = localBegin_; it != localEnd_; ++it) {
+                        const auto& pair = *it;
                         const std::string& key = pair.first;
                         std::size_t container_size = globalSize;
                         auto OPM_OPTIM_UNUSED ret = globalCellData_.insert(key, pair.second.dim,
@@ -319,8 +335,8 @@ namespace Ewoms
                 }
 
                 // write all cell data registered in local state
-                for (const auto& pair : localCellData_) {
-                    const auto& data = pair.second.data;
+                for (auto it = localBegin_; it != localEnd_; ++it) {
+                    const auto& data = it->second.data;
 
                     // write all data from local data to buffer
                     write( buffer, localIndexMap_, data);
@@ -332,8 +348,8 @@ namespace Ewoms
             {
                 // we loop over the data  as
                 // its order governs the order the data got received.
-                for (auto& pair : localCellData_) {
-                    const std::string& key = pair.first;
+                for (auto it = localBegin_; it != localEnd_; ++it) {
+                    const std::string& key = it->first;
                     auto& data = globalCellData_.data(key);
 
                     //write all data from local cell data to buffer
@@ -387,6 +403,11 @@ namespace Ewoms
         };
 
         // gather solution to rank 0 for EclipseWriter
+        //
+        // if a maximum number of fields per exchange was specified, the fields are
+        // gathered in batches of at most this size. this bounds the size of the
+        // messages which the I/O rank needs to hold at the same time, but not the
+        // size of the result: globalCellData_ still contains all fields.
         void collect( const Opm::data::Solution& localCellData )
         {
             globalCellData_ = {};
@@ -396,27 +417,46 @@ namespace Ewoms
                 return ;
             }
 
-            // this also packs and unpacks the local buffers one ioRank
-            PackUnPack
-                packUnpack( localCellData,
-                            globalCellData_,
-                            localIndexMap_,
-                            indexMaps_,
-                            numCells(),
-                            isIORank() );
+            const int numFields = localCellData.size();
+            const int batchSize = ( maxFieldsPerExchange_ > 0 ) ? maxFieldsPerExchange_ : std::max( numFields, 1 );
 
-            if ( ! isParallel() )
+            auto batchBegin = localCellData.begin();
+            for( int fieldIdx = 0; fieldIdx < numFields; fieldIdx += batchSize )
             {
-                // no need to collect anything.
-                return;
-            }
+                const int numBatchFields = std::min( batchSize, numFields - fieldIdx );
+                auto batchEnd = batchBegin;
+                std::advance( batchEnd, numBatchFields );
+
+                // this also packs and unpacks the local buffers one ioRank
+                PackUnPack
+                    packUnpack( batchBegin,
+                                batchEnd,
+                                globalCellData_,
+                                localIndexMap_,
+                                indexMaps_,
+                                numCells(),
+                                isIORank() );
+
+                if ( isParallel() )
+                {
+                    // all full batches exhibit the same message sizes, only the last one
+                    // may be smaller. both kinds use their own communicator, so that the
+                    // buffer sizes of the previous exchange can be reused.
+                    if( numBatchFields == batchSize )
+                        exchangeCached_( toIORankComm_, cachedNumFields_, numBatchFields, packUnpack );
+                    else
+                        exchangeCached_( toIORankRemainderComm_, cachedNumRemainderFields_, numBatchFields, packUnpack );
+                }
 
-            //toIORankComm_.exchangeCached( packUnpack );
-            toIORankComm_.exchange( packUnpack );
+                batchBegin = batchEnd;
+            }
 
 #ifndef NDEBUG
             // mkae sure every process is on the same page
-            toIORankComm_.barrier();
+            if ( isParallel() )
+            {
+                toIORankComm_.barrier();
+            }
 #endif
         }
 
@@ -425,6 +465,22 @@ namespace Ewoms
             return globalCellData_;
         }
 
+        // move the data collected by the last call to collect() out of this object. this
+        // avoids to copy the global fields on the I/O rank.
+        Opm::data::Solution releaseGlobalCellData()
+        {
+            Opm::data::Solution result = std::move( globalCellData_ );
+            globalCellData_ = {};
+            return result;
+        }
+
+        // specify the maximum number of fields which are gathered by a single exchange.
+        // 0 means that all fields are gathered at once.
+        void setMaxFieldsPerExchange( const int value )
+        {
+            maxFieldsPerExchange_ = value;
+        }
+
         bool isIORank() const
         {
             return toIORankComm_.rank() == ioRank;
@@ -455,7 +511,30 @@ namespace Ewoms
         size_t numCells () const { return globalCartesianIndex_.size(); }
 
     protected:
+        // exchange the data using the message sizes of the previous exchange of the
+        // communicator. these are only valid if the same number of fields was sent.
+        void exchangeCached_( P2PCommunicatorType& comm,
+                              int& cachedNumFields,
+                              const int numFields,
+                              PackUnPack& packUnpack )
+        {
+            if( cachedNumFields != numFields )
+            {
+                // re-inserting the linkage discards the cached message sizes
+                comm.insertRequest( sendRanks_, recvRanks_ );
+                cachedNumFields = numFields;
+            }
+
+            comm.exchangeCached( packUnpack );
+        }
+
         P2PCommunicatorType             toIORankComm_;
+        P2PCommunicatorType             toIORankRemainderComm_;
+        std::set< int >                 sendRanks_;
+        std::set< int >                 recvRanks_;
+        int                             cachedNumFields_;
+        int                             cachedNumRemainderFields_;
+        int                             maxFieldsPerExchange_;
         IndexMapType                    globalCartesianIndex_;
         IndexMapType                    localIndexMap_;
         IndexMapStorageType             indexMaps_;
@@ -137,7 +137,14 @@ public:
     {
         auto gridView = grid().leafGridView();
         auto dataHandle = cartesianIndexMapper_->dataHandle(gridView);
-        grid().loadBalance(*dataHandle);
+
+        const auto& cartesianCosts = this->readElementCostProfile_();
+        if (cartesianCosts.empty())
+            grid().loadBalance(*dataHandle);
+        else {
+            ElementWeights_ weights(gridView, *cartesianIndexMapper_, cartesianCosts);
+            grid().loadBalance(weights, *dataHandle);
+        }
 
         // communicate non-interior cells values
         grid().communicate(*dataHandle,
@@ -159,6 +166,48 @@ public:
     { return *equilCartesianIndexMapper_; }
 
 protected:
+    // the load balancing weights of the elements in the format expected by ALUGrid. the
+    // weights are the costs of the cells measured by a previous run.
+    class ElementWeights_
+    {
+        typedef typename Grid::LeafGridView LeafGridView;
+        typedef typename LeafGridView::template Codim<0>::Entity Element;
+
+    public:
+        ElementWeights_(const LeafGridView& gridView,
+                        const CartesianIndexMapper& cartesianIndexMapper,
+                        const std::vector<double>& cartesianCosts)
+            : indexSet_(gridView.indexSet())
+            , weights_(static_cast<size_t>(indexSet_.size(/*codim=*/0)))
+        {
+            // the Cartesian index mapper uses the order of the element iterator
+            int elemIdx = 0;
+            auto elemIt = gridView.template begin</*codim=*/0>();
+            const auto& elemEndIt = gridView.template end</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt, ++elemIdx) {
+                int cartIdx = cartesianIndexMapper.cartesianIndex(elemIdx);
+                weights_[indexSet_.index(*elemIt)] =
+                    static_cast<int>(100*cartesianCosts[static_cast<size_t>(cartIdx)]) + 1;
+            }
+        }
+
+        bool userDefinedPartitioning() const
+        { return false; }
+
+        bool userDefinedLoadWeights() const
+        { return true; }
+
+        bool repartition() const
+        { return true; }
+
+        int operator()(const Element& elem) const
+        { return weights_[indexSet_.index(elem)]; }
+
+    private:
+        const typename LeafGridView::IndexSet& indexSet_;
+        std::vector<int> weights_;
+    };
+
     void createGrids_()
     {
         const auto& gridProps = this->eclState().get3DProperties();
@@ -40,10 +40,20 @@
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 #include <opm/parser/eclipse/EclipseState/SummaryConfig/SummaryConfig.hpp>
 
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/common/version.hh>
+
 #if HAVE_MPI
 #include <mpi.h>
 #endif // HAVE_MPI
 
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
 #include <vector>
 #include <unordered_set>
 #include <array>
@@ -59,9 +69,14 @@ NEW_TYPE_TAG(EclBaseGridManager);
 NEW_PROP_TAG(Grid);
 NEW_PROP_TAG(EquilGrid);
 NEW_PROP_TAG(Scalar);
+NEW_PROP_TAG(ElementMapper);
 NEW_PROP_TAG(EclDeckFileName);
+NEW_PROP_TAG(ElementCostProfile);
+NEW_PROP_TAG(ElementCostProfileOutput);
 
 SET_STRING_PROP(EclBaseGridManager, EclDeckFileName, "ECLDECK.DATA");
+SET_STRING_PROP(EclBaseGridManager, ElementCostProfile, "");
+SET_STRING_PROP(EclBaseGridManager, ElementCostProfileOutput, "");
 } // namespace Properties
 
 /*!
@@ -92,6 +107,14 @@ public:
     {
         EWOMS_REGISTER_PARAM(TypeTag, std::string, EclDeckFileName,
                              "The name of the file which contains the ECL deck to be simulated");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ElementCostProfile,
+                             "A file with the computational costs of the cells measured by a "
+                             "previous run. It is used to weight the cells when the grid is "
+                             "distributed");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ElementCostProfileOutput,
+                             "The file to which the computational costs of the cells are "
+                             "written. This requires the MeasureElementCosts parameter to "
+                             "be true");
     }
 
     /*!
@@ -121,10 +144,8 @@ public:
     EclBaseGridManager(Simulator& simulator)
         : ParentType(simulator)
     {
-        int myRank = 0;
-#if HAVE_MPI
-        MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
-#endif
+        typedef Dune::CollectiveCommunication<Dune::MPIHelper::MPICommunicator> CollectiveCommunication;
+        int myRank = CollectiveCommunication(simulator.communicator()).rank();
 
         std::string fileName = EWOMS_GET_PARAM(TypeTag, std::string, EclDeckFileName);
 
@@ -255,6 +276,29 @@ public:
     unsigned cartesianIndex(unsigned compressedCellIdx) const
     { return asImp_().cartesianIndexMapper().cartesianIndex(compressedCellIdx); }
 
+    /*!
+     * \brief Returns true if globalEntityIndex() can be used for the entities of a given
+     *        codimension.
+     *
+     * For ECL grids, this is only the case for the elements.
+     */
+    template <int codim>
+    bool hasGlobalEntityIndices() const
+    { return codim == 0; }
+
+    /*!
+     * \brief Returns the Cartesian index of an element.
+     *
+     * In contrast to the indices of the grid view, this index does not depend on the
+     * distribution of the grid.
+     */
+    template <class Entity>
+    uint64_t globalEntityIndex(const Entity& elem) const
+    {
+        const auto& gridView = asImp_().grid().leafGridView();
+        return cartesianIndex(static_cast<unsigned>(gridView.indexSet().index(elem)));
+    }
+
     /*!
      * \brief Return the index of the cells in the logical Cartesian grid
      */
@@ -304,6 +348,151 @@ public:
     std::unordered_set<std::string> defunctWellNames() const
     { return std::unordered_set<std::string>(); }
 
+    /*!
+     * \brief Write the measured computational costs of the cells to the file specified
+     *        by the ElementCostProfileOutput parameter.
+     *
+     * The costs of the interior cells of all processes are collected by the first rank
+     * which writes one line consisting of the Cartesian index and the cost for each
+     * cell. This file can then be used as the ElementCostProfile of later runs.
+     *
+     * \param elementCosts The costs of the local elements indexed by the element mapper
+     * \param elementMapper The mapper from the local elements to their indices
+     */
+    template <class ElementMapper>
+    void writeElementCostProfile(const std::vector<double>& elementCosts,
+                                 const ElementMapper& elementMapper)
+    {
+        const std::string& fileName =
+            EWOMS_GET_PARAM(TypeTag, std::string, ElementCostProfileOutput);
+        if (fileName.empty() || elementCosts.empty())
+            return;
+
+        std::vector<int> cartIndices;
+        std::vector<double> costs;
+        const auto& gridView = this->gridView();
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            if (elem.partitionType() != Dune::InteriorEntity)
+                continue;
+
+            unsigned elemIdx = elementMapper.index(elem);
+            cartIndices.push_back(static_cast<int>(cartesianIndex(elemIdx)));
+            costs.push_back(elementCosts[elemIdx]);
+        }
+
+#if HAVE_MPI
+        MPI_Comm comm = this->communicator_();
+        int myRank;
+        int commSize;
+        MPI_Comm_rank(comm, &myRank);
+        MPI_Comm_size(comm, &commSize);
+
+        int numLocal = static_cast<int>(costs.size());
+        std::vector<int> counts(static_cast<size_t>(commSize));
+        MPI_Gather(&numLocal, 1, MPI_INT, counts.data(), 1, MPI_INT, /*root=*/0, comm);
+
+        std::vector<int> offsets(static_cast<size_t>(commSize) + 1, 0);
+        for (size_t i = 0; i < counts.size(); ++i)
+            offsets[i + 1] = offsets[i] + counts[i];
+
+        std::vector<int> allCartIndices(static_cast<size_t>(offsets.back()));
+        std::vector<double> allCosts(static_cast<size_t>(offsets.back()));
+        MPI_Gatherv(cartIndices.data(), numLocal, MPI_INT,
+                    allCartIndices.data(), counts.data(), offsets.data(), MPI_INT,
+                    /*root=*/0, comm);
+        MPI_Gatherv(costs.data(), numLocal, MPI_DOUBLE,
+                    allCosts.data(), counts.data(), offsets.data(), MPI_DOUBLE,
+                    /*root=*/0, comm);
+        if (myRank != 0)
+            return;
+
+        cartIndices.swap(allCartIndices);
+        costs.swap(allCosts);
+#endif
+
+        std::ofstream os(fileName);
+        os << std::setprecision(10);
+        for (size_t i = 0; i < costs.size(); ++i)
+            os << cartIndices[i] << " " << costs[i] << "\n";
+    }
+
+protected:
+    /*!
+     * \brief Read the cell costs specified by the ElementCostProfile parameter.
+     *
+     * The result is indexed by the cells of the logically Cartesian grid and normalized,
+     * i.e., a cell of average cost has a weight of 1. Cells which are not mentioned by
+     * the profile are assumed to be of average cost. If no profile was specified, an
+     * empty vector is returned.
+     */
+    std::vector<double> readElementCostProfile_() const
+    {
+        const std::string& fileName = EWOMS_GET_PARAM(TypeTag, std::string, ElementCostProfile);
+        if (fileName.empty())
+            return std::vector<double>();
+
+        std::ifstream is(fileName);
+        if (!is)
+            OPM_THROW(std::runtime_error, "Could not open the element cost profile '" << fileName << "'");
+
+        size_t numCartesianCells = eclState().getInputGrid().getCartesianSize();
+        std::vector<double> cartesianCosts(numCartesianCells, -1.0);
+        double costSum = 0.0;
+        size_t numCosts = 0;
+        int cartIdx;
+        double cost;
+        while (is >> cartIdx >> cost) {
+            if (cartIdx < 0 || static_cast<size_t>(cartIdx) >= numCartesianCells)
+                OPM_THROW(std::runtime_error,
+                          "The element cost profile '" << fileName << "' does not match the grid");
+
+            cartesianCosts[static_cast<size_t>(cartIdx)] = cost;
+            costSum += cost;
+            ++numCosts;
+        }
+
+        double meanCost = (numCosts > 0 && costSum > 0) ? costSum/numCosts : 1.0;
+        for (auto& cellCost : cartesianCosts)
+            cellCost = (cellCost < 0) ? 1.0 : std::max(cellCost/meanCost, 1e-3);
+
+        return cartesianCosts;
+    }
+
+    /*!
+     * \brief Print the load imbalance which is to be expected for the current
+     *        distribution of the grid given cell costs of a previous run.
+     */
+    void reportExpectedImbalance_(const std::vector<double>& cartesianCosts)
+    {
+        typedef typename GET_PROP_TYPE(TypeTag, ElementMapper) ElementMapper;
+
+        const auto& gridView = this->gridView();
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+        ElementMapper elemMapper(gridView, Dune::mcmgElementLayout());
+#else
+        ElementMapper elemMapper(gridView);
+#endif
+
+        double localCost = 0.0;
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            if (elem.partitionType() == Dune::InteriorEntity)
+                localCost += cartesianCosts[cartesianIndex(elemMapper.index(elem))];
+        }
+
+        const auto& comm = gridView.comm();
+        double maxCost = comm.max(localCost);
+        double meanCost = comm.sum(localCost)/comm.size();
+        if (comm.rank() == 0)
+            std::cout << "Expected load imbalance according to the element cost profile: "
+                      << maxCost/meanCost << "\n" << std::flush;
+    }
+
 private:
     Implementation& asImp_()
     { return *static_cast<Implementation*>(this); }
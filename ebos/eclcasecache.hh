@@ -0,0 +1,467 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::EclCaseCache
+ */
+#ifndef EWOMS_ECL_CASE_CACHE_HH
+#define EWOMS_ECL_CASE_CACHE_HH
+
+#include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/Deck/DeckItem.hpp>
+#include <opm/parser/eclipse/Deck/DeckKeyword.hpp>
+#include <opm/parser/eclipse/Deck/DeckRecord.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/IOConfig/IOConfig.hpp>
+#include <opm/parser/eclipse/Utility/Typetools.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Ewoms {
+namespace Properties {
+NEW_PROP_TAG(Simulator);
+
+//! Store the static data of the case in a file and re-use it for subsequent runs
+NEW_PROP_TAG(EnableEclCaseCache);
+
+//! The directory of the case cache files. If empty, the output directory is used
+NEW_PROP_TAG(EclCaseCacheDirectory);
+}
+
+/*!
+ * \ingroup EclBlackOilSimulator
+ *
+ * \brief Stores the static data which ebos derives from the ECL deck in a binary file
+ *        which is re-used by later runs of the same case.
+ *
+ * The cache file is identified by a hash of the contents of all keywords of the deck
+ * and of the cells which are assigned to the process. Runs which use the same deck and
+ * the same number of processes thus find the file written by the first run, all other
+ * runs silently overwrite it. In the parallel case, each process uses its own file.
+ *
+ * The cache consists of named arrays of trivially copyable objects. When a valid cache
+ * file exists, it is mapped into memory by load() and the arrays can be copied out of
+ * it using read(). Else, the arrays are specified using add() and they are written to
+ * disk by store().
+ */
+template <class TypeTag>
+class EclCaseCache
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+    // this needs to be incremented whenever the layout of the file or the way how any
+    // of the cached quantities are computed changes
+    enum { formatVersion = 1 };
+
+    struct ArrayInfo_
+    {
+        const char* data;
+        uint64_t elementSize;
+        uint64_t numElements;
+    };
+
+    struct PendingArray_
+    {
+        std::string name;
+        uint64_t elementSize;
+        uint64_t numElements;
+        std::vector<char> data;
+    };
+
+public:
+    EclCaseCache(const Simulator& simulator)
+        : simulator_(simulator)
+        , key_(0)
+        , mappedData_(nullptr)
+        , mappedSize_(0)
+    { }
+
+    ~EclCaseCache()
+    { unload(); }
+
+    /*!
+     * \brief Register all run-time parameters for the case cache.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableEclCaseCache,
+                             "Store the transmissibilities, the porosities and the "
+                             "equilibrated initial condition in a file and re-use them "
+                             "if the same deck is simulated again");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, EclCaseCacheDirectory,
+                             "The directory of the case cache files. If empty, the "
+                             "output directory of the deck is used");
+    }
+
+    /*!
+     * \brief Returns true iff the case cache is enabled.
+     */
+    static bool enabled()
+    { return EWOMS_GET_PARAM(TypeTag, bool, EnableEclCaseCache); }
+
+    /*!
+     * \brief Compute the key of the case and map the cache file into memory if it
+     *        matches.
+     *
+     * \return true iff a valid cache file was found
+     */
+    bool load()
+    {
+        unload();
+        key_ = computeKey_();
+        fileName_ = cacheFileName_();
+
+        int fd = ::open(fileName_.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat fileStat;
+        if (::fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+
+        size_t size = static_cast<size_t>(fileStat.st_size);
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, /*offset=*/0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            return false;
+
+        mappedData_ = static_cast<const char*>(addr);
+        mappedSize_ = size;
+        if (!parse_()) {
+            std::cout << "Ignoring the invalid or outdated case cache '" << fileName_ << "'\n"
+                      << std::flush;
+            unload();
+            return false;
+        }
+
+        if (simulator_.gridView().comm().rank() == 0)
+            std::cout << "Using the case cache '" << fileName_ << "'\n" << std::flush;
+        return true;
+    }
+
+    /*!
+     * \brief Returns true iff the data of a cache file is available.
+     */
+    bool isLoaded() const
+    { return mappedData_ != nullptr; }
+
+    /*!
+     * \brief Unmap the cache file.
+     *
+     * The arrays copied out of the file by read() are not affected by this.
+     */
+    void unload()
+    {
+        if (mappedData_)
+            ::munmap(const_cast<char*>(mappedData_), mappedSize_);
+        mappedData_ = nullptr;
+        mappedSize_ = 0;
+        arrays_.clear();
+    }
+
+    /*!
+     * \brief Copy an array out of the cache file.
+     *
+     * \return false if no cache file was loaded or if it does not contain a suitable
+     *         array of the given name.
+     */
+    template <class T>
+    bool read(const std::string& name, std::vector<T>& values) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable objects can be cached");
+
+        auto it = arrays_.find(name);
+        if (it == arrays_.end() || it->second.elementSize != sizeof(T))
+            return false;
+
+        values.resize(it->second.numElements);
+        if (!values.empty())
+            std::memcpy(values.data(), it->second.data, values.size()*sizeof(T));
+        return true;
+    }
+
+    /*!
+     * \brief Specify an array which is to be written to the cache file by store().
+     */
+    template <class T>
+    void add(const std::string& name, const std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable objects can be cached");
+
+        pendingArrays_.emplace_back();
+        auto& array = pendingArrays_.back();
+        array.name = name;
+        array.elementSize = sizeof(T);
+        array.numElements = values.size();
+        array.data.resize(values.size()*sizeof(T));
+        if (!values.empty())
+            std::memcpy(array.data.data(), values.data(), array.data.size());
+    }
+
+    /*!
+     * \brief Write all arrays specified by add() to the cache file.
+     *
+     * The file is first written under a temporary name and then renamed, so concurrent
+     * runs of the same case never see an incomplete file. Failing to write the cache
+     * is not considered to be an error.
+     */
+    void store()
+    {
+        if (fileName_.empty())
+            fileName_ = cacheFileName_();
+
+        std::string tmpFileName = fileName_ + ".tmp";
+        {
+            std::ofstream os(tmpFileName.c_str(), std::ios::binary);
+            if (!os) {
+                std::cout << "Could not write the case cache '" << fileName_ << "'\n"
+                          << std::flush;
+                pendingArrays_.clear();
+                return;
+            }
+
+            os.write(magic_(), 8);
+            write_(os, static_cast<uint64_t>(formatVersion));
+            write_(os, key_);
+            write_(os, static_cast<uint64_t>(pendingArrays_.size()));
+            for (const auto& array : pendingArrays_) {
+                write_(os, static_cast<uint64_t>(array.name.size()));
+                os.write(array.name.data(), static_cast<std::streamsize>(array.name.size()));
+                writePadding_(os, array.name.size());
+                write_(os, array.elementSize);
+                write_(os, array.numElements);
+                os.write(array.data.data(), static_cast<std::streamsize>(array.data.size()));
+                writePadding_(os, array.data.size());
+            }
+
+            if (!os) {
+                os.close();
+                std::remove(tmpFileName.c_str());
+                pendingArrays_.clear();
+                return;
+            }
+        }
+
+        std::rename(tmpFileName.c_str(), fileName_.c_str());
+        pendingArrays_.clear();
+    }
+
+private:
+    static const char* magic_()
+    { return "EWOMSECC"; }
+
+    template <class T>
+    static void write_(std::ostream& os, T value)
+    { os.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    // all entries of the file are aligned to 8 bytes
+    static void writePadding_(std::ostream& os, size_t size)
+    {
+        static const char zeros[8] = { 0 };
+        os.write(zeros, static_cast<std::streamsize>((8 - size%8)%8));
+    }
+
+    static size_t padded_(size_t size)
+    { return (size + 7)/8*8; }
+
+    // read an unsigned integer from the mapped file. returns false if the end of the
+    // file was reached
+    bool readUInt_(size_t& pos, uint64_t& value) const
+    {
+        if (pos + sizeof(uint64_t) > mappedSize_)
+            return false;
+        std::memcpy(&value, mappedData_ + pos, sizeof(uint64_t));
+        pos += sizeof(uint64_t);
+        return true;
+    }
+
+    // check the header of the mapped file and build the table of arrays
+    bool parse_()
+    {
+        if (mappedSize_ < 8 || std::memcmp(mappedData_, magic_(), 8) != 0)
+            return false;
+
+        size_t pos = 8;
+        uint64_t version, key, numArrays;
+        if (!readUInt_(pos, version) || version != formatVersion)
+            return false;
+        if (!readUInt_(pos, key) || key != key_)
+            return false;
+        if (!readUInt_(pos, numArrays))
+            return false;
+
+        for (uint64_t arrayIdx = 0; arrayIdx < numArrays; ++arrayIdx) {
+            uint64_t nameSize;
+            if (!readUInt_(pos, nameSize) || pos + nameSize > mappedSize_)
+                return false;
+            std::string name(mappedData_ + pos, static_cast<size_t>(nameSize));
+            pos += padded_(static_cast<size_t>(nameSize));
+
+            ArrayInfo_ info;
+            if (!readUInt_(pos, info.elementSize) || !readUInt_(pos, info.numElements))
+                return false;
+            size_t dataSize = static_cast<size_t>(info.elementSize*info.numElements);
+            if (pos + dataSize > mappedSize_)
+                return false;
+            info.data = mappedData_ + pos;
+            pos += padded_(dataSize);
+
+            arrays_[name] = info;
+        }
+
+        return true;
+    }
+
+    std::string cacheFileName_() const
+    {
+        const auto& gridManager = simulator_.gridManager();
+        std::string dir = EWOMS_GET_PARAM(TypeTag, std::string, EclCaseCacheDirectory);
+        if (dir.empty())
+            dir = gridManager.eclState().getIOConfig().getOutputDir();
+
+        std::ostringstream oss;
+        oss << dir << "/" << gridManager.caseName();
+        const auto& comm = simulator_.gridView().comm();
+        if (comm.size() > 1)
+            oss << "-p" << comm.rank() << "of" << comm.size();
+        oss << ".ECC";
+        return oss.str();
+    }
+
+    // 64 bit FNV-1a
+    static void hash_(uint64_t& hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    template <class T>
+    static void hashValue_(uint64_t& hash, const T& value)
+    { hash_(hash, &value, sizeof(T)); }
+
+    static void hashString_(uint64_t& hash, const std::string& value)
+    {
+        hashValue_(hash, static_cast<uint64_t>(value.size()));
+        hash_(hash, value.data(), value.size());
+    }
+
+    // the key covers the contents of the deck and the cells of the process
+    uint64_t computeKey_() const
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        hashValue_(hash, static_cast<uint64_t>(formatVersion));
+
+        const auto& gridManager = simulator_.gridManager();
+        const auto& comm = simulator_.gridView().comm();
+        hashValue_(hash, comm.rank());
+        hashValue_(hash, comm.size());
+
+        unsigned numElements = static_cast<unsigned>(simulator_.gridView().size(/*codim=*/0));
+        hashValue_(hash, numElements);
+        for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+            hashValue_(hash, gridManager.cartesianIndex(elemIdx));
+
+        const auto& deck = gridManager.deck();
+        for (size_t keywordIdx = 0; keywordIdx < deck.size(); ++keywordIdx) {
+            const auto& keyword = deck.getKeyword(keywordIdx);
+            hashString_(hash, keyword.name());
+            hashValue_(hash, static_cast<uint64_t>(keyword.size()));
+            for (size_t recordIdx = 0; recordIdx < keyword.size(); ++recordIdx) {
+                const auto& record = keyword.getRecord(recordIdx);
+                hashValue_(hash, static_cast<uint64_t>(record.size()));
+                for (size_t itemIdx = 0; itemIdx < record.size(); ++itemIdx)
+                    hashItem_(hash, record.getItem(itemIdx));
+            }
+        }
+
+        return hash;
+    }
+
+    template <class DeckItem>
+    static void hashItem_(uint64_t& hash, const DeckItem& item)
+    {
+        hashValue_(hash, static_cast<uint64_t>(item.size()));
+        if (item.size() == 0)
+            return;
+
+        switch (item.getType()) {
+        case Opm::type_tag::integer: {
+            const auto& data = item.template getData<int>();
+            hash_(hash, data.data(), data.size()*sizeof(int));
+            break;
+        }
+        case Opm::type_tag::fdouble: {
+            const auto& data = item.template getData<double>();
+            hash_(hash, data.data(), data.size()*sizeof(double));
+            break;
+        }
+        case Opm::type_tag::string: {
+            for (const auto& value : item.template getData<std::string>())
+                hashString_(hash, value);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    const Simulator& simulator_;
+
+    uint64_t key_;
+    std::string fileName_;
+
+    const char* mappedData_;
+    size_t mappedSize_;
+    std::map<std::string, ArrayInfo_> arrays_;
+
+    std::vector<PendingArray_> pendingArrays_;
+};
+
+} // namespace Ewoms
+
+#endif
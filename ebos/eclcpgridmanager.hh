@@ -36,6 +36,12 @@
 
 #include <dune/common/version.hh>
 
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
 namespace Ewoms {
 template <class TypeTag>
 class EclCpGridManager;
@@ -138,52 +144,37 @@ public:
      */
     void loadBalance()
     {
-#if HAVE_MPI
-        int mpiRank = 0;
-        int mpiSize = 1;
-        MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
-        MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+        const auto& cartesianCosts = this->readElementCostProfile_();
 
-        if (mpiSize > 1) {
+#if HAVE_MPI
+        if (grid_->comm().size() > 1) {
             // the CpGrid's loadBalance() method likes to have the transmissibilities as
             // its edge weights. since this is (kind of) a layering violation and
             // transmissibilities are relatively expensive to compute, we only do it if
-            // more than a single process is involved in the simulation.
-            cartesianIndexMapper_ = new CartesianIndexMapper(*grid_);
-            globalTrans_ = new EclTransmissibility<TypeTag>(*this);
-            globalTrans_->update();
-
-            // convert to transmissibility for faces
+            // more than a single process is involved in the simulation. Also, the
+            // transmissibilities of the undistributed grid are only computed by the
+            // first rank and then broadcast: letting every rank compute all of them
+            // would make the startup time per rank proportional to the size of the
+            // global grid.
+            //
             // TODO: grid_->numFaces() is not generic. use grid_->size(1) instead? (might
             // not work)
-            const auto& gridView = grid_->leafGridView();
             unsigned numFaces = grid_->numFaces();
             std::vector<double> faceTrans(numFaces, 0.0);
-#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
-            ElementMapper elemMapper(this->gridView(), Dune::mcmgElementLayout());
-#else
-            ElementMapper elemMapper(this->gridView());
-#endif
-            auto elemIt = gridView.template begin</*codim=*/0>();
-            const auto& elemEndIt = gridView.template end</*codim=*/0>();
-            for (; elemIt != elemEndIt; ++ elemIt) {
-                const auto& elem = *elemIt;
-                auto isIt = gridView.ibegin(elem);
-                const auto& isEndIt = gridView.iend(elem);
-                for (; isIt != isEndIt; ++ isIt) {
-                    const auto& is = *isIt;
-                    if (!is.neighbor())
-                        continue;
-
-                    unsigned I = elemMapper.index(is.inside());
-                    unsigned J = elemMapper.index(is.outside());
-
-                    // FIXME (?): this is not portable!
-                    unsigned faceIdx = is.id();
-
-                    faceTrans[faceIdx] = globalTrans_->transmissibility(I, J);
-                }
+            if (grid_->comm().rank() == 0) {
+                cartesianIndexMapper_ = new CartesianIndexMapper(*grid_);
+                globalTrans_ = new EclTransmissibility<TypeTag>(*this);
+                globalTrans_->update();
+
+                computeFaceTransmissibilities_(faceTrans);
+
+                // CpGrid's partitioner does not accept weights for the cells, so the
+                // costs measured by a previous run are folded into the edge weights:
+                // this makes the partitioner avoid cutting through expensive regions
+                if (!cartesianCosts.empty())
+                    applyElementCosts_(faceTrans, cartesianCosts);
             }
+            grid_->comm().broadcast(faceTrans.data(), static_cast<int>(numFaces), /*root=*/0);
 
             //distribute the grid and switch to the distributed view.
             {
@@ -205,6 +196,11 @@ public:
         cartesianIndexMapper_ = new CartesianIndexMapper(*grid_);
 
         this->updateGridView_();
+
+        // since the costs only enter the edge weights, tell the user how well the
+        // grid is balanced
+        if (!cartesianCosts.empty())
+            this->reportExpectedImbalance_(cartesianCosts);
     }
 
     /*!
@@ -223,8 +219,22 @@ public:
     std::unordered_set<std::string> defunctWellNames() const
     { return defunctWellNames_; }
 
+    /*!
+     * \brief Returns the transmissibilities of the undistributed grid.
+     *
+     * This object is only available on the first rank of parallel runs with the
+     * ExportGlobalTransmissibility property set to true.
+     */
     const EclTransmissibility<TypeTag>& globalTransmissibility() const
-    { return *globalTrans_; }
+    {
+        if (!globalTrans_)
+            OPM_THROW(std::logic_error,
+                      "The transmissibilities of the undistributed grid are only "
+                      "available on the I/O rank of parallel runs which set the "
+                      "ExportGlobalTransmissibility property to true and before "
+                      "releaseGlobalTransmissibility() is called");
+        return *globalTrans_;
+    }
 
     void releaseGlobalTransmissibility()
     {
@@ -233,12 +243,79 @@ public:
     }
 
 protected:
+    // convert the transmissibilities of the undistributed grid to the ones of its faces
+    void computeFaceTransmissibilities_(std::vector<double>& faceTrans) const
+    {
+        const auto& gridView = grid_->leafGridView();
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+        ElementMapper elemMapper(this->gridView(), Dune::mcmgElementLayout());
+#else
+        ElementMapper elemMapper(this->gridView());
+#endif
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++ elemIt) {
+            const auto& elem = *elemIt;
+            auto isIt = gridView.ibegin(elem);
+            const auto& isEndIt = gridView.iend(elem);
+            for (; isIt != isEndIt; ++ isIt) {
+                const auto& is = *isIt;
+                if (!is.neighbor())
+                    continue;
+
+                unsigned I = elemMapper.index(is.inside());
+                unsigned J = elemMapper.index(is.outside());
+
+                // FIXME (?): this is not portable!
+                unsigned faceIdx = is.id();
+
+                faceTrans[faceIdx] = globalTrans_->transmissibility(I, J);
+            }
+        }
+    }
+
+    // scale the weight of each face of the undistributed grid by the mean of the costs
+    // of the two adjacent cells
+    void applyElementCosts_(std::vector<double>& faceWeights,
+                            const std::vector<double>& cartesianCosts) const
+    {
+        const auto& gridView = grid_->leafGridView();
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+        ElementMapper elemMapper(this->gridView(), Dune::mcmgElementLayout());
+#else
+        ElementMapper elemMapper(this->gridView());
+#endif
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++ elemIt) {
+            const auto& elem = *elemIt;
+            unsigned I = elemMapper.index(elem);
+            double costI = cartesianCosts[cartesianIndexMapper_->cartesianIndex(I)];
+
+            auto isIt = gridView.ibegin(elem);
+            const auto& isEndIt = gridView.iend(elem);
+            for (; isIt != isEndIt; ++ isIt) {
+                const auto& is = *isIt;
+                if (!is.neighbor())
+                    continue;
+
+                // each face is visited from both sides; only scale it once
+                unsigned J = elemMapper.index(is.outside());
+                if (J < I)
+                    continue;
+
+                double costJ = cartesianCosts[cartesianIndexMapper_->cartesianIndex(J)];
+                faceWeights[is.id()] *= 0.5*(costI + costJ);
+            }
+        }
+    }
+
     void createGrids_()
     {
         const auto& gridProps = this->eclState().get3DProperties();
         const std::vector<double>& porv = gridProps.getDoubleGridProperty("PORV").getData();
 
-        grid_ = new Dune::CpGrid();
+        grid_ = new Dune::CpGrid(this->communicator_());
         grid_->processEclipseFormat(this->eclState().getInputGrid(),
                                     /*isPeriodic=*/false,
                                     /*flipNormals=*/false,
@@ -254,6 +331,7 @@ protected:
         equilGrid_ = new Dune::CpGrid(*grid_);
         equilCartesianIndexMapper_ = new CartesianIndexMapper(*equilGrid_);
 
+        cartesianIndexMapper_ = nullptr;
         globalTrans_ = nullptr;
     }
 
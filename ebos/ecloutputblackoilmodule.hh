@@ -40,6 +40,7 @@
 
 #include <dune/common/fvector.hh>
 
+#include <mutex>
 #include <type_traits>
 
 namespace Ewoms {
@@ -242,6 +243,11 @@ public:
     /*!
      * \brief Modify the internal buffers according to the intensive quanties relevant
      *        for an element
+     *
+     * This method may be called concurrently for different elements: Each element only
+     * writes to its own entries of the per-cell buffers and the lists of the cells for
+     * which the bubble or dew point pressures could not be determined are protected by
+     * a mutex.
      */
     void processElement(const ElementContext& elemCtx)
     {
@@ -360,6 +366,7 @@ public:
                 }
                 catch (const Opm::NumericalProblem& e) {
                     const auto globalIdx = elemCtx.simulator().gridManager().grid().globalCell()[globalDofIdx];
+                    std::lock_guard<std::mutex> lock(failedCellsMutex_);
                     failedCellsPb_.push_back(globalIdx);
                 }
             }
@@ -370,6 +377,7 @@ public:
                 }
                 catch (const Opm::NumericalProblem& e) {
                     const auto globalIdx = elemCtx.simulator().gridManager().grid().globalCell()[globalDofIdx];
+                    std::lock_guard<std::mutex> lock(failedCellsMutex_);
                     failedCellsPd_.push_back(globalIdx);
                 }
             }
@@ -794,6 +802,7 @@ private:
     ScalarBuffer dewPointPressure_;
     std::vector<int> failedCellsPb_;
     std::vector<int> failedCellsPd_;
+    std::mutex failedCellsMutex_;
 
 };
 } // namespace Ewoms
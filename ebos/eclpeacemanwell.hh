@@ -44,6 +44,9 @@
 #include <dune/common/version.hh>
 #include <dune/geometry/referenceelements.hh>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <map>
 
 namespace Ewoms {
@@ -1037,6 +1040,40 @@ public:
     void endIteration()
     { ++ iterationIdx_; }
 
+    /*!
+     * \copydoc BaseAuxiliaryModule::saveTimeStepSnapshot
+     */
+    virtual void saveTimeStepSnapshot()
+    {
+        snapshot_.iterationIdx = iterationIdx_;
+        snapshot_.actualBottomHolePressure = actualBottomHolePressure_;
+        snapshot_.actualWeightedSurfaceRate = actualWeightedSurfaceRate_;
+        snapshot_.actualSurfaceRates = actualSurfaceRates_;
+        snapshot_.actualWeightedResvRate = actualWeightedResvRate_;
+        snapshot_.actualResvRates = actualResvRates_;
+
+        // the DOF variables are copied element-wise so that the pointers in
+        // dofVariables_ stay valid. after the first time step, this does not allocate
+        // any memory anymore
+        snapshot_.dofVars = dofVarsStore_;
+    }
+
+    /*!
+     * \copydoc BaseAuxiliaryModule::restoreTimeStepSnapshot
+     */
+    virtual void restoreTimeStepSnapshot()
+    {
+        iterationIdx_ = snapshot_.iterationIdx;
+        actualBottomHolePressure_ = snapshot_.actualBottomHolePressure;
+        actualWeightedSurfaceRate_ = snapshot_.actualWeightedSurfaceRate;
+        actualSurfaceRates_ = snapshot_.actualSurfaceRates;
+        actualWeightedResvRate_ = snapshot_.actualWeightedResvRate;
+        actualResvRates_ = snapshot_.actualResvRates;
+
+        assert(snapshot_.dofVars.size() == dofVarsStore_.size());
+        std::copy(snapshot_.dofVars.begin(), snapshot_.dofVars.end(), dofVarsStore_.begin());
+    }
+
     /*!
      * \brief Called by the simulator after each time step.
      */
@@ -1545,6 +1582,19 @@ protected:
     std::vector<DofVariables, Ewoms::aligned_allocator<DofVariables, alignof(DofVariables)> > dofVarsStore_;
     std::map<int, DofVariables*> dofVariables_;
 
+    // the state of the well at the beginning of the current time step. this is used to
+    // retry a time step if the non-linear solver failed.
+    struct TimeStepSnapshot {
+        unsigned iterationIdx;
+        Scalar actualBottomHolePressure;
+        Scalar actualWeightedSurfaceRate;
+        std::array<Scalar, numPhases> actualSurfaceRates;
+        Scalar actualWeightedResvRate;
+        std::array<Scalar, numPhases> actualResvRates;
+        std::vector<DofVariables, Ewoms::aligned_allocator<DofVariables, alignof(DofVariables)> > dofVars;
+    };
+    TimeStepSnapshot snapshot_;
+
     // the number of times beginIteration*() was called for the current time step
     unsigned iterationIdx_;
 
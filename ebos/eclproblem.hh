@@ -54,6 +54,8 @@
 #include "eclwellmanager.hh"
 #include "eclequilinitializer.hh"
 #include "eclwriter.hh"
+#include "eclregionoutput.hh"
+#include "eclcasecache.hh"
 #include "ecloutputblackoilmodule.hh"
 #include "ecltransmissibility.hh"
 #include "eclthresholdpressure.hh"
@@ -113,6 +115,10 @@ NEW_PROP_TAG(EnableWriteAllSolutions);
 // The number of time steps skipped between writing two consequtive restart files
 NEW_PROP_TAG(RestartWritingInterval);
 
+// Only write the output fields for every n-th report step (or for every n-th time step
+// if EnableWriteAllSolutions is true)
+NEW_PROP_TAG(OutputInterval);
+
 // Disable well treatment (for users which do this externally)
 NEW_PROP_TAG(DisableWells);
 
@@ -169,6 +175,19 @@ SET_BOOL_PROP(EclBaseProblem, EnableGravity, true);
 // only write the solutions for the report steps to disk
 SET_BOOL_PROP(EclBaseProblem, EnableWriteAllSolutions, false);
 
+// write the output fields for each report step
+SET_INT_PROP(EclBaseProblem, OutputInterval, 1);
+
+// the region output is disabled by default. if it is enabled, the regions are given by
+// the FIPNUM keyword
+SET_BOOL_PROP(EclBaseProblem, EnableRegionOutput, false);
+SET_STRING_PROP(EclBaseProblem, RegionOutputKeyword, "FIPNUM");
+
+// the case cache is disabled by default. if it is enabled, its files are written to the
+// output directory
+SET_BOOL_PROP(EclBaseProblem, EnableEclCaseCache, false);
+SET_STRING_PROP(EclBaseProblem, EclCaseCacheDirectory, "");
+
 // The default for the end time of the simulation [s]
 //
 // By default, stop it after the universe will probably have stopped
@@ -207,6 +226,14 @@ SET_BOOL_PROP(EclBaseProblem, EnableVtkOutput, false);
 // ... but enable the ECL output by default
 SET_BOOL_PROP(EclBaseProblem, EnableEclOutput, true);
 
+// write the ECL output in the simulation thread by default. if the asynchronous output is
+// enabled, at most two report steps are buffered
+SET_BOOL_PROP(EclBaseProblem, EnableAsyncEclOutput, false);
+SET_INT_PROP(EclBaseProblem, MaxPendingEclOutputs, 2);
+
+// gather all ECL output fields on the I/O rank using a single message per process
+SET_INT_PROP(EclBaseProblem, EclOutputGatherBatchSize, 0);
+
 // the cache for intensive quantities can be used for ECL problems and also yields a
 // decent speedup...
 SET_BOOL_PROP(EclBaseProblem, EnableIntensiveQuantityCache, true);
@@ -277,6 +304,7 @@ class EclProblem : public GET_PROP_TYPE(TypeTag, BaseProblem)
     typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
     typedef typename GET_PROP(TypeTag, MaterialLaw)::EclMaterialLawManager EclMaterialLawManager;
     typedef typename GET_PROP_TYPE(TypeTag, DofMapper) DofMapper;
+    typedef typename GET_PROP_TYPE(TypeTag, GridCommHandleFactory) GridCommHandleFactory;
     typedef typename GET_PROP_TYPE(TypeTag, MaterialLaw) MaterialLaw;
     typedef typename GET_PROP_TYPE(TypeTag, MaterialLawParams) MaterialLawParams;
     typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
@@ -294,6 +322,8 @@ class EclProblem : public GET_PROP_TYPE(TypeTag, BaseProblem)
     typedef Dune::FieldMatrix<Scalar, dimWorld, dimWorld> DimMatrix;
 
     typedef EclWriter<TypeTag> EclWriterType;
+    typedef EclRegionOutput<TypeTag> EclRegionOutputType;
+    typedef EclCaseCache<TypeTag> EclCaseCacheType;
 
     typedef typename GridView::template Codim<0>::Iterator ElementIterator;
 
@@ -319,6 +349,15 @@ public:
                              "Eclipse simulator");
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, RestartWritingInterval,
                              "The frequencies of which time steps are serialized to disk");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, OutputInterval,
+                             "Write the restart and VTK fields only for every n-th report "
+                             "step (or time step if all solutions are written). 0 means that "
+                             "only the initial and the final solutions are written. The "
+                             "summary is written for every report step regardless");
+
+        EclWriterType::registerParameters();
+        EclRegionOutputType::registerParameters();
+        EclCaseCacheType::registerParameters();
     }
 
     /*!
@@ -331,6 +370,8 @@ public:
         , wellManager_(simulator)
         , eclWriter_( EWOMS_GET_PARAM(TypeTag, bool, EnableEclOutput)
                         ? new EclWriterType(simulator) : nullptr )
+        , regionOutput_( EclRegionOutputType::enabled()
+                         ? new EclRegionOutputType(simulator) : nullptr )
         , pffDofData_(simulator.gridView(), this->elementMapper())
     {
         // Tell the extra modules to initialize its internal data structures
@@ -407,10 +448,25 @@ public:
         initFluidSystem_();
         updateElementDepths_();
         readRockParameters_();
+
+        // the static data of the case is taken from the case cache if it was written
+        // by a previous run. the cache is only required during the initialization.
+        if (EclCaseCacheType::enabled()) {
+            caseCache_.reset(new EclCaseCacheType(simulator));
+            caseCache_->load();
+        }
+
         readMaterialParameters_();
-        transmissibilities_.finishInit();
+        if (!caseCache_ || !transmissibilities_.readFromCache(*caseCache_))
+            transmissibilities_.finishInit();
         readInitialCondition_();
 
+        if (caseCache_) {
+            if (!caseCache_->isLoaded())
+                storeCaseCache_();
+            caseCache_.reset();
+        }
+
         // Set the start time of the simulation
         const auto& timeMap = simulator.gridManager().schedule().getTimeMap();
         simulator.setStartTime( timeMap.getStartTime(/*timeStepIdx=*/0) );
@@ -431,6 +487,9 @@ public:
             int numElements = gridView.size(/*codim=*/0);
             maxPolymerAdsorption_.resize(numElements, 0.0);
         }
+
+        if (regionOutput_)
+            regionOutput_->finishInit();
     }
 
     void prefetch(const Element& elem) const
@@ -489,6 +548,12 @@ public:
             // has changed, the grid may need be re-created which has some serious
             // implications on e.g., the solution of the simulation.)
             const auto& miniDeck = schedule.getModifierDeck(nextEpisodeIdx);
+
+            // the asynchronous ECL writer accesses the EclipseState while it writes
+            // the pending report steps, so these must be written before the state is
+            // modified
+            if (eclWriter_)
+                eclWriter_->waitForPendingWrites();
             eclState.applyModifierDeck(miniDeck);
 
             // re-compute all quantities which may possibly be affected.
@@ -528,6 +593,8 @@ public:
         if (GET_PROP_VALUE(TypeTag, EnablePolymer))
             updateMaxPolymerAdsorption_();
 
+        syncMaximumQuantities_();
+
         if (!GET_PROP_VALUE(TypeTag, DisableWells))
             // set up the wells
             wellManager_.beginEpisode(this->simulator().gridManager().eclState(),
@@ -542,19 +609,30 @@ public:
      */
     void beginTimeStep()
     {
-        if (drsdtActive_)
-            // DRSDT is enabled
-            maxDRs_ = maxDRsDt_*this->simulator().timeStepSize();
-
-        if (drvdtActive_)
-            // DRVDT is enabled
-            maxDRv_ = maxDRvDt_*this->simulator().timeStepSize();
+        updateMaxCompositionChanges_();
 
         if (!GET_PROP_VALUE(TypeTag, DisableWells)) {
             wellManager_.beginTimeStep();
         }
     }
 
+    /*!
+     * \copydoc FvBaseProblem::restoreTimeStepSnapshot
+     */
+    void restoreTimeStepSnapshot()
+    {
+        ParentType::restoreTimeStepSnapshot();
+
+        // the state of the wells is part of the model's snapshot. the other history
+        // dependent quantities are not modified between taking the snapshot and
+        // restoring it: lastRs_ and lastRv_ are only updated at the end of a
+        // successful time step, and maxOilSaturation_ as well as the hysteresis
+        // parameters are updated by beginEpisode(), i.e., before the snapshot of the
+        // first time step of the episode is taken. what needs to be adapted, though,
+        // are the limits which depend on the size of the time step.
+        updateMaxCompositionChanges_();
+    }
+
     /*!
      * \brief Called by the simulator before each Newton-Raphson iteration.
      */
@@ -597,6 +675,11 @@ public:
             initialFluidStates_.clear();
 
         updateCompositionChangeLimits_();
+
+        // the aggregated quantities of the regions are written for every time step,
+        // independently of the output fields
+        if (regionOutput_)
+            regionOutput_->writeTimeStep();
     }
 
     /*!
@@ -609,6 +692,11 @@ public:
 
         int episodeIdx = simulator.episodeIndex();
 
+        // update the profile of the computational costs of the cells. this is done at
+        // every report step so that a usable profile exists even if the run is aborted.
+        simulator.gridManager().writeElementCostProfile(simulator.model().linearizer().elementCosts(),
+                                                        this->elementMapper());
+
         const auto& timeMap = schedule.getTimeMap();
         int numReportSteps = timeMap.size() - 1;
         if (episodeIdx + 1 >= numReportSteps) {
@@ -622,7 +710,9 @@ public:
      *        to disk for visualization.
      *
      * For the ECL simulator we only write at the end of
-     * episodes/report steps...
+     * episodes/report steps... The summary is written for each of
+     * these, whereas the output fields are thinned out by the
+     * OutputInterval parameter (see writeOutputFields_()).
      */
     bool shouldWriteOutput() const
     {
@@ -679,13 +769,17 @@ public:
 
     void writeOutput(const Opm::data::Wells& dw, Scalar t, bool substep, Scalar totalSolverTime, Scalar nextstep, const Opm::data::Solution& fip, bool verbose = true)
     {
+        bool writeFields = writeOutputFields_();
+
         // use the generic code to prepare the output fields and to
         // write the desired VTK files.
-        ParentType::writeOutput(verbose);
+        if (writeFields)
+            ParentType::writeOutput(verbose);
 
-        // output using eclWriter if enabled
+        // output using eclWriter if enabled. if the output fields are skipped, the
+        // solution is passed as a substep, i.e., only the summary is written
         if ( eclWriter_ ) {
-            eclWriter_->writeOutput(dw, t, substep, totalSolverTime, nextstep, fip);
+            eclWriter_->writeOutput(dw, t, substep || !writeFields, totalSolverTime, nextstep, fip);
         }
 
     }
@@ -1147,6 +1241,32 @@ public:
     {return eclWriter_->eclIO();}
 
 private:
+    // returns true if the restart and VTK fields are written for the current
+    // solution. The OutputInterval parameter counts the report steps, or the time
+    // steps if all solutions are written. The initial solution and the one at the end
+    // of the simulation are always written.
+    bool writeOutputFields_() const
+    {
+        const auto& simulator = this->simulator();
+        if (simulator.timeStepIndex() < 0)
+            return true;
+
+        if (simulator.willBeFinished())
+            return true;
+
+        unsigned n = EWOMS_GET_PARAM(TypeTag, unsigned, OutputInterval);
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableWriteAllSolutions))
+            return n > 0 && ((simulator.timeStepIndex() + 1) % n) == 0;
+
+        const auto& timeMap = simulator.gridManager().schedule().getTimeMap();
+        int numReportSteps = timeMap.size() - 1;
+        int reportStepIdx = simulator.episodeIndex() + 1;
+        if (reportStepIdx >= numReportSteps)
+            return true;
+
+        return n > 0 && (reportStepIdx % n) == 0;
+    }
+
     Scalar cellCenterDepth( const Element& element ) const
     {
         typedef typename Element :: Geometry Geometry;
@@ -1182,6 +1302,19 @@ private:
         }
     }
 
+    // update the maximum changes of the dissolution factors allowed by DRSDT and DRVDT
+    // for the current time step size
+    void updateMaxCompositionChanges_()
+    {
+        if (drsdtActive_)
+            // DRSDT is enabled
+            maxDRs_ = maxDRsDt_*this->simulator().timeStepSize();
+
+        if (drvdtActive_)
+            // DRVDT is enabled
+            maxDRv_ = maxDRvDt_*this->simulator().timeStepSize();
+    }
+
     // update the parameters needed for DRSDT and DRVDT
     void updateCompositionChangeLimits_()
     {
@@ -1254,6 +1387,11 @@ private:
             for (; elemIt != elemEndIt; ++elemIt) {
                 const Element& elem = *elemIt;
 
+                // the values of the ghost elements are taken from their master
+                // processes by syncMaximumQuantities_()
+                if (elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
                 elemCtx.updatePrimaryStencil(elem);
                 elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
 
@@ -1350,7 +1488,8 @@ private:
 
         ////////////////////////////////
         // porosity
-        updatePorosity_();
+        if (!caseCache_ || !caseCache_->read("porosity", porosity_))
+            updatePorosity_();
         ////////////////////////////////
 
         ////////////////////////////////
@@ -1434,7 +1573,7 @@ private:
         const auto& deck = gridManager.deck();
         if (!deck.hasKeyword("EQUIL"))
             readExplicitInitialCondition_();
-        else
+        else if (!caseCache_ || !readCachedEquilInitialCondition_())
             readEquilInitialCondition_();
 
         readBlackoilExtentionsInitialConditions_();
@@ -1461,6 +1600,60 @@ private:
         }
     }
 
+    // the quantities of the initial fluid states which are stored by the case cache
+    enum { numCachedFluidStateValues = 3 + 2*numPhases };
+
+    bool readCachedEquilInitialCondition_()
+    {
+        std::vector<Scalar> values;
+        size_t numElems = this->model().numGridDof();
+        if (!caseCache_->read("equilInitialCondition", values)
+            || values.size() != numElems*numCachedFluidStateValues)
+            return false;
+
+        useMassConservativeInitialCondition_ = false;
+
+        initialFluidStates_.resize(numElems);
+        auto valueIt = values.begin();
+        for (size_t elemIdx = 0; elemIdx < numElems; ++elemIdx) {
+            auto& elemFluidState = initialFluidStates_[elemIdx];
+            elemFluidState.setPvtRegionIndex(pvtRegionIndex(elemIdx));
+            elemFluidState.setTemperature(*valueIt++);
+            elemFluidState.setRs(*valueIt++);
+            elemFluidState.setRv(*valueIt++);
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                elemFluidState.setPressure(phaseIdx, *valueIt++);
+                elemFluidState.setSaturation(phaseIdx, *valueIt++);
+            }
+        }
+
+        return true;
+    }
+
+    void storeCaseCache_()
+    {
+        caseCache_->add("porosity", porosity_);
+        transmissibilities_.addToCache(*caseCache_);
+
+        const auto& deck = this->simulator().gridManager().deck();
+        if (deck.hasKeyword("EQUIL")) {
+            std::vector<Scalar> values;
+            values.reserve(initialFluidStates_.size()*numCachedFluidStateValues);
+            for (const auto& elemFluidState : initialFluidStates_) {
+                values.push_back(elemFluidState.temperature(/*phaseIdx=*/0));
+                values.push_back(elemFluidState.Rs());
+                values.push_back(elemFluidState.Rv());
+                for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                    values.push_back(elemFluidState.pressure(phaseIdx));
+                    values.push_back(elemFluidState.saturation(phaseIdx));
+                }
+            }
+            caseCache_->add("equilInitialCondition", values);
+        }
+
+        caseCache_->store();
+    }
+
     void readEclRestartSolution_()
     {
         // since the EquilInitializer provides fluid states that are consistent with the
@@ -1681,13 +1874,16 @@ private:
 
     void updateMaxPolymerAdsorption_()
     {
-        // we need to update the max polymer adsoption data for all elements
+        // we need to update the max polymer adsoption data for all interior elements.
+        // the ones of the ghost elements are set by syncMaximumQuantities_()
         ElementContext elemCtx(this->simulator());
         const auto& gridManager = this->simulator().gridManager();
         auto elemIt = gridManager.gridView().template begin</*codim=*/0>();
         const auto& elemEndIt = gridManager.gridView().template end</*codim=*/0>();
         for (; elemIt != elemEndIt; ++elemIt) {
             const Element& elem = *elemIt;
+            if (elem.partitionType() != Dune::InteriorEntity)
+                continue;
 
             elemCtx.updatePrimaryStencil(elem);
             elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
@@ -1699,6 +1895,28 @@ private:
         }
     }
 
+    // copy the maximum oil saturations and polymer adsorptions of the ghost elements
+    // from their master processes. all quantities are sent using a single message per
+    // neighboring process.
+    void syncMaximumQuantities_()
+    {
+        const auto& gridView = this->simulator().gridView();
+        if (gridView.comm().size() == 1)
+            return;
+
+        auto batchHandle =
+            GridCommHandleFactory::template batchHandle<Scalar>(this->model().dofMapper());
+        if (vapparsActive_)
+            batchHandle->addGhostSync(maxOilSaturation_);
+        if (GET_PROP_VALUE(TypeTag, EnablePolymer))
+            batchHandle->addGhostSync(maxPolymerAdsorption_);
+
+        if (!batchHandle->empty())
+            gridView.communicate(*batchHandle,
+                                 Dune::InteriorBorder_All_Interface,
+                                 Dune::ForwardCommunication);
+    }
+
     void updatePvtnum_()
     {
         const auto& eclState = this->simulator().gridManager().eclState();
@@ -1843,6 +2061,8 @@ private:
     EclWellManager<TypeTag> wellManager_;
 
     std::unique_ptr< EclWriterType > eclWriter_;
+    std::unique_ptr< EclRegionOutputType > regionOutput_;
+    std::unique_ptr< EclCaseCacheType > caseCache_;
 
     PffGridVector<GridView, Stencil, PffDofData_, DofMapper> pffDofData_;
 
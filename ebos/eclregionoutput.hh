@@ -0,0 +1,366 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::EclRegionOutput
+ */
+#ifndef EWOMS_ECL_REGION_OUTPUT_HH
+#define EWOMS_ECL_REGION_OUTPUT_HH
+
+#include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+#include <ewoms/parallel/threadedentityiterator.hh>
+#include <ewoms/parallel/threadmanager.hh>
+
+#include <opm/material/densead/Math.hpp>
+
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/Grid/GridProperty.hpp>
+#include <opm/parser/eclipse/EclipseState/IOConfig/IOConfig.hpp>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/grid/common/gridenums.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+namespace Properties {
+NEW_PROP_TAG(Simulator);
+NEW_PROP_TAG(Scalar);
+NEW_PROP_TAG(Evaluation);
+NEW_PROP_TAG(ElementContext);
+NEW_PROP_TAG(FluidSystem);
+NEW_PROP_TAG(GridView);
+
+//! Write aggregated quantities for the regions of the grid after each time step
+NEW_PROP_TAG(EnableRegionOutput);
+
+//! The name of the integer grid property which defines the regions
+NEW_PROP_TAG(RegionOutputKeyword);
+}
+
+/*!
+ * \ingroup EclBlackOilSimulator
+ *
+ * \brief Writes a time series of quantities which are aggregated over the regions of
+ *        the grid.
+ *
+ * The regions are specified by an integer grid property of the deck (FIPNUM by
+ * default). After each time step, the pore volume, the pore volume weighted average of
+ * the oil pressure, the reservoir volume of each phase and the net volumetric rate of
+ * each phase which leaves the region through its boundary to other regions are written
+ * to a file named '$CASENAME.RGN' in the output directory of the deck. Each line of the
+ * file corresponds to a time step and a region.
+ *
+ * This allows to write the full output fields only rarely, e.g., for long history
+ * matching runs.
+ */
+template <class TypeTag>
+class EclRegionOutput
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
+    typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GridView::template Codim<0>::Entity Element;
+    typedef typename GridView::template Codim<0>::Iterator ElementIterator;
+    typedef Opm::MathToolbox<Evaluation> Toolbox;
+
+    enum { numPhases = FluidSystem::numPhases };
+    enum { oilPhaseIdx = FluidSystem::oilPhaseIdx };
+
+    // the layout of the quantities of a region in the buffers
+    enum {
+        porvIdx = 0,
+        pvPressureIdx = 1,
+        inPlaceOffset = 2,
+        outflowOffset = inPlaceOffset + numPhases,
+        numQuantities = outflowOffset + numPhases
+    };
+
+public:
+    EclRegionOutput(const Simulator& simulator)
+        : simulator_(simulator)
+        , numRegions_(0)
+    { }
+
+    /*!
+     * \brief Register all run-time parameters for the region output.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableRegionOutput,
+                             "Write quantities aggregated over the regions of the grid "
+                             "after each time step");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, RegionOutputKeyword,
+                             "The name of the integer grid property of the deck which "
+                             "specifies the regions for the aggregated output");
+    }
+
+    /*!
+     * \brief Returns true iff the region output is enabled.
+     */
+    static bool enabled()
+    { return EWOMS_GET_PARAM(TypeTag, bool, EnableRegionOutput); }
+
+    /*!
+     * \brief Set up the region map and allocate all buffers.
+     */
+    void finishInit()
+    {
+        const auto& gridManager = simulator_.gridManager();
+        const auto& gridView = gridManager.gridView();
+        const auto& eclState = gridManager.eclState();
+        const auto& eclProps = eclState.get3DProperties();
+        const std::string& keyword = EWOMS_GET_PARAM(TypeTag, std::string, RegionOutputKeyword);
+
+        // this code assumes that the DOFs are the elements, i.e., an ECFV spatial
+        // discretization.
+        unsigned numElements = gridView.size(/*codim=*/0);
+        assert(simulator_.model().numGridDof() == numElements);
+
+        // if the deck does not specify the keyword, the whole grid is a single region
+        elemRegion_.resize(numElements, 0);
+        if (eclProps.hasDeckIntGridProperty(keyword)) {
+            const auto& regionData = eclProps.getIntGridProperty(keyword).getData();
+            for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+                unsigned cartElemIdx = gridManager.cartesianIndex(elemIdx);
+                int regionIdx = regionData[cartElemIdx] - 1;
+                if (regionIdx < 0)
+                    OPM_THROW(std::runtime_error,
+                              "Invalid region index " << regionIdx + 1 << " for grid property "
+                              << keyword << " in cell " << cartElemIdx);
+                elemRegion_[elemIdx] = static_cast<unsigned>(regionIdx);
+            }
+        }
+        else if (keyword != "FIPNUM")
+            OPM_THROW(std::runtime_error,
+                      "The deck does not specify the grid property " << keyword
+                      << " which is required for the region output");
+
+        unsigned maxRegionIdx = 0;
+        for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx)
+            maxRegionIdx = std::max(maxRegionIdx, elemRegion_[elemIdx]);
+        numRegions_ = gridView.comm().max(maxRegionIdx) + 1;
+
+        // mark the elements which exhibit a face to an element of a different region.
+        // only for these, the fluxes need to be calculated.
+        const auto& elementMapper = simulator_.model().elementMapper();
+        isRegionBoundary_.resize(numElements, 0);
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            if (elem.partitionType() != Dune::InteriorEntity)
+                continue;
+
+            unsigned elemIdx = elementMapper.index(elem);
+            auto isIt = gridView.ibegin(elem);
+            const auto& isEndIt = gridView.iend(elem);
+            for (; isIt != isEndIt; ++ isIt) {
+                const auto& intersection = *isIt;
+                if (!intersection.neighbor())
+                    continue;
+
+                unsigned outsideElemIdx = elementMapper.index(intersection.outside());
+                if (elemRegion_[outsideElemIdx] != elemRegion_[elemIdx]) {
+                    isRegionBoundary_[elemIdx] = 1;
+                    break;
+                }
+            }
+        }
+
+        // allocate the buffers. these are re-used for every time step
+        regionData_.resize(numRegions_*numQuantities);
+        threadRegionData_.resize(ThreadManager::maxThreads());
+        for (auto& threadData : threadRegionData_)
+            threadData.resize(numRegions_*numQuantities);
+
+        if (gridView.comm().rank() == 0) {
+            const auto& ioConfig = eclState.getIOConfig();
+            std::string fileName = ioConfig.getOutputDir() + "/" + gridManager.caseName() + ".RGN";
+            outStream_.open(fileName);
+            if (!outStream_)
+                OPM_THROW(std::runtime_error,
+                          "Could not open file '" << fileName << "' for the region output");
+
+            outStream_ << "# regions defined by " << keyword << "\n"
+                       << "# time [s], region, pore volume [m^3], average oil pressure [Pa]";
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                if (FluidSystem::phaseIsActive(phaseIdx))
+                    outStream_ << ", " << FluidSystem::phaseName(phaseIdx) << " in place [m^3]";
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                if (FluidSystem::phaseIsActive(phaseIdx))
+                    outStream_ << ", " << FluidSystem::phaseName(phaseIdx) << " outflow [m^3/s]";
+            outStream_ << "\n";
+            outStream_ << std::scientific << std::setprecision(10);
+        }
+    }
+
+    /*!
+     * \brief Aggregate the quantities of the current solution over the regions and
+     *        append them to the output file.
+     *
+     * This method must be called on all processes.
+     */
+    void writeTimeStep()
+    {
+        aggregate_();
+
+        if (simulator_.gridView().comm().rank() != 0)
+            return;
+
+        Scalar t = simulator_.time() + simulator_.timeStepSize();
+        for (unsigned regionIdx = 0; regionIdx < numRegions_; ++regionIdx) {
+            const Scalar* data = &regionData_[regionIdx*numQuantities];
+            Scalar pressure = (data[porvIdx] > 0.0) ? data[pvPressureIdx]/data[porvIdx] : 0.0;
+
+            outStream_ << t << " " << regionIdx + 1 << " " << data[porvIdx] << " " << pressure;
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                if (FluidSystem::phaseIsActive(phaseIdx))
+                    outStream_ << " " << data[inPlaceOffset + phaseIdx];
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                if (FluidSystem::phaseIsActive(phaseIdx))
+                    outStream_ << " " << data[outflowOffset + phaseIdx];
+            outStream_ << "\n";
+        }
+        outStream_.flush();
+    }
+
+    /*!
+     * \brief Returns the number of regions.
+     */
+    unsigned numRegions() const
+    { return numRegions_; }
+
+    /*!
+     * \brief Returns the index of the region of a given element.
+     */
+    unsigned elementRegion(unsigned elemIdx) const
+    { return elemRegion_[elemIdx]; }
+
+private:
+    void aggregate_()
+    {
+        for (auto& threadData : threadRegionData_)
+            std::fill(threadData.begin(), threadData.end(), 0.0);
+
+        const auto& gridView = simulator_.gridView();
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            ElementContext elemCtx(simulator_);
+            std::vector<Scalar>& threadData = threadRegionData_[ThreadManager::threadId()];
+
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element& elem = *elemIt;
+                if (elem.partitionType() != Dune::InteriorEntity)
+                    continue;
+
+                elemCtx.updatePrimaryStencil(elem);
+                unsigned elemIdx = elemCtx.globalSpaceIndex(/*dofIdx=*/0, /*timeIdx=*/0);
+                bool isRegionBoundary = isRegionBoundary_[elemIdx];
+                if (isRegionBoundary) {
+                    elemCtx.updateStencil(elem);
+                    elemCtx.updateAllIntensiveQuantities();
+                    elemCtx.updateAllExtensiveQuantities();
+                }
+                else
+                    elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+
+                Scalar* data = &threadData[elemRegion_[elemIdx]*numQuantities];
+
+                const auto& intQuants = elemCtx.intensiveQuantities(/*dofIdx=*/0, /*timeIdx=*/0);
+                const auto& fs = intQuants.fluidState();
+                Scalar porv =
+                    Toolbox::value(intQuants.porosity())
+                    *elemCtx.dofTotalVolume(/*dofIdx=*/0, /*timeIdx=*/0);
+
+                data[porvIdx] += porv;
+                data[pvPressureIdx] += porv*Toolbox::value(fs.pressure(oilPhaseIdx));
+                for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                    if (!FluidSystem::phaseIsActive(phaseIdx))
+                        continue;
+                    data[inPlaceOffset + phaseIdx] += porv*Toolbox::value(fs.saturation(phaseIdx));
+                }
+
+                if (!isRegionBoundary)
+                    continue;
+
+                // add the fluxes over all faces of the element to elements of other
+                // regions. since only interior elements are considered, each face
+                // between two regions is seen by the processes of both elements.
+                const auto& stencil = elemCtx.stencil(/*timeIdx=*/0);
+                for (unsigned faceIdx = 0; faceIdx < stencil.numInteriorFaces(); ++faceIdx) {
+                    const auto& face = stencil.interiorFace(faceIdx);
+                    unsigned i = elemCtx.globalSpaceIndex(face.interiorIndex(), /*timeIdx=*/0);
+                    unsigned j = elemCtx.globalSpaceIndex(face.exteriorIndex(), /*timeIdx=*/0);
+                    if (i != elemIdx || elemRegion_[j] == elemRegion_[elemIdx])
+                        continue;
+
+                    const auto& extQuants = elemCtx.extensiveQuantities(faceIdx, /*timeIdx=*/0);
+                    Scalar alpha = face.area()*extQuants.extrusionFactor();
+                    for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                        if (!FluidSystem::phaseIsActive(phaseIdx))
+                            continue;
+                        data[outflowOffset + phaseIdx] +=
+                            alpha*Toolbox::value(extQuants.volumeFlux(phaseIdx));
+                    }
+                }
+            }
+        }
+
+        // reduce the results of the threads and of the processes
+        std::fill(regionData_.begin(), regionData_.end(), 0.0);
+        for (const auto& threadData : threadRegionData_)
+            for (size_t i = 0; i < regionData_.size(); ++i)
+                regionData_[i] += threadData[i];
+        gridView.comm().sum(regionData_.data(), static_cast<int>(regionData_.size()));
+    }
+
+    const Simulator& simulator_;
+
+    unsigned numRegions_;
+    std::vector<unsigned> elemRegion_;
+    std::vector<char> isRegionBoundary_;
+
+    std::vector<Scalar> regionData_;
+    std::vector<std::vector<Scalar> > threadRegionData_;
+
+    std::ofstream outStream_;
+};
+} // namespace Ewoms
+
+#endif
@@ -273,6 +273,67 @@ public:
     Scalar transmissibility(unsigned elemIdx1, unsigned elemIdx2) const
     { return trans_.at(isId_(elemIdx1, elemIdx2)); }
 
+    /*!
+     * \brief Add the permeabilities and the transmissibilities to a case cache.
+     */
+    template <class CaseCache>
+    void addToCache(CaseCache& cache) const
+    {
+        std::vector<Scalar> perm;
+        perm.reserve(permeability_.size()*dimWorld*dimWorld);
+        for (const auto& K : permeability_)
+            for (unsigned i = 0; i < dimWorld; ++i)
+                for (unsigned j = 0; j < dimWorld; ++j)
+                    perm.push_back(K[i][j]);
+
+        std::vector<std::uint64_t> transIds;
+        std::vector<Scalar> transValues;
+        transIds.reserve(trans_.size());
+        transValues.reserve(trans_.size());
+        for (const auto& idTrans : trans_) {
+            transIds.push_back(idTrans.first);
+            transValues.push_back(idTrans.second);
+        }
+
+        cache.add("permeability", perm);
+        cache.add("transIds", transIds);
+        cache.add("transValues", transValues);
+    }
+
+    /*!
+     * \brief Read the permeabilities and the transmissibilities from a case cache
+     *        instead of computing them.
+     *
+     * \return false if the cache does not contain the required data
+     */
+    template <class CaseCache>
+    bool readFromCache(const CaseCache& cache)
+    {
+        std::vector<Scalar> perm;
+        std::vector<std::uint64_t> transIds;
+        std::vector<Scalar> transValues;
+        if (!cache.read("permeability", perm)
+            || !cache.read("transIds", transIds)
+            || !cache.read("transValues", transValues)
+            || perm.size() % (dimWorld*dimWorld) != 0
+            || transIds.size() != transValues.size())
+            return false;
+
+        permeability_.resize(perm.size()/(dimWorld*dimWorld));
+        auto permIt = perm.begin();
+        for (auto& K : permeability_)
+            for (unsigned i = 0; i < dimWorld; ++i)
+                for (unsigned j = 0; j < dimWorld; ++j)
+                    K[i][j] = *permIt++;
+
+        trans_.clear();
+        trans_.reserve(transIds.size());
+        for (size_t i = 0; i < transIds.size(); ++i)
+            trans_[transIds[i]] = transValues[i];
+
+        return true;
+    }
+
 private:
     template <class Intersection>
     void computeFaceProperties( const Intersection& intersection,
@@ -34,7 +34,9 @@
 #include "ecloutputblackoilmodule.hh"
 
 #include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include <ewoms/io/asyncwriter.hh>
 #include <ewoms/io/baseoutputwriter.hh>
+#include <ewoms/parallel/threadedentityiterator.hh>
 #include <opm/output/eclipse/EclipseIO.hpp>
 
 #include <opm/common/Valgrind.hpp>
@@ -43,6 +45,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
 #include <list>
 #include <utility>
 #include <string>
@@ -50,10 +53,14 @@
 #include <sstream>
 #include <fstream>
 #include <type_traits>
+#include <memory>
 
 namespace Ewoms {
 namespace Properties {
 NEW_PROP_TAG(EnableEclOutput);
+NEW_PROP_TAG(EnableAsyncEclOutput);
+NEW_PROP_TAG(MaxPendingEclOutputs);
+NEW_PROP_TAG(EclOutputGatherBatchSize);
 }
 
 template <class TypeTag>
@@ -74,6 +81,11 @@ class EclWriter;
  *   soon as you try to write an ECL output file.
  * - This class requires to use the black oil model with the element
  *   centered finite volume discretization.
+ *
+ * If the EnableAsyncEclOutput parameter is true, the I/O rank hands the collected data
+ * over to a writer thread and continues with the simulation while the restart and
+ * summary files are written. At most MaxPendingEclOutputs report steps are buffered;
+ * if this number is exceeded, writeOutput() waits until the oldest one was written.
  */
 template <class TypeTag>
 class EclWriter
@@ -92,12 +104,24 @@ class EclWriter
 
     typedef std::vector<Scalar> ScalarBuffer;
 
+    // all data which is required to write a report step
+    struct WriteJob_
+    {
+        int episodeIdx;
+        bool substep;
+        double time;
+        Opm::data::Solution cellData;
+        Opm::data::Wells wells;
+        std::map<std::string, double> miscSummaryData;
+        std::map<std::string, std::vector<double>> extraRestartData;
+    };
 
 public:
     EclWriter(const Simulator& simulator)
         : simulator_(simulator)
         , eclOutputModule_(simulator)
-        , collectToIORank_( simulator_.gridManager() )
+        , collectToIORank_( simulator_.gridManager(),
+                            EWOMS_GET_PARAM(TypeTag, int, EclOutputGatherBatchSize) )
     {
         Grid globalGrid = simulator_.gridManager().grid();
         globalGrid.switchToGlobalView();
@@ -105,17 +129,62 @@ public:
                                         Opm::UgGridHelpers::createEclipseGrid( globalGrid , simulator_.gridManager().eclState().getInputGrid() ),
                                         simulator_.gridManager().schedule(),
                                         simulator_.gridManager().summaryConfig()));
+
+        // only the I/O rank writes files, so the other ranks do not need a thread
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableAsyncEclOutput) && collectToIORank_.isIORank()) {
+            int maxPending = EWOMS_GET_PARAM(TypeTag, int, MaxPendingEclOutputs);
+            asyncWriter_.start(static_cast<unsigned>(std::max(1, maxPending)),
+                               [this](WriteJob_& job) { this->writeJob_(job); });
+        }
     }
 
     ~EclWriter()
-    { }
+    {
+        // write the pending report steps before eclIO_ goes away
+        asyncWriter_.stop();
+    }
+
+    /*!
+     * \brief Register all run-time parameters for the ECL writer.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableAsyncEclOutput,
+                             "Write the ECL output files in a separate thread");
+        EWOMS_REGISTER_PARAM(TypeTag, int, MaxPendingEclOutputs,
+                             "The maximum number of report steps which are buffered by the "
+                             "asynchronous ECL writer");
+        EWOMS_REGISTER_PARAM(TypeTag, int, EclOutputGatherBatchSize,
+                             "The maximum number of output fields which are gathered on the "
+                             "I/O rank at once. This only bounds the size of the transient "
+                             "message buffers, the I/O rank still holds all gathered "
+                             "fields. 0 means all fields");
+    }
 
     void setEclIO(std::unique_ptr<Opm::EclipseIO>&& eclIO) {
+        waitForPendingWrites();
         eclIO_ = std::move(eclIO);
     }
 
     const Opm::EclipseIO& eclIO() const
-    {return *eclIO_;}
+    {
+        waitForPendingWrites();
+        return *eclIO_;
+    }
+
+    /*!
+     * \brief Returns true if the output files are written by a separate thread.
+     */
+    bool isAsynchronous() const
+    { return asyncWriter_.isRunning(); }
+
+    /*!
+     * \brief Wait until all pending report steps have been written to disk.
+     *
+     * If writing one of them failed, the exception is re-thrown here.
+     */
+    void waitForPendingWrites() const
+    { asyncWriter_.waitForPendingJobs(); }
 
     /*!
      * \brief collect and pass data and pass it to eclIO writer
@@ -134,14 +203,22 @@ public:
         bool log = collectToIORank_.isIORank();
         eclOutputModule_.allocBuffers(numElements, episodeIdx, simulator_.gridManager().eclState().getRestartConfig(), substep, log);
 
-        ElementContext elemCtx(simulator_);
-        ElementIterator elemIt = gridView.template begin</*codim=*/0>();
-        const ElementIterator& elemEndIt = gridView.template end</*codim=*/0>();
-        for (; elemIt != elemEndIt; ++elemIt) {
-            const Element& elem = *elemIt;
-            elemCtx.updatePrimaryStencil(elem);
-            elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-            eclOutputModule_.processElement(elemCtx);
+        // the intensive quantities are taken from the cache of the model if they are up
+        // to date. otherwise, they are computed and stored in the cache, so that the
+        // first linearization of the next time step can use them.
+        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            ElementContext elemCtx(simulator_);
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element& elem = *elemIt;
+                elemCtx.updatePrimaryStencil(elem);
+                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                eclOutputModule_.processElement(elemCtx);
+            }
         }
         eclOutputModule_.outputErrorLog();
 
@@ -153,27 +230,35 @@ public:
 
         // write output on I/O rank
         if (collectToIORank_.isIORank()) {
-
-            std::map<std::string, std::vector<double>> extraRestartData;
-            std::map<std::string, double> miscSummaryData;
+            std::unique_ptr<WriteJob_> job(new WriteJob_);
+            job->episodeIdx = episodeIdx;
+            job->substep = substep;
+            job->time = t;
+            job->wells = dw;
 
             // Add suggested next timestep to extra data.
-            extraRestartData["OPMEXTRA"] = std::vector<double>(1, nextstep);
+            job->extraRestartData["OPMEXTRA"] = std::vector<double>(1, nextstep);
 
             // Add TCPU if simulatorReport is not defaulted.
             if (totalSolverTime != 0.0) {
-                miscSummaryData["TCPU"] = totalSolverTime;
+                job->miscSummaryData["TCPU"] = totalSolverTime;
             }
 
-            const Opm::data::Solution& cellData = collectToIORank_.isParallel() ? collectToIORank_.globalCellData() : localCellData;
-            eclIO_->writeTimeStep(episodeIdx,
-                                  substep,
-                                  t,
-                                  cellData,
-                                  dw,
-                                  miscSummaryData,
-                                  extraRestartData,
-                                  false);
+            // the global data is overwritten by the next call of collect(), so it is
+            // moved into the job
+            if (collectToIORank_.isParallel())
+                job->cellData = collectToIORank_.releaseGlobalCellData();
+            else
+                job->cellData = std::move(localCellData);
+
+            if (!isAsynchronous()) {
+                writeJob_(*job);
+                return;
+            }
+
+            // hand the report step over to the writer thread. if too many report steps
+            // are pending, wait for the oldest one to keep the memory bounded.
+            asyncWriter_.submit(std::move(job));
         }
 
 #endif
@@ -196,6 +281,8 @@ public:
             {"OPMEXTRA" , false}
         };
 
+        waitForPendingWrites();
+
         unsigned episodeIdx = simulator_.episodeIndex();
         const auto& gridView = simulator_.gridManager().gridView();
         unsigned numElements = gridView.size(/*codim=*/0);
@@ -218,11 +305,26 @@ private:
     static bool enableEclOutput_()
     { return EWOMS_GET_PARAM(TypeTag, bool, EnableEclOutput); }
 
+    void writeJob_(const WriteJob_& job)
+    {
+        eclIO_->writeTimeStep(job.episodeIdx,
+                              job.substep,
+                              job.time,
+                              job.cellData,
+                              job.wells,
+                              job.miscSummaryData,
+                              job.extraRestartData,
+                              false);
+    }
+
     const Simulator& simulator_;
     EclOutputBlackOilModule<TypeTag> eclOutputModule_;
     CollectDataToIORankType collectToIORank_;
     std::unique_ptr<Opm::EclipseIO> eclIO_;
 
+    // writes the report steps if the output is asynchronous
+    AsyncWriter<WriteJob_> asyncWriter_;
+
 };
 } // namespace Ewoms
 
@@ -14,6 +14,8 @@ set (ewoms_CONFIG_VAR
   HAVE_DUNE_ALUGRID
   HAVE_DUNE_FEM
   HAVE_OPM_OUTPUT
+  HAVE_ZLIB
+  HAVE_LZ4
   DUNE_AVOID_CAPABILITIES_IS_PARALLEL_DEPRECATION_WARNING
   )
 
@@ -42,6 +44,8 @@ set (ewoms_DEPS
   "Valgrind"
   # quadruple precision floating point calculations
   "Quadmath"
+  # compressed VTK output
+  "ZLIB"
   )
 
 find_package_deps(ewoms)
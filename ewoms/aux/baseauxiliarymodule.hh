@@ -117,6 +117,24 @@ public:
      */
     virtual void linearize(JacobianMatrix& matrix, GlobalEqVector& residual) = 0;
 
+    /*!
+     * \brief Save the internal state of the auxiliary module which may be modified
+     *        while a time step is computed.
+     *
+     * This is called before the first attempt to solve a time step. The method should
+     * not allocate memory.
+     */
+    virtual void saveTimeStepSnapshot()
+    { }
+
+    /*!
+     * \brief Restore the internal state which was saved by saveTimeStepSnapshot().
+     *
+     * This is called after an attempt to solve a time step has failed.
+     */
+    virtual void restoreTimeStepSnapshot()
+    { }
+
 private:
     int dofOffset_;
 };
@@ -115,6 +115,9 @@ NEW_PROP_TAG(InitialTimeStepSize);
 //! The default value for the simulation's restart time
 NEW_PROP_TAG(RestartTime);
 
+//! Specify whether restart files are written in the binary format
+NEW_PROP_TAG(EnableBinaryRestart);
+
 //! The name of the file with a number of forced time step lengths
 NEW_PROP_TAG(PredeterminedTimeStepsFile);
 
@@ -184,6 +187,9 @@ SET_SCALAR_PROP(NumericModel, InitialTimeStepSize, -1e35);
 //! The default value for the simulation's restart time
 SET_SCALAR_PROP(NumericModel, RestartTime, -1e35);
 
+//! By default, restart files are written as text
+SET_BOOL_PROP(NumericModel, EnableBinaryRestart, false);
+
 //! By default, do not force any time steps
 SET_STRING_PROP(NumericModel, PredeterminedTimeStepsFile, "");
 
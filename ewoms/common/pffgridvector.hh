@@ -28,6 +28,7 @@
 #define EWOMS_PFF_GRID_VECTOR_HH
 
 #include <ewoms/common/prefetch.hh>
+#include <ewoms/parallel/firsttouchallocator.hh>
 
 #include <dune/grid/common/mcmgmapper.hh>
 #include <dune/common/version.hh>
@@ -133,7 +134,7 @@ private:
     GridView gridView_;
     ElementMapper elementMapper_;
     const DofMapper& dofMapper_;
-    std::vector<Data> data_;
+    std::vector<Data, FirstTouchAllocator<Data> > data_;
     std::vector<Data*> elemData_;
 };
 
@@ -55,6 +55,7 @@ NEW_PROP_TAG(Model);
 NEW_PROP_TAG(Problem);
 NEW_PROP_TAG(EndTime);
 NEW_PROP_TAG(RestartTime);
+NEW_PROP_TAG(EnableBinaryRestart);
 NEW_PROP_TAG(InitialTimeStepSize);
 NEW_PROP_TAG(PredeterminedTimeStepsFile);
 }
@@ -81,16 +82,31 @@ class Simulator
     typedef typename GET_PROP_TYPE(TypeTag, Problem) Problem;
 
 public:
+    typedef Dune::MPIHelper::MPICommunicator Communicator;
+
     // do not allow to copy simulators around
     Simulator(const Simulator& ) = delete;
 
     Simulator(bool verbose = true)
+        : Simulator(Dune::MPIHelper::getCommunicator(), verbose)
+    {}
+
+    /*!
+     * \brief Set up a simulation which runs on a given MPI communicator.
+     *
+     * This allows to run several independent simulations within a single MPI job,
+     * e.g., one for each realization of an ensemble, by splitting MPI_COMM_WORLD.
+     * The grid, the model and the linear solver only communicate via this
+     * communicator.
+     */
+    Simulator(Communicator comm, bool verbose = true)
+        : comm_(comm)
     {
         Ewoms::TimerGuard setupTimerGuard(setupTimer_);
 
         setupTimer_.start();
 
-        verbose_ = verbose && Dune::MPIHelper::getCollectiveCommunication().rank() == 0;
+        verbose_ = verbose && Dune::CollectiveCommunication<Communicator>(comm_).rank() == 0;
 
         timeStepIdx_ = 0;
         startTime_ = 0.0;
@@ -156,6 +172,8 @@ public:
                              "The size of the initial time step [s]");
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, RestartTime,
                              "The simulation time at which a restart should be attempted [s]");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableBinaryRestart,
+                             "Write restart files in the binary format instead of as text");
         EWOMS_REGISTER_PARAM(TypeTag, std::string, PredeterminedTimeStepsFile,
                              "A file with a list of predetermined time step sizes (one "
                              "time step per line)");
@@ -165,6 +183,12 @@ public:
         Problem::registerParameters();
     }
 
+    /*!
+     * \brief Returns the MPI communicator on which the simulation runs.
+     */
+    Communicator communicator() const
+    { return comm_; }
+
     /*!
      * \brief Return a reference to the grid manager of simulation
      */
@@ -786,12 +810,14 @@ public:
      * The file will start with the prefix returned by the name()
      * method, has the current time of the simulation clock in it's
      * name and uses the extension <tt>.ers</tt>. (Ewoms ReStart
-     * file.)  See Ewoms::Restart for details.
+     * file.)  If the EnableBinaryRestart parameter is true, the
+     * binary format is used.  See Ewoms::Restart for details.
      */
     void serialize()
     {
         typedef Ewoms::Restart Restarter;
-        Restarter res;
+        bool binary = EWOMS_GET_PARAM(TypeTag, bool, EnableBinaryRestart);
+        Restarter res(binary ? Restarter::Format::Binary : Restarter::Format::Text);
         res.serializeBegin(*this);
         if (gridView().comm().rank() == 0)
             std::cout << "Serialize to file '" << res.fileName() << "'"
@@ -847,6 +873,8 @@ public:
     }
 
 private:
+    Communicator comm_;
+
     std::unique_ptr<GridManager> gridManager_;
     std::unique_ptr<Model> model_;
     std::unique_ptr<Problem> problem_;
@@ -241,7 +241,9 @@ static inline int start(int argc, char **argv)
         if (paramStatus == 2)
             return 0;
 
-        ThreadManager::init();
+        // the thread manager and the simulator use the same MPI communicator
+        const auto comm = Dune::MPIHelper::getCommunicator();
+        ThreadManager::init(comm);
 
         // read the initial time step and the end time
         Scalar endTime = EWOMS_GET_PARAM(TypeTag, Scalar, EndTime);
@@ -308,7 +310,7 @@ static inline int start(int argc, char **argv)
         // instantiate and run the concrete problem. make sure to
         // deallocate the problem and before the time manager and the
         // grid
-        Simulator simulator;
+        Simulator simulator(comm);
         simulator.run();
 
         if (myRank == 0) {
@@ -29,10 +29,7 @@
 #define EWOMS_TIMER_HH
 
 #include <chrono>
-
-#if HAVE_MPI
-#include <mpi.h>
-#endif
+#include <ctime>
 
 namespace Ewoms {
 /*!
@@ -165,25 +162,15 @@ public:
     /*!
      * \brief Return the CPU time [s] used by all threads of the all processes of program
      *
-     * The value returned only differs from cpuTimeElapsed() if MPI is used.
+     * The value returned only differs from cpuTimeElapsed() if MPI is used. All
+     * processes of the collective communication object must call this method.
+     *
+     * \param comm The collective communication object of the processes, e.g., the one of
+     *             the grid view
      */
-    double globalCpuTimeElapsed() const
-    {
-        double val = cpuTimeElapsed();
-        double globalVal = val;
-
-#if HAVE_MPI
-        MPI_Reduce(&val,
-                   &globalVal,
-                   /*count=*/1,
-                   MPI_DOUBLE,
-                   MPI_SUM,
-                   /*rootRank=*/0,
-                   MPI_COMM_WORLD);
-#endif
-
-        return globalVal;
-    }
+    template <class CollectiveCommunication>
+    double globalCpuTimeElapsed(const CollectiveCommunication& comm) const
+    { return comm.sum(cpuTimeElapsed()); }
 
     /*!
      * \brief Adds the time of another timer to the current one
@@ -48,6 +48,7 @@
 
 #include <ewoms/parallel/gridcommhandles.hh>
 #include <ewoms/parallel/threadmanager.hh>
+#include <ewoms/parallel/firsttouchallocator.hh>
 #include <ewoms/linear/nullborderlistmanager.hh>
 #include <ewoms/common/simulator.hh>
 #include <ewoms/aux/baseauxiliarymodule.hh>
@@ -76,6 +77,8 @@
 #include <dune/fem/misc/capabilities.hh>
 #endif
 
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <list>
 #include <sstream>
@@ -125,7 +128,8 @@ SET_TYPE_PROP(FvBaseDiscretization, DiscExtensiveQuantities, Ewoms::FvBaseExtens
 //! Calculates the gradient of any quantity given the index of a flux approximation point
 SET_TYPE_PROP(FvBaseDiscretization, GradientCalculator, Ewoms::FvBaseGradientCalculator<TypeTag>);
 
-//! Set the type of a global jacobian matrix from the solution types
+//! Set the type of a global jacobian matrix from the solution types. The matrix entries
+//! are distributed over the NUMA nodes of the threads which linearize the system.
 SET_PROP(FvBaseDiscretization, JacobianMatrix)
 {
 private:
@@ -133,7 +137,7 @@ private:
     enum { numEq = GET_PROP_VALUE(TypeTag, NumEq) };
     typedef typename Dune::FieldMatrix<Scalar, numEq, numEq> MatrixBlock;
 public:
-    typedef typename Dune::BCRSMatrix<MatrixBlock> type;
+    typedef typename Dune::BCRSMatrix<MatrixBlock, Ewoms::FirstTouchAllocator<MatrixBlock> > type;
 };
 
 //! The maximum allowed number of timestep divisions for the
@@ -208,7 +212,14 @@ SET_TYPE_PROP(FvBaseDiscretization, ConstraintsContext, Ewoms::FvBaseConstraints
  */
 SET_TYPE_PROP(FvBaseDiscretization, ThreadManager, Ewoms::ThreadManager<TypeTag>);
 SET_INT_PROP(FvBaseDiscretization, ThreadsPerProcess, 1);
+SET_STRING_PROP(FvBaseDiscretization, ThreadAffinity, "none");
+SET_BOOL_PROP(FvBaseDiscretization, CheckMemoryBandwidth, false);
 SET_BOOL_PROP(FvBaseDiscretization, UseLinearizationLock, true);
+SET_BOOL_PROP(FvBaseDiscretization, MeasureElementCosts, false);
+
+//! assemble the full Jacobian matrix by default. linear solver backends which apply the
+//! Jacobian matrix-free override this.
+SET_BOOL_PROP(FvBaseDiscretization, EnableMatrixFreeLinearization, false);
 
 /*!
  * \brief Linearizer for the global system of equations.
@@ -231,6 +242,10 @@ SET_BOOL_PROP(FvBaseDiscretization, EnableGridAdaptation, false);
 //! Enable the VTK output by default
 SET_BOOL_PROP(FvBaseDiscretization, EnableVtkOutput, true);
 
+//! Write the VTK output synchronously by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableAsyncVtkOutput, false);
+SET_INT_PROP(FvBaseDiscretization, MaxPendingVtkOutputs, 2);
+
 //! Set the format of the VTK output to ASCII by default
 SET_INT_PROP(FvBaseDiscretization, VtkOutputFormat, Dune::VTK::ascii);
 
@@ -312,7 +327,7 @@ class FvBaseDiscretization
         historySize = GET_PROP_VALUE(TypeTag, TimeDiscHistorySize),
     };
 
-    typedef std::vector<IntensiveQuantities, Ewoms::aligned_allocator<IntensiveQuantities, alignof(IntensiveQuantities)> > IntensiveQuantitiesVector;
+    typedef std::vector<IntensiveQuantities, Ewoms::FirstTouchAllocator<IntensiveQuantities, alignof(IntensiveQuantities)> > IntensiveQuantitiesVector;
 
     typedef typename GridView::template Codim<0>::Entity Element;
     typedef typename GridView::template Codim<0>::Iterator ElementIterator;
@@ -386,6 +401,7 @@ public:
         , enableGridAdaptation_( EWOMS_GET_PARAM(TypeTag, bool, EnableGridAdaptation) )
         , enableIntensiveQuantityCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableIntensiveQuantityCache))
         , enableStorageCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache))
+        , haveTimeStepSnapshot_(false)
         , enableThermodynamicHints_(EWOMS_GET_PARAM(TypeTag, bool, EnableThermodynamicHints))
     {
 #if HAVE_DUNE_FEM
@@ -451,6 +467,8 @@ public:
 
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableGridAdaptation, "Enable adaptive grid refinement/coarsening");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkOutput, "Global switch for turing on writing VTK files");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableAsyncVtkOutput, "Write the VTK files in a separate thread");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, MaxPendingVtkOutputs, "The maximum number of time steps which may wait for being written by the asynchronous VTK writer");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStorageCache, "Store previous storage terms and avoid re-calculating them.");
@@ -1307,7 +1325,44 @@ public:
         // previous time step so that we can start the next
         // update at a physically meaningful solution.
         solution(/*timeIdx=*/0) = solution(/*timeIdx=*/1);
-        invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+
+        // if a snapshot was taken at the beginning of the time step, the intensive
+        // quantities for the restored solution do not need to be re-calculated
+        if (storeIntensiveQuantities() && haveTimeStepSnapshot_) {
+            intensiveQuantityCache_[/*timeIdx=*/0] = intensiveQuantityCache_[/*timeIdx=*/1];
+            intensiveQuantityCacheUpToDate_[/*timeIdx=*/0] = intensiveQuantityCacheUpToDate_[/*timeIdx=*/1];
+        }
+        else
+            invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+
+        auto auxModIt = auxEqModules_.begin();
+        const auto& auxModEndIt = auxEqModules_.end();
+        for (; auxModIt != auxModEndIt; ++auxModIt)
+            (*auxModIt)->restoreTimeStepSnapshot();
+    }
+
+    /*!
+     * \brief Save the state of the model which is required to retry the current time
+     *        step.
+     *
+     * This method is called by the problem before the first attempt to solve a time
+     * step and the snapshot is restored by updateFailed(). No memory is allocated: At
+     * this point, the solutions for both time indices are identical, so the cached
+     * intensive quantities are stored in the slot of the cache for the previous time
+     * step. (This slot is not used at all if the storage term is cached.)
+     */
+    void saveTimeStepSnapshot()
+    {
+        if (storeIntensiveQuantities()) {
+            intensiveQuantityCache_[/*timeIdx=*/1] = intensiveQuantityCache_[/*timeIdx=*/0];
+            intensiveQuantityCacheUpToDate_[/*timeIdx=*/1] = intensiveQuantityCacheUpToDate_[/*timeIdx=*/0];
+        }
+        haveTimeStepSnapshot_ = true;
+
+        auto auxModIt = auxEqModules_.begin();
+        const auto& auxModEndIt = auxEqModules_.end();
+        for (; auxModIt != auxModEndIt; ++auxModIt)
+            (*auxModIt)->saveTimeStepSnapshot();
     }
 
     /*!
@@ -1328,6 +1383,8 @@ public:
         // shift the intensive quantities cache by one position in the
         // history
         asImp_().shiftIntensiveQuantityCache(/*numSlots=*/1);
+
+        haveTimeStepSnapshot_ = false;
     }
 
     /*!
@@ -1406,6 +1463,74 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns the size in bytes of the record which is written for each degree of
+     *        freedom to binary restart files.
+     *
+     * By default, this is the raw values of the primary variables. Models which need to
+     * store additional data must extend the record.
+     */
+    size_t binaryEntitySize() const
+    { return numEq*sizeof(Scalar); }
+
+    /*!
+     * \brief Write the current solution for a degree of freedom to a binary restart
+     *        file.
+     *
+     * \param record The memory of binaryEntitySize() bytes which the data of the degree
+     *               of freedom ought to be written to. Note that it is not aligned.
+     * \param dof The Dune entity which's data should be serialized
+     */
+    template <class DofEntity>
+    void serializeEntityBinary(char* record, const DofEntity& dof) const
+    {
+        unsigned dofIdx = static_cast<unsigned>(asImp_().dofMapper().index(dof));
+        const auto& priVars = solution(/*timeIdx=*/0)[dofIdx];
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            Scalar value = priVars[eqIdx];
+            std::memcpy(record + eqIdx*sizeof(Scalar), &value, sizeof(Scalar));
+        }
+    }
+
+    /*!
+     * \brief Reads the current solution for a degree of freedom from a binary restart
+     *        file.
+     *
+     * \param record The memory of binaryEntitySize() bytes which stores the data of the
+     *               degree of freedom. Note that it is not aligned.
+     * \param dof The Dune entity which's data should be deserialized
+     */
+    template <class DofEntity>
+    void deserializeEntityBinary(const char* record, const DofEntity& dof)
+    {
+        unsigned dofIdx = static_cast<unsigned>(asImp_().dofMapper().index(dof));
+        auto& priVars = solution(/*timeIdx=*/0)[dofIdx];
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+            Scalar value;
+            std::memcpy(&value, record + eqIdx*sizeof(Scalar), sizeof(Scalar));
+            priVars[eqIdx] = value;
+        }
+    }
+
+    /*!
+     * \brief Returns true if the grid provides indices for the entities of a given
+     *        codimension which do not depend on the distribution of the grid.
+     *
+     * If this is the case, binary restart files can be read using a different number of
+     * processes.
+     */
+    template <int codim>
+    bool hasGlobalEntityIndices() const
+    { return simulator_.gridManager().template hasGlobalEntityIndices<codim>(); }
+
+    /*!
+     * \brief Returns the index of an entity which does not depend on the distribution of
+     *        the grid.
+     */
+    template <class Entity>
+    uint64_t globalEntityIndex(const Entity& entity) const
+    { return simulator_.gridManager().globalEntityIndex(entity); }
+
     /*!
      * \brief Returns the number of degrees of freedom (DOFs) for the computational grid
      */
@@ -1749,6 +1874,8 @@ public:
 protected:
     void resizeAndResetIntensiveQuantitiesCache_()
     {
+        haveTimeStepSnapshot_ = false;
+
         // allocate the storage cache
         if (enableStorageCache()) {
             size_t numDof = asImp_().numGridDof();
@@ -1857,6 +1984,7 @@ protected:
     bool enableGridAdaptation_;
     bool enableIntensiveQuantityCache_;
     bool enableStorageCache_;
+    bool haveTimeStepSnapshot_;
     bool enableThermodynamicHints_;
 };
 } // namespace Ewoms
@@ -33,6 +33,7 @@
 #include <ewoms/parallel/gridcommhandles.hh>
 #include <ewoms/parallel/threadmanager.hh>
 #include <ewoms/parallel/threadedentityiterator.hh>
+#include <ewoms/parallel/locks.hh>
 #include <ewoms/aux/baseauxiliarymodule.hh>
 
 #include <opm/common/ErrorMacros.hpp>
@@ -41,9 +42,13 @@
 #include <dune/common/version.hh>
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
+#include <dune/istl/bcrsmatrix.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <type_traits>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <set>
 
@@ -101,17 +106,28 @@ class FvBaseLinearizer
     typedef Dune::FieldVector<Scalar, numEq> VectorBlock;
 
     static const bool linearizeNonLocalElements = GET_PROP_VALUE(TypeTag, LinearizeNonLocalElements);
+    static const bool enableMatrixFree = GET_PROP_VALUE(TypeTag, EnableMatrixFreeLinearization);
 
     // copying the linearizer is not a good idea
     FvBaseLinearizer(const FvBaseLinearizer&);
 //! \endcond
 
 public:
+    /*!
+     * \brief The type used to represent the sparsity pattern of the full Jacobian
+     *        matrix if it is applied matrix-free.
+     *
+     * Only the indices of the non-zero blocks of this matrix are used.
+     */
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<char, 1, 1> > StencilPattern;
+
     FvBaseLinearizer()
     {
         simulatorPtr_ = 0;
 
         matrix_ = 0;
+
+        measureElementCosts_ = false;
     }
 
     ~FvBaseLinearizer()
@@ -127,7 +143,10 @@ public:
      * \brief Register all run-time parameters for the Jacobian linearizer.
      */
     static void registerParameters()
-    { }
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, MeasureElementCosts,
+                             "Accumulate the time required to linearize each element");
+    }
 
     /*!
      * \brief Initialize the linearizer.
@@ -143,6 +162,9 @@ public:
         simulatorPtr_ = &simulator;
         delete matrix_; // <- note that this even works for nullpointers!
         matrix_ = 0;
+
+        measureElementCosts_ = EWOMS_GET_PARAM(TypeTag, bool, MeasureElementCosts);
+        elementCosts_.clear();
     }
 
     /*!
@@ -229,6 +251,101 @@ public:
     GlobalEqVector& residual()
     { return residual_; }
 
+    /*!
+     * \brief Returns the sparsity pattern of the full Jacobian matrix.
+     *
+     * This method requires the EnableMatrixFreeLinearization property to be true. In
+     * this case, matrix() only stores the diagonal blocks, but the linear solver still
+     * needs to know which degrees of freedom are coupled to determine its overlap.
+     */
+    const StencilPattern& stencilPattern() const
+    { return *stencilPattern_; }
+
+    /*!
+     * \brief Compute the product of the Jacobian matrix and a vector without assembling
+     *        the full matrix.
+     *
+     * This method requires the EnableMatrixFreeLinearization property to be true. In
+     * this case, matrix() only contains the diagonal blocks of the Jacobian and the
+     * contributions of the auxiliary equations. The remaining blocks are not assembled:
+     * The off-diagonal blocks of the local Jacobians are kept from the last
+     * linearization and are multiplied with the vector element by element, i.e., the
+     * elements are not relinearized by this method.
+     *
+     * \param v The vector which is multiplied by the Jacobian matrix. The entries of
+     *          the ghost degrees of freedom are set to the ones of their master
+     *          processes.
+     * \param y The vector which receives the result
+     */
+    void applyJacobian(GlobalEqVector& v, GlobalEqVector& y)
+    {
+        static_assert(enableMatrixFree,
+                      "Applying the Jacobian matrix-free requires the "
+                      "EnableMatrixFreeLinearization property to be true");
+
+        // the local Jacobians of the elements at the process border require the
+        // vector's entries of the ghost degrees of freedom
+        const auto ghostSyncHandle =
+            GridCommHandleFactory::template ghostSyncHandle<VectorBlock>(v, dofMapper_());
+        gridView_().communicate(*ghostSyncHandle,
+                                Dune::InteriorBorder_All_Interface,
+                                Dune::ForwardCommunication);
+
+        y.resize(v.size());
+        y = 0.0;
+
+        // the contributions of an element are added to the rows of all of its
+        // neighbors. to avoid locking these rows, each thread adds its contributions to
+        // its own vector, which are summed up afterwards. the first thread uses the
+        // result vector directly.
+        threadProducts_.resize(ThreadManager::maxThreads() - 1);
+
+        int numElements = static_cast<int>(localJacobians_.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            unsigned threadId = ThreadManager::threadId();
+            GlobalEqVector* threadY = &y;
+            if (threadId > 0) {
+                threadY = &threadProducts_[threadId - 1];
+                threadY->resize(v.size());
+                (*threadY) = 0.0;
+            }
+
+#ifdef _OPENMP
+#pragma omp for
+#endif
+            for (int elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+                const auto& localJacobian = localJacobians_[static_cast<unsigned>(elemIdx)];
+                for (const auto& entry : localJacobian)
+                    entry.block.umv(v[entry.colIdx], (*threadY)[entry.rowIdx]);
+            }
+        }
+
+        if (!threadProducts_.empty()) {
+            int numDof = static_cast<int>(y.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (int dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+                auto& yRow = y[static_cast<unsigned>(dofIdx)];
+                for (unsigned i = 0; i < threadProducts_.size(); ++i)
+                    yRow += threadProducts_[i][static_cast<unsigned>(dofIdx)];
+            }
+        }
+
+        // the rows of constraint degrees of freedom are represented by the identity
+        // matrix which is stored on the diagonal
+        auto it = constraintsMap_.begin();
+        const auto& endIt = constraintsMap_.end();
+        for (; it != endIt; ++it)
+            y[it->first] = 0.0;
+
+        // add the stored part of the Jacobian
+        matrix_->umv(v, y);
+    }
+
     /*!
      * \brief Returns the map of constraint degrees of freedom.
      *
@@ -237,6 +354,23 @@ public:
     const std::map<unsigned, Constraints>& constraintsMap() const
     { return constraintsMap_; }
 
+    /*!
+     * \brief Returns the accumulated wall clock time [s] spent for linearizing each
+     *        element since the last call to resetElementCosts().
+     *
+     * The vector is indexed by the element mapper and it is only non-empty if the
+     * MeasureElementCosts parameter is true. Elements of other processes' partitions
+     * which are not linearized locally have zero costs.
+     */
+    const std::vector<double>& elementCosts() const
+    { return elementCosts_; }
+
+    /*!
+     * \brief Set the accumulated costs of all elements to zero.
+     */
+    void resetElementCosts()
+    { std::fill(elementCosts_.begin(), elementCosts_.end(), 0.0); }
+
 private:
     Simulator& simulator_()
     { return *simulatorPtr_; }
@@ -267,6 +401,9 @@ private:
         // initialize the BCRS matrix for the Jacobian of the residual function
         createMatrix_();
 
+        if (measureElementCosts_)
+            elementCosts_.resize(static_cast<size_t>(gridView_().size(/*codim=*/0)), 0.0);
+
         // initialize the Jacobian matrix and the vector for the residual function
         (*matrix_) = 0.0;
         residual_.resize(model_().numTotalDof());
@@ -292,6 +429,12 @@ private:
         // freedom of each primary degree of freedom
         typedef std::set<unsigned> NeighborSet;
         std::vector<NeighborSet> neighbors(numAllDof);
+
+        // if the Jacobian is applied matrix-free, only the diagonal blocks of the local
+        // linearizations are stored. the linear solver still needs the full stencil to
+        // determine its overlap, though.
+        std::vector<NeighborSet> stencilNeighbors(enableMatrixFree ? numAllDof : 0);
+
         ElementIterator elemIt = gridView_().template begin<0>();
         const ElementIterator elemEndIt = gridView_().template end<0>();
         for (; elemIt != elemEndIt; ++elemIt) {
@@ -301,9 +444,15 @@ private:
             for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
                 unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
 
+                NeighborSet* stencilRow = &neighbors[myIdx];
+                if (enableMatrixFree) {
+                    neighbors[myIdx].insert(myIdx);
+                    stencilRow = &stencilNeighbors[myIdx];
+                }
+
                 for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx) {
                     unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
-                    neighbors[myIdx].insert(neighborIdx);
+                    stencilRow->insert(neighborIdx);
                 }
             }
         }
@@ -330,6 +479,38 @@ private:
                 matrix_->addindex(dofIdx, *nIt);
         }
         matrix_->endindices();
+
+        if (enableMatrixFree) {
+            createStencilPattern_(neighbors, stencilNeighbors);
+
+            localJacobians_.clear();
+            localJacobians_.resize(static_cast<size_t>(gridView_().size(/*codim=*/0)));
+        }
+    }
+
+    // construct the sparsity pattern of the full Jacobian if only its diagonal blocks
+    // and the entries of the auxiliary equations are stored
+    template <class NeighborSet>
+    void createStencilPattern_(const std::vector<NeighborSet>& storedNeighbors,
+                               std::vector<NeighborSet>& stencilNeighbors)
+    {
+        size_t numAllDof = storedNeighbors.size();
+        stencilPattern_.reset(new StencilPattern(numAllDof, numAllDof, StencilPattern::random));
+
+        for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx) {
+            stencilNeighbors[dofIdx].insert(storedNeighbors[dofIdx].begin(),
+                                            storedNeighbors[dofIdx].end());
+            stencilPattern_->setrowsize(dofIdx, stencilNeighbors[dofIdx].size());
+        }
+        stencilPattern_->endrowsizes();
+
+        for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx) {
+            auto nIt = stencilNeighbors[dofIdx].begin();
+            const auto& nEndIt = stencilNeighbors[dofIdx].end();
+            for (; nIt != nEndIt; ++nIt)
+                stencilPattern_->addindex(dofIdx, *nIt);
+        }
+        stencilPattern_->endindices();
     }
 
     // reset the global linear system of equations.
@@ -426,7 +607,17 @@ private:
                 if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
                     continue;
 
-                linearizeElement_(elem);
+                if (measureElementCosts_) {
+                    auto startTime = std::chrono::steady_clock::now();
+                    linearizeElement_(elem);
+                    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - startTime;
+
+                    // each element is linearized by exactly one thread, so no locking is
+                    // required here
+                    elementCosts_[elementMapper_().index(elem)] += dt.count();
+                }
+                else
+                    linearizeElement_(elem);
             }
         }
 
@@ -446,6 +637,14 @@ private:
         // the actual work of linearization is done by the local linearizer class
         localLinearizer.linearize(*elementCtx, elem);
 
+        // each element is linearized by exactly one thread, so its entry of the local
+        // Jacobian cache can be modified without locking
+        std::vector<OffDiagonalBlock_>* localJacobian = nullptr;
+        if (enableMatrixFree) {
+            localJacobian = &localJacobians_[elementMapper_().index(elem)];
+            localJacobian->clear();
+        }
+
         // update the right hand side and the Jacobian matrix
         if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
             globalMatrixMutex_.lock();
@@ -460,6 +659,12 @@ private:
             // update the global Jacobian matrix
             for (unsigned dofIdx = 0; dofIdx < elementCtx->numDof(/*timeIdx=*/0); ++ dofIdx) {
                 unsigned globJ = elementCtx->globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+                if (enableMatrixFree && globJ != globI) {
+                    // applied by applyJacobian()
+                    localJacobian->push_back({globJ, globI,
+                                              localLinearizer.jacobian(dofIdx, primaryDofIdx)});
+                    continue;
+                }
 
                 (*matrix_)[globJ][globI] += localLinearizer.jacobian(dofIdx, primaryDofIdx);
             }
@@ -537,9 +742,27 @@ private:
 
     // the jacobian matrix
     Matrix *matrix_;
+
+    // the sparsity pattern of the full jacobian, the off-diagonal blocks of the local
+    // jacobians of all elements (indexed by the element mapper) and the per-thread
+    // results of applyJacobian(). only used if the jacobian is applied matrix-free
+    struct OffDiagonalBlock_
+    {
+        unsigned rowIdx;
+        unsigned colIdx;
+        MatrixBlock block;
+    };
+
+    std::unique_ptr<StencilPattern> stencilPattern_;
+    std::vector<std::vector<OffDiagonalBlock_> > localJacobians_;
+    std::vector<GlobalEqVector> threadProducts_;
     // the right-hand side
     GlobalEqVector residual_;
 
+    // the accumulated time required to linearize the individual elements
+    bool measureElementCosts_;
+    std::vector<double> elementCosts_;
+
 
     OmpMutex globalMatrixMutex_;
 };
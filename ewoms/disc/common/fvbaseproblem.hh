@@ -137,8 +137,11 @@ public:
             boundingBoxMax_[i] = gridView_.comm().max(boundingBoxMax_[i]);
         }
 
-        if (enableVtkOutput_())
+        if (enableVtkOutput_()) {
             defaultVtkWriter_ = new VtkMultiWriter(gridView_, asImp_().name());
+            if (EWOMS_GET_PARAM(TypeTag, bool, EnableAsyncVtkOutput))
+                defaultVtkWriter_->setAsynchronous(EWOMS_GET_PARAM(TypeTag, unsigned, MaxPendingVtkOutputs));
+        }
     }
 
     ~FvBaseProblem()
@@ -345,7 +348,7 @@ public:
         Scalar setupTime = simulator().setupTimer().realTimeElapsed();
         Scalar prePostProcessTime = simulator().prePostProcessTimer().realTimeElapsed();
         Scalar localCpuTime = executionTimer.cpuTimeElapsed();
-        Scalar globalCpuTime = executionTimer.globalCpuTimeElapsed();
+        Scalar globalCpuTime = executionTimer.globalCpuTimeElapsed(this->gridView().comm());
         Scalar writeTime = simulator().writeTimer().realTimeElapsed();
         Scalar linearizeTime = simulator().linearizeTimer().realTimeElapsed();
         Scalar solveTime = simulator().solveTimer().realTimeElapsed();
@@ -407,6 +410,7 @@ public:
             simulator().setTimeStepSize(minTimeStepSize);
         }
 
+        asImp_().saveTimeStepSnapshot();
         for (unsigned i = 0; i < maxFails; ++i) {
             bool converged = model().update();
             if (converged)
@@ -417,6 +421,7 @@ public:
             if (nextDt < minTimeStepSize)
                 break; // give up: we can't make the time step smaller anymore!
             simulator().setTimeStepSize(nextDt);
+            asImp_().restoreTimeStepSnapshot();
 
             // update failed
             if (gridView().comm().rank() == 0)
@@ -431,6 +436,26 @@ public:
                    << simulator().timeStepSize());
     }
 
+    /*!
+     * \brief Save the state which is required to retry the current time step.
+     *
+     * This method is called by timeIntegration() before the first attempt to solve
+     * the time step. Problems which modify their internal state while a time step is
+     * computed should overload this method and call the one of the base class.
+     */
+    void saveTimeStepSnapshot()
+    { model().saveTimeStepSnapshot(); }
+
+    /*!
+     * \brief Restore the state which was saved by saveTimeStepSnapshot().
+     *
+     * This method is called by timeIntegration() if an attempt to solve the time step
+     * failed and after the time step size has been reduced. At this point, the model
+     * has already been restored by its updateFailed() method.
+     */
+    void restoreTimeStepSnapshot()
+    { }
+
     /*!
      * \brief Called by Ewoms::Simulator whenever a solution for a
      *        time step has been computed and the simulation time has
@@ -104,6 +104,23 @@ NEW_PROP_TAG(LocalLinearizer);
 //! skipped
 NEW_PROP_TAG(LinearizeNonLocalElements);
 
+/*!
+ * \brief Specify whether the linearizer should only store the diagonal blocks of the
+ *        Jacobian matrix and provide the remaining ones to the linear solver "matrix
+ *        free".
+ *
+ * This property is usually set by the linear solver backend.
+ */
+NEW_PROP_TAG(EnableMatrixFreeLinearization);
+
+/*!
+ * \brief Specify whether the linearizer should accumulate the time spent for linearizing
+ *        each element.
+ *
+ * The result can be used to weight the elements when the grid is distributed.
+ */
+NEW_PROP_TAG(MeasureElementCosts);
+
 //! Linearizes the global non-linear system of equations
 NEW_PROP_TAG(BaseLinearizer);
 //! Type of the global jacobian matrix
@@ -161,6 +178,8 @@ NEW_PROP_TAG(GridCommHandleFactory);
  */
 NEW_PROP_TAG(ThreadManager);
 NEW_PROP_TAG(ThreadsPerProcess);
+NEW_PROP_TAG(ThreadAffinity);
+NEW_PROP_TAG(CheckMemoryBandwidth);
 
 //! use locking to prevent race conditions when linearizing the global system of
 //! equations in multi-threaded mode. (setting this property to true is always save, but
@@ -189,6 +208,16 @@ NEW_PROP_TAG(EnableGridAdaptation);
  */
 NEW_PROP_TAG(EnableVtkOutput);
 
+/*!
+ * \brief Specify whether the VTK files should be written by a separate thread
+ *
+ * In this case, the simulation continues while the data of a time step is written to
+ * disk. The number of time steps which may be pending is limited by the
+ * MaxPendingVtkOutputs property.
+ */
+NEW_PROP_TAG(EnableAsyncVtkOutput);
+NEW_PROP_TAG(MaxPendingVtkOutputs);
+
 /*!
  * \brief Specify the format the VTK output is written to disk
  *
@@ -197,6 +226,8 @@ NEW_PROP_TAG(EnableVtkOutput);
  *   - Dune::VTK::base64
  *   - Dune::VTK::appendedraw
  *   - Dune::VTK::appendedbase64
+ *   - Ewoms::VtkCompressedFormat::appendedZlib (requires zlib)
+ *   - Ewoms::VtkCompressedFormat::appendedLz4 (requires LZ4)
  */
 NEW_PROP_TAG(VtkOutputFormat);
 
@@ -82,6 +82,33 @@ public:
         typedef GridCommHandleSum<ValueType, ArrayType,  DofMapper, /*commCodim=*/0> Handle;
         return  std::shared_ptr<Handle>(new Handle(array, dofMapper));
     }
+
+    /*!
+     * \brief Return a handle which sets the values of the ghost and overlap degrees of
+     *        freedom to the ones of their respective master processes.
+     */
+    template <class ValueType, class ArrayType>
+    static std::shared_ptr<GridCommHandleGhostSync<ValueType, ArrayType,  DofMapper, /*commCodim=*/0> >
+    ghostSyncHandle(ArrayType& array, const DofMapper& dofMapper)
+    {
+        typedef GridCommHandleGhostSync<ValueType, ArrayType,  DofMapper, /*commCodim=*/0> Handle;
+        return  std::shared_ptr<Handle>(new Handle(array, dofMapper));
+    }
+
+    /*!
+     * \brief Return a handle which exchanges multiple fields of the degrees of freedom
+     *        at once.
+     *
+     * The fields are added to the returned handle using its addSum(), addMax(),
+     * addMin() and addGhostSync() methods.
+     */
+    template <class ValueType>
+    static std::shared_ptr<GridCommHandleBatch<ValueType, DofMapper, /*commCodim=*/0> >
+    batchHandle(const DofMapper& dofMapper)
+    {
+        typedef GridCommHandleBatch<ValueType, DofMapper, /*commCodim=*/0> Handle;
+        return  std::shared_ptr<Handle>(new Handle(dofMapper));
+    }
 };
 } // namespace Ewoms
 
@@ -0,0 +1,207 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::AsyncWriter
+ */
+#ifndef EWOMS_ASYNC_WRITER_HH
+#define EWOMS_ASYNC_WRITER_HH
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Ewoms {
+/*!
+ * \brief Processes the jobs of an output writer in a dedicated thread.
+ *
+ * The jobs are processed in the order in which they were submitted. If more than a
+ * given number of jobs are pending, submit() waits until the oldest one has been
+ * processed, i.e., the memory used for buffering the output is bounded if the disk
+ * cannot keep up with the simulation.
+ *
+ * Exceptions thrown while processing a job are caught by the writer thread and
+ * re-thrown on the thread which calls submit(), rethrowException() or
+ * waitForPendingJobs() next.
+ */
+template <class Job>
+class AsyncWriter
+{
+public:
+    typedef std::function<void(Job&)> JobHandler;
+
+    AsyncWriter()
+        : maxPendingJobs_(0)
+        , stopThread_(false)
+        , busy_(false)
+    {}
+
+    ~AsyncWriter()
+    { stop(); }
+
+    /*!
+     * \brief Start the writer thread.
+     *
+     * \param maxPendingJobs The maximum number of jobs which are not yet processed.
+     * \param handler The function which is called by the writer thread for each job.
+     *
+     * If the thread is already running, only the maximum number of pending jobs is
+     * changed.
+     */
+    void start(unsigned maxPendingJobs, JobHandler handler)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        maxPendingJobs_ = std::max(1u, maxPendingJobs);
+        if (thread_.joinable())
+            return;
+
+        handler_ = handler;
+        stopThread_ = false;
+        thread_ = std::thread([this]() { this->threadMain_(); });
+    }
+
+    /*!
+     * \brief Process all pending jobs and terminate the writer thread.
+     *
+     * Exceptions of the remaining jobs are discarded.
+     */
+    void stop()
+    {
+        if (!thread_.joinable())
+            return;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stopThread_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    /*!
+     * \brief Returns true if the writer thread is running.
+     */
+    bool isRunning() const
+    { return thread_.joinable(); }
+
+    /*!
+     * \brief Hand a job over to the writer thread.
+     *
+     * If the maximum number of pending jobs is reached, this method waits until the
+     * oldest one has been processed.
+     */
+    void submit(std::unique_ptr<Job> job)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return queue_.size() < maxPendingJobs_; });
+        rethrowException_();
+        queue_.push_back(std::move(job));
+        lock.unlock();
+        cond_.notify_all();
+    }
+
+    /*!
+     * \brief Wait until all pending jobs have been processed.
+     *
+     * If processing one of them failed, the exception is re-thrown here.
+     */
+    void waitForPendingJobs() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return queue_.empty() && !busy_; });
+        rethrowException_();
+    }
+
+    /*!
+     * \brief Re-throw the exception of a job that failed without waiting for the
+     *        pending ones.
+     */
+    void rethrowException() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rethrowException_();
+    }
+
+private:
+    // must be called with the mutex locked
+    void rethrowException_() const
+    {
+        if (exception_) {
+            std::exception_ptr e = exception_;
+            exception_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    void threadMain_()
+    {
+        while (true) {
+            std::unique_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return stopThread_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return; // stopThread_ is true and all jobs have been processed
+
+                job = std::move(queue_.front());
+                queue_.pop_front();
+                busy_ = true;
+            }
+
+            try {
+                handler_(*job);
+            }
+            catch (...) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                exception_ = std::current_exception();
+            }
+            job.reset();
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                busy_ = false;
+            }
+            cond_.notify_all();
+        }
+    }
+
+    JobHandler handler_;
+    unsigned maxPendingJobs_;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cond_;
+    std::deque<std::unique_ptr<Job> > queue_;
+    bool stopThread_;
+    bool busy_;
+    mutable std::exception_ptr exception_;
+};
+} // namespace Ewoms
+
+#endif
@@ -30,7 +30,12 @@
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Unused.hpp>
+#include <opm/common/Exceptions.hpp>
+
 #include <dune/common/version.hh>
+#include <dune/common/parallel/mpihelper.hh>
 
 #if HAVE_DUNE_FEM
 #include <dune/fem/space/common/dofmanager.hh>
@@ -38,6 +43,7 @@
 
 #include <type_traits>
 #include <memory>
+#include <cstdint>
 
 namespace Ewoms {
 namespace Properties {
@@ -110,6 +116,27 @@ public:
     }
 
 
+    /*!
+     * \brief Returns true if globalEntityIndex() can be used for the entities of a given
+     *        codimension.
+     *
+     * By default, this is the case if the global ids of the grid are integers.
+     */
+    template <int codim>
+    bool hasGlobalEntityIndices() const
+    { return std::is_integral<typename Grid::GlobalIdSet::IdType>::value; }
+
+    /*!
+     * \brief Returns an index of an entity which does not depend on the distribution of
+     *        the grid over the processes.
+     *
+     * This is used to write restart files which can be read using a different number of
+     * processes.
+     */
+    template <class Entity>
+    uint64_t globalEntityIndex(const Entity& entity) const
+    { return globalIdToIndex_(asImp_().grid().globalIdSet().id(entity)); }
+
     /*!
      * \brief Distribute the grid (and attached data) over all
      *        processes.
@@ -121,6 +148,10 @@ public:
     }
 
 protected:
+    // returns the MPI communicator on which the grid should be created
+    Dune::MPIHelper::MPICommunicator communicator_() const
+    { return simulator_.communicator(); }
+
     // this method should be called after the grid has been allocated
     void finalizeInit_()
     {
@@ -142,6 +173,19 @@ protected:
     }
 
 private:
+    template <class Id>
+    static typename std::enable_if<std::is_integral<Id>::value, uint64_t>::type
+    globalIdToIndex_(const Id& id)
+    { return static_cast<uint64_t>(id); }
+
+    template <class Id>
+    static typename std::enable_if<!std::is_integral<Id>::value, uint64_t>::type
+    globalIdToIndex_(const Id& id OPM_UNUSED)
+    {
+        OPM_THROW(std::logic_error,
+                  "The global ids of the grid cannot be converted to global indices");
+    }
+
     Implementation& asImp_()
     { return *static_cast<Implementation*>(this); }
 
@@ -87,7 +87,7 @@ public:
 
         {
             // create DGF GridPtr from a dgf file
-            Dune::GridPtr< Grid > dgfPointer( dgfFileName );
+            Dune::GridPtr< Grid > dgfPointer( dgfFileName, this->communicator_() );
 
             // this is only implemented for 2d currently
             addFractures_( dgfPointer );
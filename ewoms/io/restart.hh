@@ -30,18 +30,133 @@
 #include <opm/common/Exceptions.hpp>
 #include <opm/common/ErrorMacros.hpp>
 
+#include <dune/grid/common/gridenums.hh>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <sstream>
+#include <streambuf>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
 
 namespace Ewoms {
 
 /*!
  * \brief Load or save a state of a problem to/from the harddisk.
+ *
+ * Restart files can either be written as text or in a binary format. Text files are
+ * human readable and thus useful for debugging, but they are large and slow to write
+ * and to read. A binary restart file consists of a fixed size header, the payload of
+ * all sections and a table which stores the names, offsets and sizes of the
+ * sections. The header contains the offset of the section table and a checksum of
+ * everything which follows the header. The data of the grid entities is stored as one
+ * contiguous array of fixed size records per section, i.e., the primary variables are
+ * stored as raw values in the native byte order (which is checked when reading the
+ * file) and the meaning of the primary variables is appended as integers. Binary files
+ * are read via a memory mapping.
+ *
+ * Each process writes one file. For text files, the simulation can only be restarted
+ * using the same domain decomposition. In binary files, each process only stores the
+ * entities which it owns, sorted by a global index provided by the grid manager, i.e.,
+ * the files of all processes are shards of a global checkpoint which can be read using
+ * any number of processes: After the grid has been distributed, each process looks up
+ * the records of its entities in the shard of the same rank first and only maps the
+ * other shards whose range of global indices contains missing entities. If the grid
+ * does not provide global indices, the entities are stored in the order of the local
+ * grid view and a restart is only possible with the same domain decomposition. All other sections are read
+ * from the file of the process with the same rank, or from the one of the first
+ * process if no such file exists. Their readers thus must cope with the sections of
+ * the first process, and a section which is not consumed completely is an error.
+ *
+ * The format of a file which ought to be read is detected automatically.
  */
 class Restart
 {
+    static const char* binaryMagic_()
+    { return "EWOMSRST"; }
+
+    enum {
+        binaryVersion_ = 2,
+        endiannessMarker_ = 0x01020304
+    };
+
+    // the ways in which the entities of a section can be stored
+    enum {
+        localEntityLayout_ = 0,
+        globalEntityLayout_ = 1
+    };
+
+    // magic (8 bytes), version, endianness marker, shard index, number of shards,
+    // number of sections, offset of the section table and the checksum
+    static size_t binaryHeaderSize_()
+    { return 8 + 4*sizeof(uint32_t) + 3*sizeof(uint64_t); }
+
+    // number of entities, size of a record and the layout
+    static size_t entitySectionHeaderSize_()
+    { return 3*sizeof(uint64_t); }
+
+    /*!
+     * \brief A read-only stream buffer for a memory range which avoids copying the
+     *        sections of memory mapped files.
+     */
+    class MemoryStreamBuf_ : public std::streambuf
+    {
+    public:
+        void setRange(const char* begin, const char* end)
+        {
+            char* b = const_cast<char*>(begin);
+            setg(b, b, const_cast<char*>(end));
+        }
+    };
+
+    struct BinarySection_
+    {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    /*!
+     * \brief A memory mapped binary restart file.
+     */
+    struct MappedShard_
+    {
+        std::string fileName;
+        const char* data = nullptr;
+        size_t size = 0;
+        uint32_t shardIdx = 0;
+        uint32_t numShards = 0;
+        uint64_t checksum = 0;
+        std::vector<BinarySection_> sections;
+    };
+
+    /*!
+     * \brief Update a 64 bit FNV-1a hash by a chunk of data.
+     */
+    static uint64_t checksum_(uint64_t hash, const char* data, size_t size)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static uint64_t checksumInit_()
+    { return 14695981039346656037ULL; }
+
     /*!
      * \brief Create a magic cookie for restart files, so that it is
      *        unlikely to load a restart file for an incorrectly.
@@ -69,42 +184,114 @@ class Restart
         return oss.str();
     }
 
+    /*!
+     * \brief Create the magic cookie for binary restart files.
+     *
+     * In contrast to magicRestartCookie_(), this cookie does not depend on the domain
+     * decomposition. Note that this method must be called collectively.
+     */
+    template <class GridView>
+    static const std::string binaryRestartCookie_(const GridView& gridView)
+    {
+        static const std::string gridName = "blubb"; // gridView.grid().name();
+
+        long numInteriorElements = 0;
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt)
+            if (elemIt->partitionType() == Dune::InteriorEntity)
+                ++ numInteriorElements;
+        numInteriorElements = gridView.comm().sum(numInteriorElements);
+
+        std::ostringstream oss;
+        oss << "eWoms restart file: "
+            << "gridName='" << gridName << "' "
+            << "numElements=" << numInteriorElements;
+        return oss.str();
+    }
+
     /*!
      * \brief Return the restart file name.
      */
-    template <class GridView, class Scalar>
-    static const std::string restartFileName_(const GridView& gridView,
-                                              const std::string& simName,
-                                              Scalar t)
+    template <class Scalar>
+    static const std::string restartFileName_(const std::string& simName,
+                                              Scalar t,
+                                              int rank)
     {
-        int rank = gridView.comm().rank();
         std::ostringstream oss;
         oss << simName << "_time=" << t << "_rank=" << rank << ".ers";
         return oss.str();
     }
 
 public:
+    /*!
+     * \brief The on-disk formats of restart files.
+     */
+    enum class Format
+    { Text, Binary };
+
+    /*!
+     * \brief Create a restart object.
+     *
+     * \param format The format used for writing restart files. The format of files which
+     *               are read is determined automatically.
+     */
+    explicit Restart(Format format = Format::Text)
+        : format_(format)
+    {}
+
+    ~Restart()
+    { unmapShards_(); }
+
     /*!
      * \brief Returns the name of the file which is (de-)serialized.
      */
     const std::string& fileName() const
     { return fileName_; }
 
+    /*!
+     * \brief Returns the format of the file which is currently (de-)serialized.
+     */
+    Format format() const
+    { return format_; }
+
     /*!
      * \brief Write the current state of the model to disk.
      */
     template <class Simulator>
     void serializeBegin(Simulator& simulator)
     {
-        const std::string magicCookie = magicRestartCookie_(simulator.gridView());
-        fileName_ = restartFileName_(simulator.gridView(),
-                                     simulator.problem().name(),
-                                     simulator.time());
+        const auto& gridView = simulator.gridView();
+        rank_ = gridView.comm().rank();
+        fileName_ = restartFileName_(simulator.problem().name(), simulator.time(), rank_);
 
         // open output file and write magic cookie
-        outStream_.open(fileName_.c_str());
+        std::string magicCookie;
+        if (format_ == Format::Binary) {
+            magicCookie = binaryRestartCookie_(gridView);
+            numOutShards_ = static_cast<uint32_t>(gridView.comm().size());
+
+            outStream_.open(fileName_.c_str(), std::ios::out | std::ios::binary);
+
+            // reserve space for the header. it is written by serializeEnd().
+            const std::vector<char> dummyHeader(binaryHeaderSize_(), 0);
+            outStream_.write(dummyHeader.data(), static_cast<std::streamsize>(dummyHeader.size()));
+            outOffset_ = binaryHeaderSize_();
+            outChecksum_ = checksumInit_();
+            outSections_.clear();
+
+            sectionOutStream_.precision(20);
+        }
+        else {
+            magicCookie = magicRestartCookie_(gridView);
+            outStream_.open(fileName_.c_str());
+        }
         outStream_.precision(20);
 
+        if (!outStream_.good())
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName_
+                      << "' could not be opened for writing");
+
         serializeSectionBegin(magicCookie);
         serializeSectionEnd();
     }
@@ -113,19 +300,39 @@ public:
      * \brief The output stream to write the serialized data.
      */
     std::ostream& serializeStream()
-    { return outStream_; }
+    {
+        if (format_ == Format::Binary)
+            return sectionOutStream_;
+        return outStream_;
+    }
 
     /*!
      * \brief Start a new section in the serialized output.
      */
     void serializeSectionBegin(const std::string& cookie)
-    { outStream_ << cookie << "\n"; }
+    {
+        if (format_ == Format::Binary) {
+            curSectionName_ = cookie;
+            sectionOutStream_.str("");
+            sectionOutStream_.clear();
+        }
+        else
+            outStream_ << cookie << "\n";
+    }
 
     /*!
      * \brief End of a section in the serialized output.
      */
     void serializeSectionEnd()
-    { outStream_ << "\n"; }
+    {
+        if (format_ == Format::Binary) {
+            const std::string& data = sectionOutStream_.str();
+            writeBinarySection_(curSectionName_, data.data(), data.size());
+            sectionOutStream_.str("");
+        }
+        else
+            outStream_ << "\n";
+    }
 
     /*!
      * \brief Serialize all leaf entities of a codim in a gridView.
@@ -138,6 +345,12 @@ public:
         std::ostringstream oss;
         oss << "Entities: Codim " << codim;
         std::string cookie = oss.str();
+
+        if (format_ == Format::Binary) {
+            serializeEntitiesBinary_<codim>(cookie, serializer, gridView);
+            return;
+        }
+
         serializeSectionBegin(cookie);
 
         // write element data
@@ -157,16 +370,68 @@ public:
      * \brief Finish the restart file.
      */
     void serializeEnd()
-    { outStream_.close(); }
+    {
+        if (format_ == Format::Binary) {
+            // write the section table
+            std::ostringstream tableStream(std::ios::out | std::ios::binary);
+            for (const auto& section : outSections_) {
+                uint32_t nameLen = static_cast<uint32_t>(section.name.size());
+                tableStream.write(reinterpret_cast<const char*>(&nameLen), sizeof(nameLen));
+                tableStream.write(section.name.data(), nameLen);
+                tableStream.write(reinterpret_cast<const char*>(&section.offset), sizeof(section.offset));
+                tableStream.write(reinterpret_cast<const char*>(&section.size), sizeof(section.size));
+            }
+            const std::string& table = tableStream.str();
+            uint64_t tableOffset = outOffset_;
+            writeRaw_(table.data(), table.size());
+
+            // write the header
+            uint32_t version = binaryVersion_;
+            uint32_t endianness = endiannessMarker_;
+            uint32_t shardIdx = static_cast<uint32_t>(rank_);
+            uint64_t numSections = outSections_.size();
+            outStream_.seekp(0, std::ios::beg);
+            outStream_.write(binaryMagic_(), 8);
+            outStream_.write(reinterpret_cast<const char*>(&version), sizeof(version));
+            outStream_.write(reinterpret_cast<const char*>(&endianness), sizeof(endianness));
+            outStream_.write(reinterpret_cast<const char*>(&shardIdx), sizeof(shardIdx));
+            outStream_.write(reinterpret_cast<const char*>(&numOutShards_), sizeof(numOutShards_));
+            outStream_.write(reinterpret_cast<const char*>(&numSections), sizeof(numSections));
+            outStream_.write(reinterpret_cast<const char*>(&tableOffset), sizeof(tableOffset));
+            outStream_.write(reinterpret_cast<const char*>(&outChecksum_), sizeof(outChecksum_));
+
+            if (!outStream_.good())
+                OPM_THROW(std::runtime_error, "Could not write restart file '" << fileName_ << "'");
+        }
+
+        outStream_.close();
+    }
 
     /*!
      * \brief Start reading a restart file at a certain simulated
      *        time.
+     *
+     * This method must be called collectively by all processes.
      */
     template <class Simulator, class Scalar>
     void deserializeBegin(Simulator& simulator, Scalar t)
     {
-        fileName_ = restartFileName_(simulator.gridView(), simulator.problem().name(), t);
+        const auto& gridView = simulator.gridView();
+        const std::string& simName = simulator.problem().name();
+        rank_ = gridView.comm().rank();
+        fileName_ = restartFileName_(simName, t, rank_);
+
+        // the file of the first process always exists, independent of the number of
+        // processes which wrote the restart file
+        if (isBinaryFile_(restartFileName_(simName, t, /*rank=*/0))) {
+            format_ = Format::Binary;
+            mapShards_(gridView, simName, t);
+
+            deserializeSectionBegin(binaryRestartCookie_(gridView));
+            deserializeSectionEnd();
+            return;
+        }
+        format_ = Format::Text;
 
         // open input file and read magic cookie
         inStream_.open(fileName_.c_str());
@@ -184,7 +449,7 @@ public:
         }
         inStream_.seekg(0, std::ios::beg);
 
-        const std::string magicCookie = magicRestartCookie_(simulator.gridView());
+        const std::string magicCookie = magicRestartCookie_(gridView);
 
         deserializeSectionBegin(magicCookie);
         deserializeSectionEnd();
@@ -195,13 +460,33 @@ public:
      *        deserialized.
      */
     std::istream& deserializeStream()
-    { return inStream_; }
+    {
+        if (format_ == Format::Binary)
+            return sectionInStream_;
+        return inStream_;
+    }
 
     /*!
      * \brief Start reading a new section of the restart file.
+     *
+     * For binary files, the sections which are not entity data are read from the file
+     * written by the process of the same rank. Processes for which no such file exists
+     * read the sections of the first process, so these sections must be global.
      */
     void deserializeSectionBegin(const std::string& cookie)
     {
+        if (format_ == Format::Binary) {
+            const MappedShard_& shard = shards_[sectionShardIdx_];
+            const BinarySection_& section = shardSection_(sectionShardIdx_, curInSectionIdx_, cookie);
+            ++ curInSectionIdx_;
+
+            sectionInBuf_.setRange(shard.data + section.offset,
+                                   shard.data + section.offset + section.size);
+            sectionInStream_.rdbuf(&sectionInBuf_);
+            sectionInStream_.clear();
+            return;
+        }
+
         if (!inStream_.good())
             OPM_THROW(std::runtime_error,
                       "Encountered unexpected EOF in restart file.");
@@ -217,6 +502,28 @@ public:
      */
     void deserializeSectionEnd()
     {
+        if (format_ == Format::Binary) {
+            // the remainder of the section must only consist of whitespace. this is
+            // also checked if the section was written by another process: if its
+            // layout depended on the rank, the values which were read are garbage.
+            const MappedShard_& shard = shards_[sectionShardIdx_];
+            const std::string& sectionName = shard.sections[curInSectionIdx_ - 1].name;
+            if (sectionInStream_.fail())
+                OPM_THROW(std::logic_error,
+                          "Section '" << sectionName << "' of restart file '"
+                          << shard.fileName << "' is too short");
+            sectionInStream_.clear();
+            int c;
+            while ((c = sectionInStream_.get()) != std::char_traits<char>::eof()) {
+                if (!std::isspace(c))
+                    OPM_THROW(std::logic_error,
+                              "Encountered unread values while deserializing section '"
+                              << sectionName << "' of restart file '" << shard.fileName << "'");
+            }
+            sectionInStream_.clear();
+            return;
+        }
+
         std::string dummy;
         std::getline(inStream_, dummy);
         for (unsigned i = 0; i < dummy.length(); ++i) {
@@ -238,6 +545,12 @@ public:
         std::ostringstream oss;
         oss << "Entities: Codim " << codim;
         std::string cookie = oss.str();
+
+        if (format_ == Format::Binary) {
+            deserializeEntitiesBinary_<codim>(cookie, deserializer, gridView);
+            return;
+        }
+
         deserializeSectionBegin(cookie);
 
         std::string curLine;
@@ -263,12 +576,531 @@ public:
      * \brief Stop reading the restart file.
      */
     void deserializeEnd()
-    { inStream_.close(); }
+    {
+        if (format_ == Format::Binary) {
+            if (curInSectionIdx_ != shards_[sectionShardIdx_].sections.size())
+                OPM_THROW(std::logic_error,
+                          "Restart file '" << fileName_ << "' contains unread sections");
+            unmapShards_();
+            return;
+        }
+
+        inStream_.close();
+    }
 
 private:
+    /*!
+     * \brief Write the entities of a codimension as an array of fixed size records.
+     *
+     * The serializer must provide the binaryEntitySize(), serializeEntityBinary(),
+     * hasGlobalEntityIndices() and globalEntityIndex() methods.
+     */
+    template <int codim, class Serializer, class GridView>
+    void serializeEntitiesBinary_(const std::string& cookie,
+                                  Serializer& serializer,
+                                  const GridView& gridView)
+    {
+        const uint64_t recordSize = static_cast<uint64_t>(serializer.binaryEntitySize());
+        const size_t headerSize = entitySectionHeaderSize_();
+        typedef typename GridView::template Codim<codim>::Iterator Iterator;
+
+        if (!serializer.template hasGlobalEntityIndices<codim>()) {
+            // store all entities of the local grid view in their natural order
+            uint64_t numEntities = static_cast<uint64_t>(gridView.size(codim));
+            uint64_t layout = localEntityLayout_;
+
+            std::vector<char> buffer(headerSize + numEntities*recordSize);
+            writeEntitySectionHeader_(buffer.data(), numEntities, recordSize, layout);
+
+            char* record = buffer.data() + headerSize;
+            Iterator it = gridView.template begin<codim>();
+            const Iterator& endIt = gridView.template end<codim>();
+            for (; it != endIt; ++it, record += recordSize)
+                serializer.serializeEntityBinary(record, *it);
+
+            writeBinarySection_(cookie, buffer.data(), buffer.size());
+            return;
+        }
+
+        // only store the entities owned by the local process, sorted by their global
+        // index. entities on the process borders are stored by all adjacent processes.
+        std::vector<uint64_t> globalIndices;
+        std::vector<char> records;
+        Iterator it = gridView.template begin<codim>();
+        const Iterator& endIt = gridView.template end<codim>();
+        for (; it != endIt; ++it) {
+            auto partitionType = it->partitionType();
+            if (partitionType != Dune::InteriorEntity && partitionType != Dune::BorderEntity)
+                continue;
+
+            globalIndices.push_back(serializer.globalEntityIndex(*it));
+            records.resize(records.size() + recordSize);
+            serializer.serializeEntityBinary(records.data() + records.size() - recordSize, *it);
+        }
+
+        uint64_t numEntities = globalIndices.size();
+        std::vector<size_t> order(numEntities);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                  [&globalIndices](size_t a, size_t b)
+                  { return globalIndices[a] < globalIndices[b]; });
+
+        std::vector<char> buffer(headerSize + numEntities*(sizeof(uint64_t) + recordSize));
+        writeEntitySectionHeader_(buffer.data(), numEntities, recordSize, globalEntityLayout_);
+        char* indexPtr = buffer.data() + headerSize;
+        char* recordPtr = indexPtr + numEntities*sizeof(uint64_t);
+        for (size_t i = 0; i < numEntities; ++i) {
+            std::memcpy(indexPtr + i*sizeof(uint64_t), &globalIndices[order[i]], sizeof(uint64_t));
+            std::memcpy(recordPtr + i*recordSize, records.data() + order[i]*recordSize, recordSize);
+        }
+
+        writeBinarySection_(cookie, buffer.data(), buffer.size());
+    }
+
+    /*!
+     * \brief Read the entities of a codimension from arrays of fixed size records.
+     *
+     * The deserializer must provide the binaryEntitySize(), deserializeEntityBinary()
+     * and globalEntityIndex() methods.
+     */
+    template <int codim, class Deserializer, class GridView>
+    void deserializeEntitiesBinary_(const std::string& cookie,
+                                    Deserializer& deserializer,
+                                    const GridView& gridView)
+    {
+        const size_t sectionIdx = curInSectionIdx_++;
+        const size_t headerSize = entitySectionHeaderSize_();
+        typedef typename GridView::template Codim<codim>::Iterator Iterator;
+
+        uint64_t numEntities, recordSize, layout;
+        const BinarySection_& ownSection = shardSection_(sectionShardIdx_, sectionIdx, cookie);
+        readEntitySectionHeader_(shards_[sectionShardIdx_], ownSection,
+                                 deserializer.binaryEntitySize(),
+                                 numEntities, recordSize, layout);
+
+        if (layout == localEntityLayout_) {
+            if (static_cast<int>(sectionShardIdx_) != rank_
+                || shards_.size() != static_cast<size_t>(gridView.comm().size()))
+                OPM_THROW(std::runtime_error,
+                          "The restart file does not contain global indices for the entities"
+                          " of codimension " << codim << ". It can only be read using the"
+                          " same domain decomposition.");
+            if (numEntities != static_cast<uint64_t>(gridView.size(codim)))
+                OPM_THROW(std::runtime_error,
+                          "Restart file contains " << numEntities << " entities of codimension "
+                          << codim << " but the grid has " << gridView.size(codim));
+
+            const char* record = shards_[sectionShardIdx_].data + ownSection.offset + headerSize;
+            Iterator it = gridView.template begin<codim>();
+            const Iterator& endIt = gridView.template end<codim>();
+            for (; it != endIt; ++it, record += recordSize)
+                deserializer.deserializeEntityBinary(record, *it);
+            return;
+        }
+
+        // determine the global indices of the local entities and visit them in
+        // ascending order, so that the shards can be searched incrementally
+        std::vector<uint64_t> globalIndices;
+        globalIndices.reserve(static_cast<size_t>(gridView.size(codim)));
+        Iterator it = gridView.template begin<codim>();
+        const Iterator& endIt = gridView.template end<codim>();
+        for (; it != endIt; ++it)
+            globalIndices.push_back(deserializer.globalEntityIndex(*it));
+
+        std::vector<size_t> order(globalIndices.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                  [&globalIndices](size_t a, size_t b)
+                  { return globalIndices[a] < globalIndices[b]; });
+
+        // the range of global indices stored by each shard. each process determines
+        // the ranges of the shards which it has verified, so that no process needs to
+        // map all shards.
+        const size_t numShards = shards_.size();
+        const size_t commSize = static_cast<size_t>(gridView.comm().size());
+        std::vector<uint64_t> minIndex(numShards, std::numeric_limits<uint64_t>::max());
+        std::vector<uint64_t> maxIndex(numShards, 0);
+        for (size_t shardIdx = static_cast<size_t>(rank_); shardIdx < numShards; shardIdx += commSize) {
+            const uint64_t* indexBegin;
+            const uint64_t* indexEnd;
+            const char* shardRecords;
+            shardEntities_(shardIdx, sectionIdx, cookie, deserializer.binaryEntitySize(),
+                           indexBegin, indexEnd, shardRecords);
+            if (indexBegin != indexEnd) {
+                minIndex[shardIdx] = *indexBegin;
+                maxIndex[shardIdx] = *(indexEnd - 1);
+            }
+        }
+        gridView.comm().min(minIndex.data(), static_cast<int>(numShards));
+        gridView.comm().max(maxIndex.data(), static_cast<int>(numShards));
+
+        // look up the records in the shard of the local process first. if the domain
+        // decomposition did not change, it contains all of them. the other shards are
+        // only mapped if they may contain some of the missing entities. thanks to the
+        // memory mapping, only the pages which contain the records of the local
+        // entities are actually read.
+        std::vector<const char*> records(globalIndices.size(), nullptr);
+        size_t numMissing = globalIndices.size();
+        if (static_cast<size_t>(rank_) < numShards)
+            numMissing -= lookupRecords_(static_cast<size_t>(rank_), sectionIdx, cookie,
+                                         deserializer.binaryEntitySize(),
+                                         order, 0, order.size(), globalIndices, records);
+
+        for (size_t shardIdx = 0; shardIdx < numShards && numMissing > 0; ++shardIdx) {
+            if (shardIdx == static_cast<size_t>(rank_) || minIndex[shardIdx] > maxIndex[shardIdx])
+                continue;
+
+            // the local entities whose global index is in the range of the shard
+            auto lessIdx = [&globalIndices](size_t localIdx, uint64_t globalIdx)
+                           { return globalIndices[localIdx] < globalIdx; };
+            auto lessGlobalIdx = [&globalIndices](uint64_t globalIdx, size_t localIdx)
+                                 { return globalIdx < globalIndices[localIdx]; };
+            size_t first = static_cast<size_t>(std::lower_bound(order.begin(), order.end(),
+                                                                minIndex[shardIdx], lessIdx)
+                                               - order.begin());
+            size_t last = static_cast<size_t>(std::upper_bound(order.begin() + static_cast<std::ptrdiff_t>(first),
+                                                               order.end(),
+                                                               maxIndex[shardIdx], lessGlobalIdx)
+                                              - order.begin());
+
+            bool anyMissing = false;
+            for (size_t i = first; i < last && !anyMissing; ++i)
+                anyMissing = !records[order[i]];
+            if (!anyMissing)
+                continue;
+
+            numMissing -= lookupRecords_(shardIdx, sectionIdx, cookie,
+                                         deserializer.binaryEntitySize(),
+                                         order, first, last, globalIndices, records);
+        }
+
+        size_t localIdx = 0;
+        it = gridView.template begin<codim>();
+        for (; it != endIt; ++it, ++localIdx) {
+            if (!records[localIdx])
+                OPM_THROW(std::runtime_error,
+                          "The restart files do not contain the entity of codimension "
+                          << codim << " with global index " << globalIndices[localIdx]);
+            deserializer.deserializeEntityBinary(records[localIdx], *it);
+        }
+    }
+
+    /*!
+     * \brief Returns the global indices and the records of the entities which are
+     *        stored in a section of a shard.
+     *
+     * The shard is mapped into memory if necessary.
+     */
+    void shardEntities_(size_t shardIdx,
+                        size_t sectionIdx,
+                        const std::string& cookie,
+                        size_t entitySize,
+                        const uint64_t*& indexBegin,
+                        const uint64_t*& indexEnd,
+                        const char*& records)
+    {
+        const MappedShard_& shard = mappedShard_(shardIdx);
+        const BinarySection_& section = shardSection_(shardIdx, sectionIdx, cookie);
+
+        uint64_t numEntities, recordSize, layout;
+        readEntitySectionHeader_(shard, section, entitySize, numEntities, recordSize, layout);
+        if (layout != globalEntityLayout_)
+            OPM_THROW(std::runtime_error,
+                      "Restart file '" << shard.fileName << "' is inconsistent");
+
+        const char* sectionData = shard.data + section.offset + entitySectionHeaderSize_();
+        indexBegin = reinterpret_cast<const uint64_t*>(sectionData);
+        indexEnd = indexBegin + numEntities;
+        records = sectionData + numEntities*sizeof(uint64_t);
+    }
+
+    /*!
+     * \brief Look up the records of the entities order[first], ..., order[last - 1]
+     *        in a shard.
+     *
+     * The entries of 'order' must be sorted by their global indices. Entities which
+     * already have a record are skipped. Returns the number of records found.
+     */
+    size_t lookupRecords_(size_t shardIdx,
+                          size_t sectionIdx,
+                          const std::string& cookie,
+                          size_t entitySize,
+                          const std::vector<size_t>& order,
+                          size_t first,
+                          size_t last,
+                          const std::vector<uint64_t>& globalIndices,
+                          std::vector<const char*>& records)
+    {
+        const uint64_t* indexBegin;
+        const uint64_t* indexEnd;
+        const char* shardRecords;
+        shardEntities_(shardIdx, sectionIdx, cookie, entitySize,
+                       indexBegin, indexEnd, shardRecords);
+
+        size_t numFound = 0;
+        const uint64_t* pos = indexBegin;
+        for (size_t i = first; i < last; ++i) {
+            size_t localIdx = order[i];
+            if (records[localIdx])
+                continue;
+
+            pos = std::lower_bound(pos, indexEnd, globalIndices[localIdx]);
+            if (pos == indexEnd)
+                break;
+            if (*pos == globalIndices[localIdx]) {
+                records[localIdx] = shardRecords + static_cast<size_t>(pos - indexBegin)*entitySize;
+                ++ numFound;
+            }
+        }
+        return numFound;
+    }
+
+    static void writeEntitySectionHeader_(char* buffer,
+                                          uint64_t numEntities,
+                                          uint64_t recordSize,
+                                          uint64_t layout)
+    {
+        std::memcpy(buffer, &numEntities, sizeof(numEntities));
+        std::memcpy(buffer + sizeof(uint64_t), &recordSize, sizeof(recordSize));
+        std::memcpy(buffer + 2*sizeof(uint64_t), &layout, sizeof(layout));
+    }
+
+    static void readEntitySectionHeader_(const MappedShard_& shard,
+                                         const BinarySection_& section,
+                                         size_t expectedRecordSize,
+                                         uint64_t& numEntities,
+                                         uint64_t& recordSize,
+                                         uint64_t& layout)
+    {
+        if (section.size < entitySectionHeaderSize_())
+            OPM_THROW(std::runtime_error, "Restart file '" << shard.fileName << "' is corrupted");
+
+        const char* data = shard.data + section.offset;
+        std::memcpy(&numEntities, data, sizeof(numEntities));
+        std::memcpy(&recordSize, data + sizeof(uint64_t), sizeof(recordSize));
+        std::memcpy(&layout, data + 2*sizeof(uint64_t), sizeof(layout));
+
+        if (recordSize != static_cast<uint64_t>(expectedRecordSize))
+            OPM_THROW(std::runtime_error,
+                      "Size of the entity records in the restart file (" << recordSize
+                      << " bytes) does not match the model (" << expectedRecordSize
+                      << " bytes)");
+
+        uint64_t indexSize = (layout == globalEntityLayout_) ? sizeof(uint64_t) : 0;
+        if (section.size != entitySectionHeaderSize_() + numEntities*(indexSize + recordSize))
+            OPM_THROW(std::runtime_error, "Restart file '" << shard.fileName << "' is corrupted");
+    }
+
+    void writeRaw_(const char* data, size_t size)
+    {
+        outStream_.write(data, static_cast<std::streamsize>(size));
+        outChecksum_ = checksum_(outChecksum_, data, size);
+        outOffset_ += size;
+    }
+
+    void writeBinarySection_(const std::string& name, const char* data, size_t size)
+    {
+        // align all sections to eight bytes, so that the arrays of global indices can be
+        // accessed directly in the memory mapped file
+        static const char padding[8] = { 0 };
+        if (outOffset_ % 8 != 0)
+            writeRaw_(padding, 8 - outOffset_ % 8);
+
+        outSections_.push_back(BinarySection_{name, outOffset_, size});
+        writeRaw_(data, size);
+    }
+
+    const BinarySection_& shardSection_(size_t shardIdx,
+                                        size_t sectionIdx,
+                                        const std::string& cookie) const
+    {
+        const MappedShard_& shard = shards_[shardIdx];
+        if (sectionIdx >= shard.sections.size())
+            OPM_THROW(std::runtime_error,
+                      "Encountered unexpected EOF in restart file.");
+
+        const BinarySection_& section = shard.sections[sectionIdx];
+        if (section.name != cookie)
+            OPM_THROW(std::runtime_error,
+                      "Could not start section '" << cookie << "'");
+        return section;
+    }
+
+    static bool isBinaryFile_(const std::string& fileName)
+    {
+        std::ifstream is(fileName.c_str(), std::ios::in | std::ios::binary);
+        char magic[8];
+        if (!is.read(magic, sizeof(magic)))
+            return false;
+        return std::memcmp(magic, binaryMagic_(), sizeof(magic)) == 0;
+    }
+
+    /*!
+     * \brief Open the shards of a binary restart file.
+     *
+     * Only the shards which are needed by the local process are mapped into memory:
+     * The one of the first process, the one written by the process of the same rank,
+     * and the ones whose checksums are verified by the local process. (each shard is
+     * read completely by exactly one process.) The remaining shards are mapped on
+     * demand if the local process owns entities which are stored in them.
+     */
+    template <class GridView, class Scalar>
+    void mapShards_(const GridView& gridView, const std::string& simName, Scalar t)
+    {
+        unmapShards_();
+
+        shards_.resize(1);
+        mapShard_(shards_[0], restartFileName_(simName, t, /*rank=*/0));
+        uint32_t numShards = shards_[0].numShards;
+        shards_.resize(numShards);
+        for (uint32_t shardIdx = 1; shardIdx < numShards; ++shardIdx)
+            shards_[shardIdx].fileName = restartFileName_(simName, t, static_cast<int>(shardIdx));
+
+        int corrupted = 0;
+        for (size_t shardIdx = static_cast<size_t>(rank_);
+             shardIdx < numShards;
+             shardIdx += static_cast<size_t>(gridView.comm().size()))
+        {
+            const MappedShard_& shard = mappedShard_(shardIdx);
+            uint64_t actualChecksum = checksum_(checksumInit_(),
+                                                shard.data + binaryHeaderSize_(),
+                                                shard.size - binaryHeaderSize_());
+            if (actualChecksum != shard.checksum) {
+                std::cerr << "Checksum of restart file '" << shard.fileName << "' does not match\n";
+                corrupted = 1;
+            }
+        }
+        corrupted = gridView.comm().max(corrupted);
+        if (corrupted)
+            OPM_THROW(std::runtime_error, "Corrupted restart file encountered");
+
+        sectionShardIdx_ = (static_cast<uint32_t>(rank_) < numShards) ? static_cast<size_t>(rank_) : 0;
+        fileName_ = shards_[sectionShardIdx_].fileName;
+        curInSectionIdx_ = 0;
+    }
+
+    /*!
+     * \brief Returns a shard of the binary restart file and maps it into memory if
+     *        this has not been done yet.
+     */
+    const MappedShard_& mappedShard_(size_t shardIdx)
+    {
+        MappedShard_& shard = shards_[shardIdx];
+        if (!shard.data) {
+            const std::string fileName = shard.fileName;
+            mapShard_(shard, fileName);
+            if (shard.numShards != shards_.size() || shard.shardIdx != shardIdx)
+                OPM_THROW(std::runtime_error,
+                          "Restart file '" << shard.fileName << "' does not belong to"
+                          " the same checkpoint as '" << shards_[0].fileName << "'");
+        }
+        return shard;
+    }
+
+    /*!
+     * \brief Map a binary restart file into memory, verify its header and read the
+     *        section table.
+     */
+    static void mapShard_(MappedShard_& shard, const std::string& fileName)
+    {
+        shard.fileName = fileName;
+
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName
+                      << "' could not be opened properly");
+
+        struct stat fileStat;
+        if (::fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < binaryHeaderSize_()) {
+            ::close(fd);
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName << "' is truncated");
+        }
+        size_t size = static_cast<size_t>(fileStat.st_size);
+
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName
+                      << "' could not be mapped into memory");
+        shard.data = static_cast<const char*>(addr);
+        shard.size = size;
+
+        // parse the header
+        const char* pos = shard.data;
+        if (std::memcmp(pos, binaryMagic_(), 8) != 0)
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName << "' is not binary");
+        pos += 8;
+
+        uint32_t version;
+        uint32_t endianness;
+        uint64_t numSections;
+        uint64_t tableOffset;
+        std::memcpy(&version, pos, sizeof(version)); pos += sizeof(version);
+        std::memcpy(&endianness, pos, sizeof(endianness)); pos += sizeof(endianness);
+        std::memcpy(&shard.shardIdx, pos, sizeof(shard.shardIdx)); pos += sizeof(shard.shardIdx);
+        std::memcpy(&shard.numShards, pos, sizeof(shard.numShards)); pos += sizeof(shard.numShards);
+        std::memcpy(&numSections, pos, sizeof(numSections)); pos += sizeof(numSections);
+        std::memcpy(&tableOffset, pos, sizeof(tableOffset)); pos += sizeof(tableOffset);
+        std::memcpy(&shard.checksum, pos, sizeof(shard.checksum));
+
+        if (version != static_cast<uint32_t>(binaryVersion_))
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName
+                      << "' uses the unsupported binary format version " << version);
+        if (endianness != static_cast<uint32_t>(endiannessMarker_))
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName
+                      << "' was written on a machine with a different byte order");
+        if (tableOffset < binaryHeaderSize_() || tableOffset > size || shard.numShards == 0)
+            OPM_THROW(std::runtime_error, "Restart file '" << fileName << "' is corrupted");
+
+        // read the section table
+        shard.sections.clear();
+        pos = shard.data + tableOffset;
+        const char* end = shard.data + size;
+        for (uint64_t i = 0; i < numSections; ++i) {
+            BinarySection_ section;
+            uint32_t nameLen;
+            if (static_cast<size_t>(end - pos) < sizeof(nameLen))
+                OPM_THROW(std::runtime_error, "Restart file '" << fileName << "' is corrupted");
+            std::memcpy(&nameLen, pos, sizeof(nameLen)); pos += sizeof(nameLen);
+            if (static_cast<size_t>(end - pos) < nameLen + 2*sizeof(uint64_t))
+                OPM_THROW(std::runtime_error, "Restart file '" << fileName << "' is corrupted");
+            section.name.assign(pos, nameLen); pos += nameLen;
+            std::memcpy(&section.offset, pos, sizeof(section.offset)); pos += sizeof(section.offset);
+            std::memcpy(&section.size, pos, sizeof(section.size)); pos += sizeof(section.size);
+            if (section.offset % 8 != 0 || section.offset + section.size > tableOffset)
+                OPM_THROW(std::runtime_error, "Restart file '" << fileName << "' is corrupted");
+            shard.sections.push_back(section);
+        }
+    }
+
+    void unmapShards_()
+    {
+        for (auto& shard : shards_)
+            if (shard.data)
+                ::munmap(const_cast<char*>(shard.data), shard.size);
+        shards_.clear();
+    }
+
+    Format format_;
     std::string fileName_;
+    int rank_ = 0;
     std::ifstream inStream_;
     std::ofstream outStream_;
+
+    // binary output
+    std::ostringstream sectionOutStream_{std::ios::out | std::ios::binary};
+    std::string curSectionName_;
+    std::vector<BinarySection_> outSections_;
+    uint64_t outOffset_ = 0;
+    uint64_t outChecksum_ = 0;
+    uint32_t numOutShards_ = 1;
+
+    // binary input
+    std::vector<MappedShard_> shards_;
+    size_t sectionShardIdx_ = 0;
+    size_t curInSectionIdx_ = 0;
+    MemoryStreamBuf_ sectionInBuf_;
+    std::istream sectionInStream_{nullptr};
 };
 } // namespace Ewoms
 
@@ -0,0 +1,619 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::VtkCompressedWriter
+ */
+#ifndef EWOMS_VTK_COMPRESSED_WRITER_HH
+#define EWOMS_VTK_COMPRESSED_WRITER_HH
+
+#include <opm/common/Unused.hpp>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/version.hh>
+#include <dune/geometry/referenceelements.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+#include <dune/grid/io/file/vtk/function.hh>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief The output formats of the VTK writer in addition to the ones specified by
+ *        Dune::VTK::OutputType.
+ *
+ * These can be used for the VtkOutputFormat property.
+ */
+namespace VtkCompressedFormat {
+enum {
+    //! Appended binary data which is compressed using zlib
+    appendedZlib = 16,
+
+    //! Appended binary data which is compressed using LZ4
+    appendedLz4 = 17
+};
+}
+
+/*!
+ * \brief Writes VTK files of unstructured grids where the data arrays are compressed.
+ *
+ * The data arrays are stored in the appended section of the file and are split into
+ * blocks of 32 kB, which are compressed independently by the OpenMP threads. Their
+ * number is the one of the thread which creates the writer, i.e., the same number of
+ * threads is used if the file is written by a separate thread. The files
+ * use the block header format of the VTK library (with 64 bit headers), i.e., they can
+ * be read by ParaView. (LZ4 requires ParaView 5.5 or newer.)
+ *
+ * Like Dune::VTKWriter in conforming mode, the interior elements of the grid view and
+ * their vertices are written. The interface of this class mirrors the parts of
+ * Dune::VTKWriter which are used by the VtkMultiWriter. No collective communication is
+ * done, so files can be written by a separate thread.
+ */
+template <class GridView, int compressedFormat>
+class VtkCompressedWriter
+{
+    enum { dim = GridView::dimension };
+    enum { dimWorld = GridView::dimensionworld };
+
+    typedef typename GridView::ctype ctype;
+    typedef typename GridView::template Codim<0>::Entity Element;
+
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView> VertexMapper;
+#else
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGVertexLayout> VertexMapper;
+#endif
+
+    typedef uint64_t HeaderType;
+
+    // the size of the uncompressed blocks. this is the default of the VTK library.
+    enum { blockSize_ = 32*1024 };
+
+    // a data array of the file before and after the compression
+    struct DataArray_
+    {
+        std::string name;
+        std::string type;
+        unsigned numComponents;
+        std::vector<char> rawData;
+
+        std::vector<std::vector<char> > compressedBlocks;
+        HeaderType offset;
+    };
+
+public:
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,5)
+    typedef std::shared_ptr< Dune::VTKFunction< GridView > > FunctionPtr;
+#else
+    typedef typename Dune::VTKWriter<GridView>::VTKFunctionPtr FunctionPtr;
+#endif
+
+    VtkCompressedWriter(const GridView& gridView)
+        : gridView_(gridView)
+#if DUNE_VERSION_NEWER(DUNE_GRID, 2,6)
+        , vertexMapper_(gridView, Dune::mcmgVertexLayout())
+#else
+        , vertexMapper_(gridView)
+#endif
+    {
+        // the ICVs of OpenMP are per thread, so the number of threads must be
+        // determined here if the file is written by a thread which is not managed by
+        // OpenMP
+#ifdef _OPENMP
+        numThreads_ = omp_get_max_threads();
+#else
+        numThreads_ = 1;
+#endif
+
+#if !HAVE_ZLIB
+        if (compressedFormat == VtkCompressedFormat::appendedZlib)
+            OPM_THROW(std::runtime_error,
+                      "zlib compressed VTK output requires the zlib library");
+#endif
+#if !HAVE_LZ4
+        if (compressedFormat == VtkCompressedFormat::appendedLz4)
+            OPM_THROW(std::runtime_error,
+                      "LZ4 compressed VTK output requires the LZ4 library");
+#endif
+    }
+
+    /*!
+     * \brief Add an element centered quantity to the output.
+     */
+    void addCellData(const FunctionPtr& fn)
+    { cellData_.push_back(fn); }
+
+    /*!
+     * \brief Add a vertex centered quantity to the output.
+     */
+    void addVertexData(const FunctionPtr& fn)
+    { vertexData_.push_back(fn); }
+
+    /*!
+     * \brief Write the file for the process.
+     *
+     * This method does not do any communication, i.e., it is identical to
+     * writeDetached().
+     *
+     * \return The name of the file to be referenced by the meta file
+     */
+    std::string write(const std::string& name,
+                      Dune::VTK::OutputType outputType = Dune::VTK::appendedraw)
+    {
+        return writeDetached(name,
+                             outputType,
+                             gridView_.comm().rank(),
+                             gridView_.comm().size());
+    }
+
+    /*!
+     * \brief Write the file for the process without any collective communication.
+     *
+     * In the parallel case, the first rank also writes the file which contains the
+     * pieces of all processes. The file names follow the conventions of
+     * Dune::VTKWriter.
+     *
+     * \return The name of the file to be referenced by the meta file
+     */
+    std::string writeDetached(const std::string& name,
+                              Dune::VTK::OutputType outputType OPM_UNUSED,
+                              int commRank,
+                              int commSize)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+
+        std::vector<DataArray_> pointData;
+        std::vector<DataArray_> cellData;
+        std::vector<DataArray_> pointArrays;
+        std::vector<DataArray_> cellArrays;
+        collectData_(pointData, cellData, pointArrays, cellArrays);
+
+        // compress the blocks of all arrays
+        std::vector<DataArray_*> arrays;
+        for (auto& a : pointData) arrays.push_back(&a);
+        for (auto& a : cellData) arrays.push_back(&a);
+        for (auto& a : pointArrays) arrays.push_back(&a);
+        for (auto& a : cellArrays) arrays.push_back(&a);
+        compress_(arrays);
+
+        size_t rawSize = 0;
+        HeaderType offset = 0;
+        for (auto* a : arrays) {
+            rawSize += a->rawData.size();
+            a->offset = offset;
+            offset += sizeof(HeaderType)*(3 + a->compressedBlocks.size());
+            for (const auto& block : a->compressedBlocks)
+                offset += block.size();
+        }
+        size_t compressedSize = offset;
+
+        std::string pieceName = (commSize > 1) ? parallelPieceName_(name, commRank, commSize) : name + ".vtu";
+        writePiece_(pieceName, pointData, cellData, pointArrays, cellArrays, arrays);
+
+        std::string fileName = pieceName;
+        if (commSize > 1) {
+            fileName = parallelCollectionName_(name, commSize);
+            if (commRank == 0)
+                writeCollection_(fileName, name, commSize, pointData, cellData);
+        }
+
+        if (commRank == 0) {
+            double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            std::cout << "Compressed VTK output '" << pieceName << "': "
+                      << rawSize/(1024.0*1024.0) << " MB raw, "
+                      << compressedSize/(1024.0*1024.0) << " MB written ("
+                      << std::setprecision(3) << 100.0*compressedSize/std::max<size_t>(rawSize, 1)
+                      << "%), " << rawSize/(1024.0*1024.0)/std::max(seconds, 1e-9) << " MB/s\n"
+                      << std::flush;
+        }
+
+        return fileName;
+    }
+
+private:
+    static const char* compressorName_()
+    {
+        return (compressedFormat == VtkCompressedFormat::appendedLz4)
+            ? "vtkLZ4DataCompressor"
+            : "vtkZLibDataCompressor";
+    }
+
+    static const char* byteOrder_()
+    {
+        const uint16_t tmp = 1;
+        return (*reinterpret_cast<const char*>(&tmp) == 1) ? "LittleEndian" : "BigEndian";
+    }
+
+    std::string parallelPieceName_(const std::string& name, int commRank, int commSize) const
+    {
+        std::ostringstream oss;
+        oss << "s" << std::setw(4) << std::setfill('0') << commSize
+            << "-p" << std::setw(4) << std::setfill('0') << commRank
+            << "-" << name << ".vtu";
+        return oss.str();
+    }
+
+    std::string parallelCollectionName_(const std::string& name, int commSize) const
+    {
+        std::ostringstream oss;
+        oss << "s" << std::setw(4) << std::setfill('0') << commSize
+            << "-" << name << ".pvtu";
+        return oss.str();
+    }
+
+    template <class T>
+    static void append_(std::vector<char>& data, T value)
+    {
+        size_t pos = data.size();
+        data.resize(pos + sizeof(T));
+        std::memcpy(data.data() + pos, &value, sizeof(T));
+    }
+
+    // evaluate all functions and assemble the grid for the interior elements
+    void collectData_(std::vector<DataArray_>& pointData,
+                      std::vector<DataArray_>& cellData,
+                      std::vector<DataArray_>& pointArrays,
+                      std::vector<DataArray_>& cellArrays)
+    {
+        // number the vertices of the interior elements consecutively
+        std::vector<int> vertexIdx(vertexMapper_.size(), -1);
+        std::vector<Element> vertexElem;
+        std::vector<unsigned> vertexLocalIdx;
+        numCells_ = 0;
+        numPoints_ = 0;
+
+        const auto& elemEndIt = gridView_.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+             elemIt != elemEndIt;
+             ++elemIt)
+        {
+            const Element& elem = *elemIt;
+            ++numCells_;
+            unsigned numCorners = elem.subEntities(dim);
+            for (unsigned i = 0; i < numCorners; ++i) {
+                unsigned globalIdx = static_cast<unsigned>(vertexMapper_.subIndex(elem, i, dim));
+                if (vertexIdx[globalIdx] < 0) {
+                    vertexIdx[globalIdx] = static_cast<int>(numPoints_++);
+                    vertexElem.push_back(elem);
+                    vertexLocalIdx.push_back(i);
+                }
+            }
+        }
+
+        // the vertex centered quantities and the coordinates
+        pointArrays.resize(1);
+        DataArray_& coords = pointArrays[0];
+        coords.name = "Coordinates";
+        coords.type = "Float32";
+        coords.numComponents = 3;
+        coords.rawData.reserve(numPoints_*3*sizeof(float));
+        for (size_t pointIdx = 0; pointIdx < numPoints_; ++pointIdx) {
+            const auto& pos = vertexElem[pointIdx].geometry().corner(static_cast<int>(vertexLocalIdx[pointIdx]));
+            for (unsigned k = 0; k < 3; ++k)
+                append_(coords.rawData, static_cast<float>((k < dimWorld) ? pos[k] : 0.0));
+        }
+
+        pointData.resize(vertexData_.size());
+        auto fnIt = vertexData_.begin();
+        for (unsigned fnIdx = 0; fnIdx < vertexData_.size(); ++fnIdx, ++fnIt) {
+            const auto& fn = **fnIt;
+            DataArray_& array = pointData[fnIdx];
+            array.name = fn.name();
+            array.type = "Float32";
+            array.numComponents = static_cast<unsigned>((fn.ncomps() > 1) ? 3 : 1);
+            array.rawData.reserve(numPoints_*array.numComponents*sizeof(float));
+            for (size_t pointIdx = 0; pointIdx < numPoints_; ++pointIdx) {
+                const Element& elem = vertexElem[pointIdx];
+                const auto& local =
+                    Dune::ReferenceElements<ctype, dim>::general(elem.type()).position(static_cast<int>(vertexLocalIdx[pointIdx]), dim);
+                writeFunctionValue_(array, fn, elem, local);
+            }
+        }
+
+        // the element centered quantities and the topology of the cells
+        cellData.resize(cellData_.size());
+        unsigned fnIdx = 0;
+        for (auto fnIt2 = cellData_.begin(); fnIt2 != cellData_.end(); ++fnIt2, ++fnIdx) {
+            const auto& fn = **fnIt2;
+            DataArray_& array = cellData[fnIdx];
+            array.name = fn.name();
+            array.type = "Float32";
+            array.numComponents = static_cast<unsigned>((fn.ncomps() > 1) ? 3 : 1);
+            array.rawData.reserve(numCells_*array.numComponents*sizeof(float));
+        }
+
+        cellArrays.resize(3);
+        DataArray_& connectivity = cellArrays[0];
+        connectivity.name = "connectivity";
+        connectivity.type = "Int32";
+        connectivity.numComponents = 1;
+        DataArray_& offsets = cellArrays[1];
+        offsets.name = "offsets";
+        offsets.type = "Int32";
+        offsets.numComponents = 1;
+        DataArray_& types = cellArrays[2];
+        types.name = "types";
+        types.type = "UInt8";
+        types.numComponents = 1;
+
+        int32_t offset = 0;
+        for (auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+             elemIt != elemEndIt;
+             ++elemIt)
+        {
+            const Element& elem = *elemIt;
+            const Dune::GeometryType& gt = elem.type();
+            int numCorners = static_cast<int>(elem.subEntities(dim));
+            for (int i = 0; i < numCorners; ++i) {
+                int duneIdx = Dune::VTK::renumber(gt, i);
+                unsigned globalIdx = static_cast<unsigned>(vertexMapper_.subIndex(elem, duneIdx, dim));
+                append_(connectivity.rawData, static_cast<int32_t>(vertexIdx[globalIdx]));
+            }
+            offset += numCorners;
+            append_(offsets.rawData, offset);
+            append_(types.rawData, static_cast<uint8_t>(Dune::VTK::geometryType(gt)));
+
+            const auto& center = Dune::ReferenceElements<ctype, dim>::general(gt).position(0, 0);
+            fnIdx = 0;
+            for (auto fnIt2 = cellData_.begin(); fnIt2 != cellData_.end(); ++fnIt2, ++fnIdx)
+                writeFunctionValue_(cellData[fnIdx], **fnIt2, elem, center);
+        }
+    }
+
+    template <class Function, class Local>
+    void writeFunctionValue_(DataArray_& array,
+                             const Function& fn,
+                             const Element& elem,
+                             const Local& local) const
+    {
+        int numComps = fn.ncomps();
+        for (unsigned compIdx = 0; compIdx < array.numComponents; ++compIdx) {
+            float value = 0.0;
+            if (static_cast<int>(compIdx) < numComps)
+                value = static_cast<float>(fn.evaluate(static_cast<int>(compIdx), elem, local));
+            append_(array.rawData, value);
+        }
+    }
+
+    // compress the blocks of all arrays using the threads of the creating thread
+    void compress_(std::vector<DataArray_*>& arrays) const
+    {
+        // make a flat list of blocks to allow a good load balance
+        std::vector<std::pair<DataArray_*, size_t> > blocks;
+        for (auto* array : arrays) {
+            size_t numBlocks = (array->rawData.size() + blockSize_ - 1)/static_cast<size_t>(blockSize_);
+            array->compressedBlocks.resize(numBlocks);
+            for (size_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+                blocks.push_back(std::make_pair(array, blockIdx));
+        }
+
+        // exceptions must not leave the parallel region, so errors are only flagged
+        long numBlocks = static_cast<long>(blocks.size());
+        bool failed = false;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads_)
+#endif
+        for (long i = 0; i < numBlocks; ++i) {
+            DataArray_& array = *blocks[static_cast<size_t>(i)].first;
+            size_t blockIdx = blocks[static_cast<size_t>(i)].second;
+            size_t begin = blockIdx*blockSize_;
+            size_t size = std::min(static_cast<size_t>(blockSize_), array.rawData.size() - begin);
+            if (!compressBlock_(array.compressedBlocks[blockIdx], array.rawData.data() + begin, size)) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+                failed = true;
+            }
+        }
+
+        if (failed)
+            OPM_THROW(std::runtime_error, "Compression of the VTK data failed");
+    }
+
+    static bool compressBlock_(std::vector<char>& result,
+                               const char* data OPM_UNUSED,
+                               size_t size OPM_UNUSED)
+    {
+#if HAVE_ZLIB
+        if (compressedFormat == VtkCompressedFormat::appendedZlib) {
+            uLongf compressedSize = compressBound(static_cast<uLong>(size));
+            result.resize(compressedSize);
+            int ret = compress2(reinterpret_cast<Bytef*>(result.data()),
+                                &compressedSize,
+                                reinterpret_cast<const Bytef*>(data),
+                                static_cast<uLong>(size),
+                                Z_DEFAULT_COMPRESSION);
+            result.resize(compressedSize);
+            return ret == Z_OK;
+        }
+#endif
+#if HAVE_LZ4
+        if (compressedFormat == VtkCompressedFormat::appendedLz4) {
+            int capacity = LZ4_compressBound(static_cast<int>(size));
+            result.resize(static_cast<size_t>(capacity));
+            int compressedSize = LZ4_compress_default(data,
+                                                      result.data(),
+                                                      static_cast<int>(size),
+                                                      capacity);
+            result.resize(static_cast<size_t>(std::max(compressedSize, 0)));
+            return compressedSize > 0;
+        }
+#endif
+        result.clear();
+        return false;
+    }
+
+    void writeDataArrayDecl_(std::ostream& os, const DataArray_& array, const std::string& indent) const
+    {
+        os << indent << "<DataArray type=\"" << array.type << "\" Name=\"" << array.name << "\""
+           << " NumberOfComponents=\"" << array.numComponents << "\""
+           << " format=\"appended\" offset=\"" << array.offset << "\"/>\n";
+    }
+
+    void writePiece_(const std::string& fileName,
+                     const std::vector<DataArray_>& pointData,
+                     const std::vector<DataArray_>& cellData,
+                     const std::vector<DataArray_>& pointArrays,
+                     const std::vector<DataArray_>& cellArrays,
+                     const std::vector<DataArray_*>& arrays) const
+    {
+        std::ofstream os(fileName.c_str(), std::ios::binary);
+        if (!os)
+            OPM_THROW(std::runtime_error, "Could not open file '" << fileName << "'");
+
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << byteOrder_()
+           << "\" header_type=\"UInt64\" compressor=\"" << compressorName_() << "\">\n"
+           << " <UnstructuredGrid>\n"
+           << "  <Piece NumberOfPoints=\"" << numPoints_ << "\" NumberOfCells=\"" << numCells_ << "\">\n";
+
+        os << "   <PointData>\n";
+        for (const auto& array : pointData)
+            writeDataArrayDecl_(os, array, "    ");
+        os << "   </PointData>\n";
+
+        os << "   <CellData>\n";
+        for (const auto& array : cellData)
+            writeDataArrayDecl_(os, array, "    ");
+        os << "   </CellData>\n";
+
+        os << "   <Points>\n";
+        for (const auto& array : pointArrays)
+            writeDataArrayDecl_(os, array, "    ");
+        os << "   </Points>\n";
+
+        os << "   <Cells>\n";
+        for (const auto& array : cellArrays)
+            writeDataArrayDecl_(os, array, "    ");
+        os << "   </Cells>\n";
+
+        os << "  </Piece>\n"
+           << " </UnstructuredGrid>\n"
+           << " <AppendedData encoding=\"raw\">\n"
+           << "_";
+
+        // the block header of each array is followed by the compressed blocks
+        for (const auto* array : arrays) {
+            size_t rawSize = array->rawData.size();
+            size_t numBlocks = array->compressedBlocks.size();
+            std::vector<HeaderType> header(3 + numBlocks);
+            header[0] = numBlocks;
+            header[1] = static_cast<HeaderType>(blockSize_);
+            header[2] = rawSize % static_cast<size_t>(blockSize_);
+            for (size_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+                header[3 + blockIdx] = array->compressedBlocks[blockIdx].size();
+            os.write(reinterpret_cast<const char*>(header.data()),
+                     static_cast<std::streamsize>(header.size()*sizeof(HeaderType)));
+
+            for (const auto& block : array->compressedBlocks)
+                os.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+
+        os << "\n </AppendedData>\n"
+           << "</VTKFile>\n";
+        if (!os)
+            OPM_THROW(std::runtime_error, "Error while writing file '" << fileName << "'");
+    }
+
+    void writeCollection_(const std::string& fileName,
+                          const std::string& name,
+                          int commSize,
+                          const std::vector<DataArray_>& pointData,
+                          const std::vector<DataArray_>& cellData) const
+    {
+        std::ofstream os(fileName.c_str());
+        if (!os)
+            OPM_THROW(std::runtime_error, "Could not open file '" << fileName << "'");
+
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"" << byteOrder_()
+           << "\" header_type=\"UInt64\" compressor=\"" << compressorName_() << "\">\n"
+           << " <PUnstructuredGrid GhostLevel=\"0\">\n";
+
+        os << "  <PPointData>\n";
+        for (const auto& array : pointData)
+            os << "   <PDataArray type=\"" << array.type << "\" Name=\"" << array.name
+               << "\" NumberOfComponents=\"" << array.numComponents << "\"/>\n";
+        os << "  </PPointData>\n";
+
+        os << "  <PCellData>\n";
+        for (const auto& array : cellData)
+            os << "   <PDataArray type=\"" << array.type << "\" Name=\"" << array.name
+               << "\" NumberOfComponents=\"" << array.numComponents << "\"/>\n";
+        os << "  </PCellData>\n";
+
+        os << "  <PPoints>\n"
+           << "   <PDataArray type=\"Float32\" Name=\"Coordinates\" NumberOfComponents=\"3\"/>\n"
+           << "  </PPoints>\n";
+
+        for (int rank = 0; rank < commSize; ++rank)
+            os << "  <Piece Source=\"" << parallelPieceName_(name, rank, commSize) << "\"/>\n";
+
+        os << " </PUnstructuredGrid>\n"
+           << "</VTKFile>\n";
+    }
+
+    const GridView gridView_;
+    VertexMapper vertexMapper_;
+    int numThreads_;
+
+    std::list<FunctionPtr> cellData_;
+    std::list<FunctionPtr> vertexData_;
+
+    size_t numCells_;
+    size_t numPoints_;
+};
+
+} // namespace Ewoms
+
+#endif
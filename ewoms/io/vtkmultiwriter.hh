@@ -31,7 +31,9 @@
 #include "vtkscalarfunction.hh"
 #include "vtkvectorfunction.hh"
 #include "vtktensorfunction.hh"
+#include "vtkcompressedwriter.hh"
 
+#include <ewoms/io/asyncwriter.hh>
 #include <ewoms/io/baseoutputwriter.hh>
 
 #include <opm/common/Valgrind.hpp>
@@ -45,11 +47,15 @@
 #include <mpi.h>
 #endif
 
+#include <algorithm>
+#include <cctype>
 #include <list>
+#include <memory>
 #include <string>
 #include <limits>
 #include <sstream>
 #include <fstream>
+#include <type_traits>
 
 namespace Ewoms {
 /*!
@@ -58,6 +64,12 @@ namespace Ewoms {
  * This class automatically keeps the meta file up to date and
  * simplifies writing datasets consisting of multiple files. (i.e.
  * multiple time steps or grid refinements within a time step.)
+ *
+ * If asynchronous writing is enabled using setAsynchronous(), endWrite() only hands
+ * the data of the current time step to a dedicated thread which writes it to disk
+ * while the simulation continues. For this, the attached buffers which are not
+ * managed by the writer are copied, i.e., they may be modified as soon as endWrite()
+ * returns.
  */
 template <class GridView, int vtkFormat>
 class VtkMultiWriter : public BaseOutputWriter
@@ -87,6 +99,85 @@ public:
     typedef typename VtkWriter::VTKFunctionPtr FunctionPtr;
 #endif
 
+private:
+    // a VTK writer which can be called by the writer thread. if the grid is
+    // distributed, Dune::VTKWriter::write() synchronizes all processes before and after
+    // the first rank writes the file which references the pieces. this file only
+    // contains the names of the pieces, though, so the writer thread writes the files
+    // without any communication.
+    class DetachedVtkWriter_ : public VtkWriter
+    {
+    public:
+        DetachedVtkWriter_(const GridView& gridView)
+            : VtkWriter(gridView, Dune::VTK::conforming)
+        {}
+
+        std::string writeDetached(const std::string& name,
+                                  Dune::VTK::OutputType type,
+                                  int commRank,
+                                  int commSize)
+        {
+            if (commSize == 1)
+                return VtkWriter::write(name, type, commRank, commSize);
+
+            this->outputtype = type;
+
+            // the piece of the local process
+            std::ofstream file;
+            file.exceptions(std::ios_base::badbit | std::ios_base::failbit |
+                            std::ios_base::eofbit);
+            file.open(this->getParallelPieceName(name, "", commRank, commSize).c_str(),
+                      std::ios::binary);
+            this->writeDataFile(file);
+            file.close();
+
+            // the file which references the pieces of all processes
+            std::string headerName = this->getParallelHeaderName(name, "", commSize);
+            if (commRank == 0) {
+                file.open(headerName.c_str());
+                this->writeParallelHeader(file, name, "", commSize);
+                file.close();
+            }
+
+            return headerName;
+        }
+    };
+
+    // the formats of the VtkCompressedWriter are not known by Dune::VTKWriter
+    enum { isCompressed = vtkFormat == VtkCompressedFormat::appendedZlib
+                          || vtkFormat == VtkCompressedFormat::appendedLz4 };
+    typedef typename std::conditional<isCompressed,
+                                      VtkCompressedWriter<GridView, vtkFormat>,
+                                      DetachedVtkWriter_>::type WriterType;
+
+    // the output type which is passed to the writer. (the compressed writer ignores it.)
+    static Dune::VTK::OutputType outputType_()
+    { return static_cast<Dune::VTK::OutputType>(isCompressed ? Dune::VTK::appendedraw : vtkFormat); }
+
+    // all data required to write a time step
+    struct Snapshot_
+    {
+        std::unique_ptr<WriterType> writer;
+        std::list<ScalarBuffer*> scalarBuffers;
+        std::list<VectorBuffer*> vectorBuffers;
+        std::list<TensorBuffer*> tensorBuffers;
+        std::string outFileName;
+        double time;
+
+        ~Snapshot_()
+        {
+            // the VTK functions reference the buffers, so the writer must go first
+            writer.reset();
+            for (auto* buf : scalarBuffers)
+                delete buf;
+            for (auto* buf : vectorBuffers)
+                delete buf;
+            for (auto* buf : tensorBuffers)
+                delete buf;
+        }
+    };
+
+public:
     VtkMultiWriter(const GridView& gridView,
                    const std::string& simName = "",
                    std::string multiFileName = "")
@@ -114,6 +205,9 @@ public:
 
     ~VtkMultiWriter()
     {
+        // write the pending time steps
+        asyncWriter_.stop();
+
         finishMultiFile_();
 
         if (commRank_ == 0)
@@ -126,6 +220,38 @@ public:
     int curWriterNum() const
     { return curWriterNum_; }
 
+    /*!
+     * \brief Write the data of the time steps in a separate thread.
+     *
+     * \param maxPendingWrites The maximum number of time steps which are not yet
+     *                         written to disk. If endWrite() is called while this
+     *                         number is exceeded, it waits until the oldest pending
+     *                         time step has been written.
+     *
+     * The writer thread does not communicate with the other processes. In
+     * asynchronous mode, the meta file is only accessed by the writer thread.
+     */
+    void setAsynchronous(unsigned maxPendingWrites)
+    {
+        asyncWriter_.start(maxPendingWrites,
+                           [this](Snapshot_& snapshot) { this->writeSnapshot_(snapshot); });
+    }
+
+    /*!
+     * \brief Returns true if the time steps are written by a separate thread.
+     */
+    bool isAsynchronous() const
+    { return asyncWriter_.isRunning(); }
+
+    /*!
+     * \brief Wait until all pending time steps have been written to disk.
+     *
+     * This method does nothing if the writer is not asynchronous. If writing one of
+     * the time steps failed, the exception is re-thrown here.
+     */
+    void waitForPendingWrites()
+    { asyncWriter_.waitForPendingJobs(); }
+
     /*!
      * \brief Updates the internal data structures after mesh
      *        refinement.
@@ -135,6 +261,9 @@ public:
      */
     void gridChanged()
     {
+        // the pending time steps refer to the old grid
+        waitForPendingWrites();
+
         elementMapper_.update();
         vertexMapper_.update();
     }
@@ -144,14 +273,18 @@ public:
      */
     void beginWrite(double t)
     {
-        if (!multiFile_.is_open()) {
+        // report the errors of the writer thread on the main thread
+        asyncWriter_.rethrowException();
+
+        // in asynchronous mode, the meta file is started by the writer thread
+        if (!isAsynchronous() && !multiFile_.is_open()) {
             startMultiFile_(multiFileName_);
         }
 
         curTime_ = t;
         curOutFileName_ = fileName_();
 
-        curWriter_ = new VtkWriter(gridView_, Dune::VTK::conforming);
+        curWriter_ = new WriterType(gridView_);
         ++curWriterNum_;
     }
 
@@ -200,8 +333,9 @@ public:
      * In both cases, modifying the buffer between the call to this
      * method and endWrite() results in _undefined behavior_.
      */
-    void attachScalarVertexData(ScalarBuffer& buf, std::string name)
+    void attachScalarVertexData(ScalarBuffer& origBuf, std::string name)
     {
+        ScalarBuffer& buf = snapshotBuffer_(origBuf, managedScalarBuffers_);
         sanitizeScalarBuffer_(buf);
 
         typedef Ewoms::VtkScalarFunction<GridView, VertexMapper> VtkFn;
@@ -228,8 +362,9 @@ public:
      * In both cases, modifying the buffer between the call to this
      * method and endWrite() results in _undefined behaviour_.
      */
-    void attachScalarElementData(ScalarBuffer& buf, std::string name)
+    void attachScalarElementData(ScalarBuffer& origBuf, std::string name)
     {
+        ScalarBuffer& buf = snapshotBuffer_(origBuf, managedScalarBuffers_);
         sanitizeScalarBuffer_(buf);
 
         typedef Ewoms::VtkScalarFunction<GridView, ElementMapper> VtkFn;
@@ -257,8 +392,9 @@ public:
      * In both cases, modifying the buffer between the call to this
      * method and endWrite() results in _undefined behavior_.
      */
-    void attachVectorVertexData(VectorBuffer& buf, std::string name)
+    void attachVectorVertexData(VectorBuffer& origBuf, std::string name)
     {
+        VectorBuffer& buf = snapshotBuffer_(origBuf, managedVectorBuffers_);
         sanitizeVectorBuffer_(buf);
 
         typedef Ewoms::VtkVectorFunction<GridView, VertexMapper> VtkFn;
@@ -273,8 +409,9 @@ public:
     /*!
      * \brief Add a finished vertex-centered tensor field to the output.
      */
-    void attachTensorVertexData(TensorBuffer& buf, std::string name)
+    void attachTensorVertexData(TensorBuffer& origBuf, std::string name)
     {
+        TensorBuffer& buf = snapshotBuffer_(origBuf, managedTensorBuffers_);
         typedef Ewoms::VtkTensorFunction<GridView, VertexMapper> VtkFn;
 
         for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
@@ -306,8 +443,9 @@ public:
      * In both cases, modifying the buffer between the call to this
      * method and endWrite() results in _undefined behaviour_.
      */
-    void attachVectorElementData(VectorBuffer& buf, std::string name)
+    void attachVectorElementData(VectorBuffer& origBuf, std::string name)
     {
+        VectorBuffer& buf = snapshotBuffer_(origBuf, managedVectorBuffers_);
         sanitizeVectorBuffer_(buf);
 
         typedef Ewoms::VtkVectorFunction<GridView, ElementMapper> VtkFn;
@@ -322,8 +460,9 @@ public:
     /*!
      * \brief Add a finished element-centered tensor field to the output.
      */
-    void attachTensorElementData(TensorBuffer& buf, std::string name)
+    void attachTensorElementData(TensorBuffer& origBuf, std::string name)
     {
+        TensorBuffer& buf = snapshotBuffer_(origBuf, managedTensorBuffers_);
         typedef Ewoms::VtkTensorFunction<GridView, ElementMapper> VtkFn;
 
         for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
@@ -349,11 +488,26 @@ public:
      */
     void endWrite(bool onlyDiscard = false)
     {
+        if (!onlyDiscard && isAsynchronous()) {
+            std::unique_ptr<Snapshot_> snapshot(new Snapshot_);
+            snapshot->writer.reset(curWriter_);
+            snapshot->scalarBuffers.swap(managedScalarBuffers_);
+            snapshot->vectorBuffers.swap(managedVectorBuffers_);
+            snapshot->tensorBuffers.swap(managedTensorBuffers_);
+            snapshot->outFileName = curOutFileName_;
+            snapshot->time = curTime_;
+            curWriter_ = nullptr;
+
+            // this applies backpressure if the disk cannot keep up with the simulation
+            asyncWriter_.submit(std::move(snapshot));
+            return;
+        }
+
         if (!onlyDiscard) {
             std::string fileName;
             // write the actual data as vtu or vtp (plus the pieces file in the parallel case)
             fileName = curWriter_->write(/*name=*/curOutFileName_.c_str(),
-                                         static_cast<Dune::VTK::OutputType>(vtkFormat));
+                                         outputType_());
 
             // determine name to write into the multi-file for the
             // current time step
@@ -374,11 +528,18 @@ public:
             delete managedVectorBuffers_.front();
             managedVectorBuffers_.pop_front();
         }
+        while (managedTensorBuffers_.begin() != managedTensorBuffers_.end()) {
+            delete managedTensorBuffers_.front();
+            managedTensorBuffers_.pop_front();
+        }
 
         // temporarily write the closing XML mumbo-jumbo to the mashup
         // file so that the data set can be loaded even if the
-        // simulation is aborted (or not yet finished)
-        finishMultiFile_();
+        // simulation is aborted (or not yet finished). a discarded time step
+        // does not change the meta file, and in asynchronous mode, the meta file
+        // must not be touched by this thread anyway.
+        if (!onlyDiscard)
+            finishMultiFile_();
     }
 
     /*!
@@ -387,6 +548,9 @@ public:
     template <class Restarter>
     void serialize(Restarter& res)
     {
+        // the meta file must contain all time steps written so far
+        waitForPendingWrites();
+
         res.serializeSectionBegin("VTKMultiWriter");
         res.serializeStream() << curWriterNum_ << "\n";
 
@@ -421,13 +585,15 @@ public:
     template <class Restarter>
     void deserialize(Restarter& res)
     {
+        waitForPendingWrites();
+
         res.deserializeSectionBegin("VTKMultiWriter");
         res.deserializeStream() >> curWriterNum_;
 
-        if (commRank_ == 0) {
-            std::string dummy;
-            std::getline(res.deserializeStream(), dummy);
+        std::string dummy;
+        std::getline(res.deserializeStream(), dummy);
 
+        if (commRank_ == 0) {
             // recreate the meta file from the restart file
             std::streamoff filePos;
             std::streamsize fileLen;
@@ -448,13 +614,60 @@ public:
             multiFile_.seekp(filePos);
         }
         else {
-            std::string tmp;
-            std::getline(res.deserializeStream(), tmp);
+            // only the section of the first process contains the meta file. the other
+            // processes may read that section if a binary restart file is read using
+            // more processes than it was written with, so skip the meta file if it is
+            // there.
+            std::istream& is = res.deserializeStream();
+            int c = is.peek();
+            if (c != std::char_traits<char>::eof() && std::isdigit(c)) {
+                std::streamoff filePos;
+                std::streamsize fileLen;
+                is >> fileLen >> filePos;
+                std::getline(is, dummy);
+                is.ignore(fileLen);
+            }
         }
         res.deserializeSectionEnd();
     }
 
 private:
+    // in asynchronous mode, return a copy of a buffer which is not managed by the
+    // writer. the copy is managed, i.e., it will be deleted after it has been written.
+    template <class Buffer>
+    Buffer& snapshotBuffer_(Buffer& buf, std::list<Buffer*>& managedBuffers)
+    {
+        if (!isAsynchronous()
+            || std::find(managedBuffers.begin(), managedBuffers.end(), &buf) != managedBuffers.end())
+            return buf;
+
+        Buffer* copy = new Buffer(buf);
+        managedBuffers.push_back(copy);
+        return *copy;
+    }
+
+    // called by the writer thread. in asynchronous mode, this is the only method which
+    // accesses the meta file until the pending time steps have been waited for.
+    void writeSnapshot_(Snapshot_& snapshot)
+    {
+        if (!multiFile_.is_open())
+            startMultiFile_(multiFileName_);
+
+        // the data of the local process is written without communication. the first
+        // rank also writes the file which contains the pieces of all ranks.
+        std::string fileName =
+            snapshot.writer->writeDetached(snapshot.outFileName,
+                                           outputType_(),
+                                           commRank_,
+                                           commSize_);
+        if (commRank_ == 0) {
+            multiFile_.precision(16);
+            multiFile_ << "   <DataSet timestep=\"" << snapshot.time << "\" file=\""
+                       << fileName << "\"/>\n";
+        }
+        finishMultiFile_();
+    }
+
     std::string fileName_()
     {
         // use a new file name for each time step
@@ -518,13 +731,17 @@ private:
     int commSize_; // number of processes in the communicator
     int commRank_; // rank of the current process in the communicator
 
-    VtkWriter *curWriter_;
+    WriterType *curWriter_;
     double curTime_;
     std::string curOutFileName_;
     int curWriterNum_;
 
     std::list<ScalarBuffer *> managedScalarBuffers_;
     std::list<VectorBuffer *> managedVectorBuffers_;
+    std::list<TensorBuffer *> managedTensorBuffers_;
+
+    // writes the time steps if the output is asynchronous
+    AsyncWriter<Snapshot_> asyncWriter_;
 };
 } // namespace Ewoms
 
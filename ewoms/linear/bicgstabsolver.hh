@@ -117,6 +117,9 @@ public:
 
     /*!
      * \brief Run the stabilized BiCG solver and store the result into the "x" vector.
+     *
+     * The value of "x" at entry is used as the initial solution. If its residual is
+     * larger than the one of the zero vector, the zero vector is used instead.
      */
     bool apply(Vector& x)
     {
@@ -136,13 +139,22 @@ public:
         // See https://en.wikipedia.org/wiki/Biconjugate_gradient_stabilized_method,
         // (article date: December 19, 2016)
 
-        // set the initial solution to the zero vector
-        x = 0.0;
+        // r0 = b - Ax_0. if the initial solution is worse than the zero vector, we
+        // start with the zero vector
+        Vector r = *b_;
+        bool zeroInitialSolution = (scalarProduct_.norm(x) == 0.0);
+        if (!zeroInitialSolution) {
+            A_->applyscaleadd(/*alpha=*/-1.0, x, r);
+            if (scalarProduct_.norm(r) > scalarProduct_.norm(*b_)) {
+                x = 0.0;
+                r = *b_;
+                zeroInitialSolution = true;
+            }
+        }
 
         // prepare the preconditioner. to allow some optimizations, we assume that the
         // preconditioner does not change the initial solution x if the initial solution
         // is a zero vector.
-        Vector r = *b_;
         preconditioner_.pre(x, r);
 
 #ifndef NDEBUG
@@ -150,7 +162,7 @@ public:
         // this is a debugging check, we don't care if it does not work properly in
         // parallel. (because this goes wrong, it should be considered to be a bug in the
         // code anyway.)
-        for (unsigned i = 0; i < x.size(); ++i) {
+        for (unsigned i = 0; zeroInitialSolution && i < x.size(); ++i) {
             const auto& u = x[i];
             if (u*u != 0.0)
                 OPM_THROW(std::logic_error,
@@ -158,7 +170,18 @@ public:
         }
 #endif // NDEBUG
 
-        convergenceCriterion_.setInitial(x, r);
+        // the reduction of the residual is always measured relative to the residual of
+        // the zero vector, i.e., to the right hand side. otherwise, a good initial
+        // solution would make the solver iterate until the residual has been reduced
+        // by the tolerance a second time.
+        if (zeroInitialSolution)
+            convergenceCriterion_.setInitial(x, r);
+        else {
+            Vector zeroSolution(x);
+            zeroSolution = 0.0;
+            convergenceCriterion_.setInitial(zeroSolution, *b_);
+            convergenceCriterion_.update(/*curSol=*/x, /*delta=*/x, r);
+        }
         if (convergenceCriterion_.converged()) {
             report_.setConverged(true);
             return report_.converged();
@@ -169,10 +192,8 @@ public:
             convergenceCriterion_.printInitial();
         }
 
-        // r0 = b - Ax (i.e., r -= A*x_0 = b, because x_0 == 0)
-        //A_->applyscaleadd(/*alpha=*/-1.0, x, r);
-
-        // r0hat = r0
+        // r0hat = b. this only needs to be a vector which is not orthogonal to r0, so we
+        // can avoid a copy even if the initial solution is not zero
         const Vector& r0hat = *b_;
 
         // rho0 = alpha = omega0 = 1
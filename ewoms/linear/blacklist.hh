@@ -76,6 +76,18 @@ public:
     void setPeerList(ProcessRank peerRank, const PeerBlackList& peerBlackList)
     { peerBlackLists_[peerRank] = peerBlackList; }
 
+    /*!
+     * \brief Returns the native indices which are blacklisted for the local process.
+     */
+    const std::set<Index>& nativeIndices() const
+    { return nativeBlackListedIndices_; }
+
+    /*!
+     * \brief Returns the blacklisted indices of all peer processes.
+     */
+    const PeerBlackLists& peerBlackLists() const
+    { return peerBlackLists_; }
+
     template <class DomesticOverlap>
     void updateNativeToDomesticMap(const DomesticOverlap& domesticOverlap)
     {
@@ -135,7 +147,7 @@ private:
 
         numIdxBuff.resize(1);
         numIdxBuff[0] = static_cast<unsigned>(peerIndices.size());
-        numIdxBuff.send(peerRank);
+        numIdxBuff.send(peerRank, domesticOverlap.communicator());
 
         idxBuff.resize(2*peerIndices.size());
         for (size_t i = 0; i < peerIndices.size(); ++i) {
@@ -147,7 +159,7 @@ private:
             // native peer index
             idxBuff[2*i + 1] = peerIndices[i].nativeIndexOfPeer;
         }
-        idxBuff.send(peerRank);
+        idxBuff.send(peerRank, domesticOverlap.communicator());
     }
 
     template <class DomesticOverlap>
@@ -155,11 +167,11 @@ private:
                                const DomesticOverlap& domesticOverlap)
     {
         MpiBuffer<unsigned> numGlobalIdxBuf(1);
-        numGlobalIdxBuf.receive(peerRank);
+        numGlobalIdxBuf.receive(peerRank, domesticOverlap.communicator());
         unsigned numIndices = numGlobalIdxBuf[0];
 
         MpiBuffer<Index> globalIdxBuf(2*numIndices);
-        globalIdxBuf.receive(peerRank);
+        globalIdxBuf.receive(peerRank, domesticOverlap.communicator());
         for (unsigned i = 0; i < numIndices; ++i) {
             Index globalIdx = globalIdxBuf[2*i + 0];
             Index nativeIdx = globalIdxBuf[2*i + 1];
@@ -66,8 +66,9 @@ public:
     DomesticOverlapFromBCRSMatrix(const BCRSMatrix& A,
                                   const BorderList& borderList,
                                   const BlackList& blackList,
-                                  unsigned overlapSize)
-        : foreignOverlap_(A, borderList, blackList, overlapSize)
+                                  unsigned overlapSize,
+                                  Communicator comm)
+        : foreignOverlap_(A, borderList, blackList, overlapSize, comm)
         , blackList_(blackList)
         , globalIndices_(foreignOverlap_)
     {
@@ -76,9 +77,9 @@ public:
 
 #if HAVE_MPI
         int tmp;
-        MPI_Comm_rank(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_rank(comm, &tmp);
         myRank_ = static_cast<ProcessRank>(tmp);
-        MPI_Comm_size(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_size(comm, &tmp);
         worldSize_ = static_cast<unsigned>(tmp);
 #endif // HAVE_MPI
 
@@ -108,13 +109,13 @@ public:
             auto& buffer = *(new MpiBuffer<unsigned>(1));
             sizeBufferMap[*peerIt] = &buffer;
             buffer[0] = foreignOverlap_.foreignOverlapWithPeer(*peerIt).size();
-            buffer.send(*peerIt);
+            buffer.send(*peerIt, communicator());
         }
 
         peerIt = peerSet_.begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             MpiBuffer<unsigned> rcvBuffer(1);
-            rcvBuffer.receive(*peerIt);
+            rcvBuffer.receive(*peerIt, communicator());
 
             assert(rcvBuffer[0] == domesticOverlapWithPeer_.find(*peerIt)->second.size());
         }
@@ -133,11 +134,17 @@ public:
     { return myRank_; }
 
     /*!
-     * \brief Returns the number of processes in the global MPI communicator.
+     * \brief Returns the number of processes in the MPI communicator.
      */
     unsigned worldSize() const
     { return worldSize_; }
 
+    /*!
+     * \brief Returns the MPI communicator which is used by the overlap.
+     */
+    Communicator communicator() const
+    { return foreignOverlap_.communicator(); }
+
     /*!
      * \brief Return the set of process ranks which share an overlap
      *        with the current process.
@@ -455,7 +462,7 @@ protected:
         size_t numIndices = foreignOverlap.size();
         numIndicesSendBuffer_[peerRank] = new MpiBuffer<size_t>(1);
         (*numIndicesSendBuffer_[peerRank])[0] = numIndices;
-        numIndicesSendBuffer_[peerRank]->send(peerRank);
+        numIndicesSendBuffer_[peerRank]->send(peerRank, communicator());
 
         // create MPI buffers
         indicesSendBuffer_[peerRank] = new MpiBuffer<IndexDistanceNpeers>(numIndices);
@@ -476,7 +483,7 @@ protected:
             (*indicesSendBuffer_[peerRank])[i] = tmp;
         }
 
-        indicesSendBuffer_[peerRank]->send(peerRank);
+        indicesSendBuffer_[peerRank]->send(peerRank, communicator());
 #endif // HAVE_MPI
     }
 
@@ -495,12 +502,12 @@ protected:
         // receive the number of additional indices
         int numIndices = -1;
         MpiBuffer<size_t> numIndicesRecvBuff(1);
-        numIndicesRecvBuff.receive(peerRank);
+        numIndicesRecvBuff.receive(peerRank, communicator());
         numIndices = static_cast<int>(numIndicesRecvBuff[0]);
 
         // receive the additional indices themselfs
         MpiBuffer<IndexDistanceNpeers> recvBuff(static_cast<size_t>(numIndices));
-        recvBuff.receive(peerRank);
+        recvBuff.receive(peerRank, communicator());
         for (unsigned i = 0; i < static_cast<unsigned>(numIndices); ++i) {
             Index globalIdx = recvBuff[i].index;
             BorderDistance borderDistance = recvBuff[i].borderDistance;
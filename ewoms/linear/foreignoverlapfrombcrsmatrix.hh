@@ -42,7 +42,10 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#include <cstdint>
 
 #if HAVE_MPI
 #include <mpi.h>
@@ -72,8 +75,9 @@ public:
     ForeignOverlapFromBCRSMatrix(const BCRSMatrix& A,
                                  const BorderList& borderList,
                                  const BlackList& blackList,
-                                 unsigned overlapSize)
-        : borderList_(borderList), blackList_(blackList)
+                                 unsigned overlapSize,
+                                 Communicator comm)
+        : borderList_(borderList), blackList_(blackList), comm_(comm)
     {
         overlapSize_ = overlapSize;
 
@@ -81,7 +85,7 @@ public:
 #if HAVE_MPI
         {
             int tmp;
-            MPI_Comm_rank(MPI_COMM_WORLD, &tmp);
+            MPI_Comm_rank(comm_, &tmp);
             myRank_ = static_cast<ProcessRank>(tmp);
         }
 #endif
@@ -91,15 +95,20 @@ public:
         createLocalIndices_();
 
         // calculate the set of local indices on the border (beware:
-        // _not_ the native ones)
+        // _not_ the native ones) and the peer index of each border
+        // index
+        isLocalBorderIndex_.resize(numLocal_, false);
+        borderPeerIndices_.reserve(borderList.size());
         auto it = borderList.begin();
         const auto& endIt = borderList.end();
         for (; it != endIt; ++it) {
+            borderPeerIndices_.emplace(indexRankKey_(it->localIdx, it->peerRank), it->peerIdx);
+
             Index localIdx = nativeToLocal(it->localIdx);
             if (localIdx < 0)
                 continue;
 
-            localBorderIndices_.insert(localIdx);
+            isLocalBorderIndex_[static_cast<unsigned>(localIdx)] = true;
         }
 
         // compute the set of processes which are neighbors of the
@@ -145,11 +154,18 @@ public:
     unsigned overlapSize() const
     { return overlapSize_; }
 
+    /*!
+     * \brief Returns the MPI communicator which is used to communicate with the peer
+     *        processes.
+     */
+    Communicator communicator() const
+    { return comm_; }
+
     /*!
      * \brief Returns true iff a local index is a border index.
      */
     bool isBorder(Index localIdx) const
-    { return localBorderIndices_.count(localIdx) > 0; }
+    { return localIdx >= 0 && isLocalBorderIndex_[static_cast<unsigned>(localIdx)]; }
 
     /*!
      * \brief Returns true iff a local index is a border index shared with a
@@ -377,6 +393,7 @@ protected:
         // find the seed list for the next overlap level using the
         // seed set for the current level
         SeedList nextSeedList;
+        std::unordered_set<uint64_t> nextSeedKeys;
         seedIt = seedList.begin();
         for (; seedIt != seedEndIt; ++seedIt) {
             Index nativeRowIdx = seedIt->index;
@@ -403,16 +420,7 @@ protected:
                     continue;
 
                 // check whether the new index is already in the overlap
-                bool hasIndex = false;
-                typename SeedList::iterator sIt = nextSeedList.begin();
-                typename SeedList::iterator sEndIt = nextSeedList.end();
-                for (; sIt != sEndIt; ++sIt) {
-                    if (sIt->index == nativeColIdx && sIt->peerRank == peerRank) {
-                        hasIndex = true;
-                        break;
-                    }
-                }
-                if (hasIndex)
+                if (!nextSeedKeys.insert(indexRankKey_(nativeColIdx, peerRank)).second)
                     continue; // we already have this index
 
                 // add the current processes to the seed list for the
@@ -455,14 +463,19 @@ protected:
 
     Index localToPeerIdx_(Index localIdx, ProcessRank peerRank) const
     {
-        auto it = borderList_.begin();
-        const auto& endIt = borderList_.end();
-        for (; it != endIt; ++it) {
-            if (it->localIdx == localIdx && it->peerRank == peerRank)
-                return it->peerIdx;
-        }
+        const auto& it = borderPeerIndices_.find(indexRankKey_(localIdx, peerRank));
+        if (it == borderPeerIndices_.end())
+            return -1;
 
-        return -1;
+        return it->second;
+    }
+
+    // combines an index and a process rank into a single key for the
+    // hash based lookups
+    static uint64_t indexRankKey_(Index idx, ProcessRank peerRank)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(idx)) << 32)
+            | static_cast<uint64_t>(peerRank);
     }
 
     template <class BCRSMatrix>
@@ -540,10 +553,17 @@ protected:
         peerIt = neighborPeerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank neighborPeer = *peerIt;
-            numIndicesSendBufs[neighborPeer].send(neighborPeer);
-            indicesSendBufs[neighborPeer].send(neighborPeer);
+            numIndicesSendBufs[neighborPeer].send(neighborPeer, comm_);
+            indicesSendBufs[neighborPeer].send(neighborPeer, comm_);
         }
 
+        // the (index, rank) pairs which are already in the seed list
+        std::unordered_set<uint64_t> seedKeys;
+        auto seedIt = seedList.begin();
+        const auto& seedEndIt = seedList.end();
+        for (; seedIt != seedEndIt; ++seedIt)
+            seedKeys.insert(indexRankKey_(seedIt->index, seedIt->peerRank));
+
         // receive all data from the neighbors
         std::map<ProcessRank, MpiBuffer<unsigned> > numIndicesRcvBufs;
         std::map<ProcessRank, MpiBuffer<BorderIndex> > indicesRcvBufs;
@@ -554,10 +574,10 @@ protected:
             auto& indicesRcvBuf = indicesRcvBufs[neighborPeer];
 
             numIndicesRcvBuf.resize(1);
-            numIndicesRcvBuf.receive(neighborPeer);
+            numIndicesRcvBuf.receive(neighborPeer, comm_);
             unsigned numIndices = numIndicesRcvBufs[neighborPeer][0];
             indicesRcvBuf.resize(numIndices);
-            indicesRcvBuf.receive(neighborPeer);
+            indicesRcvBuf.receive(neighborPeer, comm_);
 
             // filter out all indices which are already in the peer
             // processes' overlap and add them to the seed list. also
@@ -578,16 +598,7 @@ protected:
                     continue;
 
                 // make sure the index is not already in the seed list
-                bool inSeedList = false;
-                auto seedIt = seedList.begin();
-                const auto& seedEndIt = seedList.end();
-                for (; seedIt != seedEndIt; ++seedIt) {
-                    if (seedIt->index == localIdx && seedIt->peerRank == peerRank) {
-                        inSeedList = true;
-                        break;
-                    }
-                }
-                if (inSeedList)
+                if (!seedKeys.insert(indexRankKey_(localIdx, peerRank)).second)
                     continue;
 
                 IndexRankDist seedEntry;
@@ -681,9 +692,13 @@ protected:
     // index
     std::vector<ProcessRank> masterRank_;
 
-    // set of all local indices which are on the border of some remote
-    // process
-    std::set<Index> localBorderIndices_;
+    // specifies for each local index whether it is on the border of
+    // some remote process
+    std::vector<bool> isLocalBorderIndex_;
+
+    // the index on the peer process for each (native index, peer
+    // rank) pair of the border list
+    std::unordered_map<uint64_t, Index> borderPeerIndices_;
 
     // stores the set of process ranks which are in the overlap for a
     // given row index "owned" by the current rank. The second value
@@ -702,7 +717,8 @@ protected:
     // number of native indices
     size_t numNative_;
 
-    // the MPI rank of the local process
+    // the MPI communicator and the rank of the local process within it
+    Communicator comm_;
     ProcessRank myRank_;
 };
 
@@ -0,0 +1,701 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::GcroDrSolver
+ */
+#ifndef EWOMS_GCRO_DR_SOLVER_HH
+#define EWOMS_GCRO_DR_SOLVER_HH
+
+#include "convergencecriterion.hh"
+#include "linearsolverreport.hh"
+
+#include <ewoms/common/timer.hh>
+#include <ewoms/common/timerguard.hh>
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/istl/scalarproducts.hh>
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+namespace Ewoms {
+namespace Linear {
+/*!
+ * \brief The subspace which the GCRO-DR solver carries from one linear solve to the next.
+ *
+ * The vectors are approximations of the eigenvectors of the preconditioned linear
+ * operator which belong to the eigenvalues of smallest magnitude. Since these are the
+ * ones which slow down the convergence of restarted GMRES and since they usually do not
+ * change much between the linear systems of subsequent Newton iterations, they are
+ * deflated in the next solve.
+ */
+template <class Vector>
+class GcroDrRecycleSpace
+{
+public:
+    GcroDrRecycleSpace()
+        : maxSize_(0)
+    {}
+
+    /*!
+     * \brief Set the maximum number of vectors which are carried between solves.
+     */
+    void setMaxSize(unsigned value)
+    {
+        maxSize_ = value;
+        if (vectors_.size() > maxSize_)
+            vectors_.erase(vectors_.begin() + maxSize_, vectors_.end());
+    }
+
+    /*!
+     * \brief Returns the maximum number of vectors which are carried between solves.
+     */
+    unsigned maxSize() const
+    { return maxSize_; }
+
+    /*!
+     * \brief Returns the vectors of the recycled subspace.
+     */
+    std::vector<Vector>& vectors()
+    { return vectors_; }
+
+    /*!
+     * \brief Forget all recycled vectors.
+     *
+     * This must be called if the layout of the vectors changes, e.g., after the grid
+     * was modified.
+     */
+    void clear()
+    { vectors_.clear(); }
+
+private:
+    unsigned maxSize_;
+    std::vector<Vector> vectors_;
+};
+
+/*!
+ * \brief Implements a restarted GMRES linear solver with deflated restarting and Krylov
+ *        subspace recycling (GCRO-DR).
+ *
+ * This solves a linear system of equations Ax = b, where the matrix A is sparse and may
+ * be unsymmetric. The preconditioner is applied from the right.
+ *
+ * At the end of each restart cycle, the harmonic Ritz vectors which correspond to the
+ * harmonic Ritz values of smallest magnitude are computed. These span the recycled
+ * subspace U which is deflated from the Krylov subspace of the next cycle. Since U is
+ * stored in a GcroDrRecycleSpace object, it is also used by the next linear solve, i.e.,
+ * for the linear system of the next Newton iteration.
+ *
+ * See:
+ *
+ * M. Parks, E. de Sturler, G. Mackey, D. Johnson, S. Maiti: "Recycling Krylov
+ * Subspaces for Sequences of Linear Systems", SIAM Journal on Scientific Computing,
+ * 28(5), 2006
+ */
+template <class LinearOperator, class Vector, class Preconditioner>
+class GcroDrSolver
+{
+    typedef Ewoms::Linear::ConvergenceCriterion<Vector> ConvergenceCriterion;
+    typedef typename LinearOperator::field_type Scalar;
+
+    // small dense matrices are stored row-wise
+    typedef std::vector<Scalar> DenseVector;
+    typedef std::vector<DenseVector> DenseMatrix;
+
+public:
+    GcroDrSolver(Preconditioner& preconditioner,
+                 ConvergenceCriterion& convergenceCriterion,
+                 Dune::ScalarProduct<Vector>& scalarProduct,
+                 GcroDrRecycleSpace<Vector>& recycleSpace)
+        : preconditioner_(preconditioner)
+        , convergenceCriterion_(convergenceCriterion)
+        , scalarProduct_(scalarProduct)
+        , recycleSpace_(recycleSpace)
+    {
+        A_ = nullptr;
+        b_ = nullptr;
+
+        maxIterations_ = 1000;
+        restart_ = 30;
+        verbosity_ = 0;
+    }
+
+    /*!
+     * \brief Set the maximum number of iterations before we give up without achieving
+     *        convergence.
+     */
+    void setMaxIterations(unsigned value)
+    { maxIterations_ = value; }
+
+    /*!
+     * \brief Return the maximum number of iterations before we give up without achieving
+     *        convergence.
+     */
+    unsigned maxIterations() const
+    { return maxIterations_; }
+
+    /*!
+     * \brief Set the dimension of the search space of a restart cycle.
+     *
+     * This includes the vectors of the recycled subspace.
+     */
+    void setRestart(unsigned value)
+    { restart_ = std::max(1u, value); }
+
+    /*!
+     * \brief Returns the dimension of the search space of a restart cycle.
+     */
+    unsigned restart() const
+    { return restart_; }
+
+    /*!
+     * \brief Set the verbosity level of the linear solver
+     *
+     * The levels correspont to those used by the dune-istl solvers:
+     *
+     * - 0: no output
+     * - 1: summary output at the end of the solution proceedure (if no exception was
+     *      thrown)
+     * - 2: detailed output after each iteration
+     */
+    void setVerbosity(unsigned value)
+    { verbosity_ = value; }
+
+    /*!
+     * \brief Return the verbosity level of the linear solver.
+     */
+    unsigned verbosity() const
+    { return verbosity_; }
+
+    /*!
+     * \brief Set the matrix "A" of the linear system.
+     */
+    void setLinearOperator(const LinearOperator* A)
+    { A_ = A; }
+
+    /*!
+     * \brief Set the right hand side "b" of the linear system.
+     */
+    void setRhs(const Vector* b)
+    { b_ = b; }
+
+    /*!
+     * \brief Run the GCRO-DR solver and store the result into the "x" vector.
+     *
+     * The value of "x" at entry is used as the initial solution. If its residual is
+     * larger than the one of the zero vector, the zero vector is used instead.
+     */
+    bool apply(Vector& x)
+    {
+        // start the stop watch for the solution proceedure, but make sure that it is
+        // turned off regardless of how we leave the stadium.
+        report_.reset();
+        Ewoms::TimerGuard reportTimerGuard(report_.timer());
+        report_.timer().start();
+
+        // r0 = b - Ax_0. if the initial solution is worse than the zero vector, we
+        // start with the zero vector
+        Vector r = *b_;
+        bool zeroInitialSolution = (scalarProduct_.norm(x) == 0.0);
+        if (!zeroInitialSolution) {
+            A_->applyscaleadd(/*alpha=*/-1.0, x, r);
+            if (scalarProduct_.norm(r) > scalarProduct_.norm(*b_)) {
+                x = 0.0;
+                r = *b_;
+                zeroInitialSolution = true;
+            }
+        }
+
+        preconditioner_.pre(x, r);
+
+        // the reduction of the residual is measured relative to the right hand side,
+        // i.e., the residual of the zero vector, even if the solver is warm-started
+        if (zeroInitialSolution)
+            convergenceCriterion_.setInitial(x, r);
+        else {
+            Vector zeroSolution(x);
+            zeroSolution = 0.0;
+            convergenceCriterion_.setInitial(zeroSolution, *b_);
+            convergenceCriterion_.update(/*curSol=*/x, /*delta=*/x, r);
+        }
+        if (convergenceCriterion_.converged()) {
+            report_.setConverged(true);
+            return report_.converged();
+        }
+
+        if (verbosity_ > 0) {
+            std::cout << "-------- GcroDrSolver --------" << std::endl;
+            convergenceCriterion_.printInitial();
+        }
+
+        // the recycled subspace: A*M^-1*U = A*Z = C, where the columns of C are
+        // orthonormal
+        std::vector<Vector>& U = recycleSpace_.vectors();
+        std::vector<Vector> Z;
+        std::vector<Vector> C;
+        setupRecycledSpace_(U, Z, C, r);
+
+        // the Krylov basis V and the preconditioned Krylov vectors M^-1*V of the
+        // current restart cycle
+        std::vector<Vector> V;
+        std::vector<Vector> Zm;
+        V.reserve(restart_ + 1);
+        Zm.reserve(restart_);
+
+        Vector xStart(x);
+        Vector p(r);
+
+        while (report_.iterations() < maxIterations_) {
+            const unsigned k = static_cast<unsigned>(C.size());
+            const unsigned m = std::max(1u, restart_ - std::min(restart_, k));
+
+            // x = x + Z*C^T*r, r = r - C*C^T*r
+            for (unsigned i = 0; i < k; ++i) {
+                Scalar alpha = scalarProduct_.dot(C[i], r);
+                x.axpy(alpha, Z[i]);
+                r.axpy(-alpha, C[i]);
+            }
+
+            Scalar beta = scalarProduct_.norm(r);
+            if (beta <= 0.0)
+                // the residual is zero, i.e., the deflation produced the exact solution.
+                break;
+
+            if (V.empty())
+                V.push_back(r);
+            V[0] = r;
+            V[0] *= 1.0/beta;
+            xStart = x;
+            p = V[0];
+
+            // the Hessenberg matrix of the Arnoldi process, its QR decomposition using
+            // Givens rotations and the projection of the Krylov vectors onto C
+            DenseMatrix Hbar(m + 1, DenseVector(m, 0.0));
+            DenseMatrix R(Hbar);
+            DenseMatrix B(k, DenseVector(m, 0.0));
+            DenseVector cs(m), sn(m);
+            DenseVector g(m + 1, 0.0);
+            g[0] = beta;
+
+            unsigned j = 0;
+            bool breakdown = false;
+            while (j < m && report_.iterations() < maxIterations_) {
+                while (V.size() < j + 2)
+                    V.push_back(r);
+                while (Zm.size() < j + 1)
+                    Zm.push_back(r);
+
+                // w = A*M^-1*v_j
+                preconditioner_.apply(Zm[j], V[j]);
+                Vector& w = V[j + 1];
+                A_->apply(Zm[j], w);
+
+                // orthogonalize w against the recycled subspace and against the previous
+                // Krylov vectors
+                for (unsigned i = 0; i < k; ++i) {
+                    B[i][j] = scalarProduct_.dot(C[i], w);
+                    w.axpy(-B[i][j], C[i]);
+                }
+                for (unsigned i = 0; i <= j; ++i) {
+                    Hbar[i][j] = scalarProduct_.dot(V[i], w);
+                    w.axpy(-Hbar[i][j], V[i]);
+                }
+                Hbar[j + 1][j] = scalarProduct_.norm(w);
+
+                const Scalar breakdownEps = std::numeric_limits<Scalar>::min()*Scalar(1e10);
+                breakdown = (Hbar[j + 1][j] <= breakdownEps);
+                if (!breakdown)
+                    w *= 1.0/Hbar[j + 1][j];
+
+                // update the QR decomposition of the Hessenberg matrix
+                for (unsigned i = 0; i <= j + 1; ++i)
+                    R[i][j] = Hbar[i][j];
+                for (unsigned i = 0; i < j; ++i) {
+                    Scalar tmp = cs[i]*R[i][j] + sn[i]*R[i + 1][j];
+                    R[i + 1][j] = -sn[i]*R[i][j] + cs[i]*R[i + 1][j];
+                    R[i][j] = tmp;
+                }
+                Scalar denom = std::hypot(R[j][j], R[j + 1][j]);
+                if (denom <= breakdownEps)
+                    OPM_THROW(Opm::NumericalProblem,
+                              "Breakdown of the GCRO-DR solver (division by zero)");
+                cs[j] = R[j][j]/denom;
+                sn[j] = R[j + 1][j]/denom;
+                R[j][j] = denom;
+                R[j + 1][j] = 0.0;
+                g[j + 1] = -sn[j]*g[j];
+                g[j] = cs[j]*g[j];
+
+                ++j;
+                report_.increment();
+
+                // update the solution: x = x_start + M^-1*V*y - Z*B*y where y solves the
+                // least squares problem min ||beta*e_1 - Hbar*y||
+                DenseVector y(j);
+                for (int i = static_cast<int>(j) - 1; i >= 0; --i) {
+                    Scalar tmp = g[static_cast<unsigned>(i)];
+                    for (unsigned l = static_cast<unsigned>(i) + 1; l < j; ++l)
+                        tmp -= R[static_cast<unsigned>(i)][l]*y[l];
+                    y[static_cast<unsigned>(i)] = tmp/R[static_cast<unsigned>(i)][static_cast<unsigned>(i)];
+                }
+                x = xStart;
+                for (unsigned i = 0; i < j; ++i)
+                    x.axpy(y[i], Zm[i]);
+                for (unsigned l = 0; l < k; ++l) {
+                    Scalar tmp = 0.0;
+                    for (unsigned i = 0; i < j; ++i)
+                        tmp += B[l][i]*y[i];
+                    x.axpy(-tmp, Z[l]);
+                }
+
+                // update the residual without an additional matrix-vector product. (see
+                // Saad: "Iterative Methods for Sparse Linear Systems", 2nd edition, 2003,
+                // proposition 6.9)
+                p *= -sn[j - 1];
+                p.axpy(cs[j - 1], V[j]);
+                r = p;
+                r *= g[j];
+
+                // do convergence check and print terminal output
+                convergenceCriterion_.update(/*curSol=*/x, /*delta=*/Zm[j - 1], r);
+                if (convergenceCriterion_.converged()) {
+                    if (verbosity_ > 0) {
+                        convergenceCriterion_.print(report_.iterations());
+                        std::cout << "-------- /GcroDrSolver --------" << std::endl;
+                    }
+
+                    updateRecycledSpace_(U, Z, C, V, Zm, Hbar, B, j);
+                    preconditioner_.post(x);
+                    report_.setConverged(true);
+                    return report_.converged();
+                }
+                else if (convergenceCriterion_.failed()) {
+                    if (verbosity_ > 0) {
+                        convergenceCriterion_.print(report_.iterations());
+                        std::cout << "-------- /GcroDrSolver --------" << std::endl;
+                    }
+
+                    report_.setConverged(false);
+                    return report_.converged();
+                }
+
+                if (verbosity_ > 1)
+                    convergenceCriterion_.print(report_.iterations());
+
+                if (breakdown)
+                    break;
+            }
+
+            // compute the subspace which is deflated in the next cycle and recompute the
+            // residual to get rid of the accumulated round-off errors
+            updateRecycledSpace_(U, Z, C, V, Zm, Hbar, B, j);
+            r = *b_;
+            A_->applyscaleadd(/*alpha=*/-1.0, x, r);
+
+            if (breakdown)
+                break;
+        }
+
+        // check the final solution
+        convergenceCriterion_.update(/*curSol=*/x, /*delta=*/x, r);
+        report_.setConverged(convergenceCriterion_.converged());
+        if (verbosity_ > 0) {
+            convergenceCriterion_.print(report_.iterations());
+            std::cout << "-------- /GcroDrSolver --------" << std::endl;
+        }
+
+        if (report_.converged())
+            preconditioner_.post(x);
+        return report_.converged();
+    }
+
+    const Ewoms::Linear::SolverReport& report() const
+    { return report_; }
+
+private:
+    // compute Z = M^-1*U and C = A*Z for the recycled vectors U of the previous solve and
+    // make C orthonormal. Since both the matrix and the preconditioner usually changed
+    // since the last solve, this must be done at the beginning of each solve.
+    void setupRecycledSpace_(std::vector<Vector>& U,
+                             std::vector<Vector>& Z,
+                             std::vector<Vector>& C,
+                             const Vector& r)
+    {
+        Z.clear();
+        C.clear();
+
+        std::vector<Vector> oldU;
+        oldU.swap(U);
+        for (unsigned i = 0; i < oldU.size(); ++i) {
+            Z.push_back(r);
+            C.push_back(r);
+            Vector& u = oldU[i];
+            Vector& z = Z.back();
+            Vector& c = C.back();
+
+            preconditioner_.apply(z, u);
+            A_->apply(z, c);
+
+            // modified Gram-Schmidt. the same operations are applied to u and z so that
+            // A*M^-1*u = A*z = c still holds.
+            Scalar origNorm = scalarProduct_.norm(c);
+            for (unsigned l = 0; l < U.size(); ++l) {
+                Scalar alpha = scalarProduct_.dot(C[l], c);
+                c.axpy(-alpha, C[l]);
+                z.axpy(-alpha, Z[l]);
+                u.axpy(-alpha, U[l]);
+            }
+
+            Scalar newNorm = scalarProduct_.norm(c);
+            if (newNorm <= 1e-10*origNorm || newNorm <= 0.0) {
+                // the vector is (almost) linearly dependent on the previous ones
+                Z.pop_back();
+                C.pop_back();
+                continue;
+            }
+
+            c *= 1.0/newNorm;
+            z *= 1.0/newNorm;
+            u *= 1.0/newNorm;
+            U.push_back(u);
+        }
+    }
+
+    // compute the recycled subspace from the harmonic Ritz vectors of the current
+    // restart cycle
+    void updateRecycledSpace_(std::vector<Vector>& U,
+                              std::vector<Vector>& Z,
+                              std::vector<Vector>& C,
+                              const std::vector<Vector>& V,
+                              const std::vector<Vector>& Zm,
+                              const DenseMatrix& Hbar,
+                              const DenseMatrix& B,
+                              unsigned numSteps)
+    {
+        const unsigned k = static_cast<unsigned>(C.size());
+        const unsigned n = k + numSteps;
+        const unsigned kNew = std::min(recycleSpace_.maxSize(), n);
+        if (kNew == 0 || numSteps == 0)
+            return;
+
+        // A*M^-1*[U, V_m] = [C, V_(m+1)]*G with G = [[I, B], [0, Hbar]]
+        DenseMatrix G(n + 1, DenseVector(n, 0.0));
+        for (unsigned i = 0; i < k; ++i) {
+            G[i][i] = 1.0;
+            for (unsigned j = 0; j < numSteps; ++j)
+                G[i][k + j] = B[i][j];
+        }
+        for (unsigned i = 0; i <= numSteps; ++i)
+            for (unsigned j = 0; j < numSteps; ++j)
+                G[k + i][k + j] = Hbar[i][j];
+
+        // W = [C, V_(m+1)]^T * [U, V_m]
+        DenseMatrix W(n + 1, DenseVector(n, 0.0));
+        for (unsigned j = 0; j < k; ++j) {
+            for (unsigned i = 0; i < k; ++i)
+                W[i][j] = scalarProduct_.dot(C[i], U[j]);
+            for (unsigned i = 0; i <= numSteps; ++i)
+                W[k + i][j] = scalarProduct_.dot(V[i], U[j]);
+        }
+        for (unsigned j = 0; j < numSteps; ++j)
+            W[k + j][k + j] = 1.0;
+
+        // the harmonic Ritz vectors solve the generalized eigenvalue problem
+        // G^T*G*p = theta*G^T*W*p. we need the ones for the smallest |theta|, i.e.,
+        // the dominant invariant subspace of T = (G^T*G)^-1*G^T*W
+        DenseMatrix S(n, DenseVector(n, 0.0));
+        DenseMatrix N(n, DenseVector(n, 0.0));
+        for (unsigned i = 0; i < n; ++i) {
+            for (unsigned j = 0; j < n; ++j) {
+                for (unsigned l = 0; l <= n; ++l) {
+                    S[i][j] += G[l][i]*G[l][j];
+                    N[i][j] += G[l][i]*W[l][j];
+                }
+            }
+        }
+        if (!solveDense_(S, N))
+            return;
+        const DenseMatrix& T = N;
+
+        // subspace iteration
+        DenseMatrix P(n, DenseVector(kNew, 0.0));
+        for (unsigned i = 0; i < n; ++i)
+            P[i][i % kNew] = 1.0;
+        orthonormalizeColumns_(P);
+        for (unsigned iterIdx = 0; iterIdx < 50; ++iterIdx) {
+            DenseMatrix tmp(n, DenseVector(kNew, 0.0));
+            for (unsigned i = 0; i < n; ++i)
+                for (unsigned l = 0; l < n; ++l)
+                    for (unsigned j = 0; j < kNew; ++j)
+                        tmp[i][j] += T[i][l]*P[l][j];
+            P.swap(tmp);
+            if (!orthonormalizeColumns_(P))
+                return;
+        }
+
+        // G*P = Q*R. the new recycled space is given by U = [U, V_m]*P*R^-1 and
+        // C = [C, V_(m+1)]*Q
+        DenseMatrix Q(n + 1, DenseVector(kNew, 0.0));
+        for (unsigned i = 0; i <= n; ++i)
+            for (unsigned l = 0; l < n; ++l)
+                for (unsigned j = 0; j < kNew; ++j)
+                    Q[i][j] += G[i][l]*P[l][j];
+        DenseMatrix Rqr(kNew, DenseVector(kNew, 0.0));
+        if (!orthonormalizeColumns_(Q, &Rqr))
+            return;
+
+        // Y = P*R^-1
+        DenseMatrix Y(n, DenseVector(kNew, 0.0));
+        for (unsigned i = 0; i < n; ++i) {
+            for (unsigned j = 0; j < kNew; ++j) {
+                Scalar tmp = P[i][j];
+                for (unsigned l = 0; l < j; ++l)
+                    tmp -= Y[i][l]*Rqr[l][j];
+                Y[i][j] = tmp/Rqr[j][j];
+            }
+        }
+
+        std::vector<Vector> newU, newZ, newC;
+        for (unsigned j = 0; j < kNew; ++j) {
+            newU.push_back(V[0]);
+            newZ.push_back(V[0]);
+            newC.push_back(V[0]);
+            newU.back() = 0.0;
+            newZ.back() = 0.0;
+            newC.back() = 0.0;
+
+            for (unsigned i = 0; i < k; ++i) {
+                newU.back().axpy(Y[i][j], U[i]);
+                newZ.back().axpy(Y[i][j], Z[i]);
+                newC.back().axpy(Q[i][j], C[i]);
+            }
+            for (unsigned i = 0; i < numSteps; ++i) {
+                newU.back().axpy(Y[k + i][j], V[i]);
+                newZ.back().axpy(Y[k + i][j], Zm[i]);
+                newC.back().axpy(Q[k + i][j], V[i]);
+            }
+            newC.back().axpy(Q[n][j], V[numSteps]);
+        }
+
+        U.swap(newU);
+        Z.swap(newZ);
+        C.swap(newC);
+    }
+
+    // orthonormalize the columns of a dense matrix using the modified Gram-Schmidt
+    // method and optionally return the upper triangular factor. returns false if the
+    // columns are linearly dependent.
+    static bool orthonormalizeColumns_(DenseMatrix& M, DenseMatrix* R = nullptr)
+    {
+        const unsigned numRows = static_cast<unsigned>(M.size());
+        const unsigned numCols = static_cast<unsigned>(M[0].size());
+        for (unsigned j = 0; j < numCols; ++j) {
+            for (unsigned l = 0; l < j; ++l) {
+                Scalar dot = 0.0;
+                for (unsigned i = 0; i < numRows; ++i)
+                    dot += M[i][l]*M[i][j];
+                for (unsigned i = 0; i < numRows; ++i)
+                    M[i][j] -= dot*M[i][l];
+                if (R)
+                    (*R)[l][j] = dot;
+            }
+
+            Scalar norm = 0.0;
+            for (unsigned i = 0; i < numRows; ++i)
+                norm += M[i][j]*M[i][j];
+            norm = std::sqrt(norm);
+            if (!std::isfinite(norm) || norm <= std::numeric_limits<Scalar>::min()*Scalar(1e10))
+                return false;
+
+            for (unsigned i = 0; i < numRows; ++i)
+                M[i][j] /= norm;
+            if (R)
+                (*R)[j][j] = norm;
+        }
+
+        return true;
+    }
+
+    // solve A*X = B using Gaussian elimination with partial pivoting. B is overwritten
+    // by the solution. returns false if A is singular.
+    static bool solveDense_(DenseMatrix A, DenseMatrix& B)
+    {
+        const unsigned n = static_cast<unsigned>(A.size());
+        for (unsigned col = 0; col < n; ++col) {
+            unsigned pivotRow = col;
+            for (unsigned i = col + 1; i < n; ++i)
+                if (std::abs(A[i][col]) > std::abs(A[pivotRow][col]))
+                    pivotRow = i;
+            if (std::abs(A[pivotRow][col]) <= std::numeric_limits<Scalar>::min()*Scalar(1e10))
+                return false;
+            std::swap(A[col], A[pivotRow]);
+            std::swap(B[col], B[pivotRow]);
+
+            for (unsigned i = col + 1; i < n; ++i) {
+                Scalar factor = A[i][col]/A[col][col];
+                if (factor == 0.0)
+                    continue;
+                for (unsigned j = col; j < n; ++j)
+                    A[i][j] -= factor*A[col][j];
+                for (unsigned j = 0; j < B[i].size(); ++j)
+                    B[i][j] -= factor*B[col][j];
+            }
+        }
+
+        for (int i = static_cast<int>(n) - 1; i >= 0; --i) {
+            unsigned ii = static_cast<unsigned>(i);
+            for (unsigned j = 0; j < B[ii].size(); ++j) {
+                Scalar tmp = B[ii][j];
+                for (unsigned l = ii + 1; l < n; ++l)
+                    tmp -= A[ii][l]*B[l][j];
+                B[ii][j] = tmp/A[ii][ii];
+            }
+        }
+
+        return true;
+    }
+
+    const LinearOperator* A_;
+    const Vector* b_;
+
+    Preconditioner& preconditioner_;
+    ConvergenceCriterion& convergenceCriterion_;
+    Dune::ScalarProduct<Vector>& scalarProduct_;
+    GcroDrRecycleSpace<Vector>& recycleSpace_;
+    Ewoms::Linear::SolverReport report_;
+
+    unsigned maxIterations_;
+    unsigned restart_;
+    unsigned verbosity_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -27,16 +27,19 @@
 #ifndef EWOMS_GLOBAL_INDICES_HH
 #define EWOMS_GLOBAL_INDICES_HH
 
+#include <ewoms/parallel/mpibuffer.hh>
+
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/istl/bcrsmatrix.hh>
 #include <dune/istl/scalarproducts.hh>
 #include <dune/istl/operators.hh>
 
 #include <algorithm>
-#include <set>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <iostream>
-#include <tuple>
+#include <cassert>
 
 #if HAVE_MPI
 #include <mpi.h>
@@ -50,14 +53,21 @@ namespace Linear {
  * \brief This class maps domestic row indices to and from "global"
  *        indices which is used to construct an algebraic overlap
  *        for the parallel linear solvers.
+ *
+ * The global indices of the indices for which a process is master are
+ * numbered consecutively, starting at an offset which is determined
+ * using an exclusive prefix sum over all processes. The global
+ * indices of the border indices for which the process is not master
+ * are then exchanged with the neighboring processes using a single
+ * message per neighbor.
  */
 template <class ForeignOverlap>
 class GlobalIndices
 {
     GlobalIndices(const GlobalIndices& ) = delete;
 
-    typedef std::map<Index, Index> GlobalToDomesticMap;
-    typedef std::map<Index, Index> DomesticToGlobalMap;
+    typedef std::unordered_map<Index, Index> GlobalToDomesticMap;
+    typedef std::vector<Index> DomesticToGlobalMap;
 
 public:
     GlobalIndices(const ForeignOverlap& foreignOverlap)
@@ -69,9 +79,9 @@ public:
 #if HAVE_MPI
         {
             int tmp;
-            MPI_Comm_rank(MPI_COMM_WORLD, &tmp);
+            MPI_Comm_rank(foreignOverlap_.communicator(), &tmp);
             myRank_ = static_cast<ProcessRank>(tmp);
-            MPI_Comm_size(MPI_COMM_WORLD, &tmp);
+            MPI_Comm_size(foreignOverlap_.communicator(), &tmp);
             mpiSize_ = static_cast<size_t>(tmp);
         }
 #endif
@@ -87,9 +97,11 @@ public:
      */
     Index domesticToGlobal(Index domesticIdx) const
     {
-        assert(domesticToGlobal_.find(domesticIdx) != domesticToGlobal_.end());
+        assert(0 <= domesticIdx
+               && static_cast<size_t>(domesticIdx) < domesticToGlobal_.size()
+               && domesticToGlobal_[static_cast<size_t>(domesticIdx)] >= 0);
 
-        return domesticToGlobal_.find(domesticIdx)->second;
+        return domesticToGlobal_[static_cast<size_t>(domesticIdx)];
     }
 
     /*!
@@ -126,60 +138,28 @@ public:
      */
     void addIndex(Index domesticIdx, Index globalIdx)
     {
-        domesticToGlobal_[domesticIdx] = globalIdx;
-        globalToDomestic_[globalIdx] = domesticIdx;
-        numDomestic_ = domesticToGlobal_.size();
+        assert(domesticIdx >= 0 && globalIdx >= 0);
 
-        assert(domesticToGlobal_.size() == globalToDomestic_.size());
-    }
+        size_t idx = static_cast<size_t>(domesticIdx);
+        if (idx >= domesticToGlobal_.size())
+            domesticToGlobal_.resize(idx + 1, -1);
 
-    /*!
-     * \brief Send a border index to a remote process.
-     */
-    void sendBorderIndex(ProcessRank peerRank, Index domesticIdx, Index peerLocalIdx)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex sendBuf;
-        sendBuf.peerIdx = peerLocalIdx;
-        sendBuf.globalIdx = domesticToGlobal(domesticIdx);
-        MPI_Send(&sendBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 static_cast<int>(peerRank),   // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD);              // communicator
-#endif
-    }
+        if (domesticToGlobal_[idx] < 0)
+            ++numDomestic_;
+        else
+            globalToDomestic_.erase(domesticToGlobal_[idx]);
 
-    /*!
-     * \brief Receive an index on the border from a remote
-     *        process and add it the translation maps.
-     */
-    void receiveBorderIndex(ProcessRank peerRank)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex recvBuf;
-        MPI_Recv(&recvBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 static_cast<int>(peerRank),   // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD,               // communicator
-                 MPI_STATUS_IGNORE);           // status
-
-        Index domesticIdx = foreignOverlap_.nativeToLocal(recvBuf.peerIdx);
-        if (domesticIdx >= 0) {
-            Index globalIdx = recvBuf.globalIdx;
-            addIndex(domesticIdx, globalIdx);
-        }
-#endif // HAVE_MPI
+        domesticToGlobal_[idx] = globalIdx;
+        globalToDomestic_[globalIdx] = domesticIdx;
+
+        assert(numDomestic_ == globalToDomestic_.size());
     }
 
     /*!
      * \brief Return true iff a given global index already exists
      */
     bool hasGlobalIndex(Index globalIdx) const
-    { return globalToDomestic_.find(globalIdx) != globalToDomestic_.end(); }
+    { return globalToDomestic_.count(globalIdx) > 0; }
 
     /*!
      * \brief Prints the global indices of all domestic indices
@@ -201,131 +181,130 @@ protected:
     // global index list
     void buildGlobalIndices_()
     {
-#if HAVE_MPI
-        numDomestic_ = 0;
-#else
-        numDomestic_ = foreignOverlap_.numLocal();
-#endif
+        size_t numLocal = foreignOverlap_.numLocal();
 
+        // count the indices for which the current process is the
+        // master
+        int numMaster = 0;
+        for (unsigned i = 0; i < numLocal; ++i)
+            if (foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
+                ++numMaster;
+
+        // the global indices of the current process start after the
+        // ones of all processes with a lower rank
+        domesticOffset_ = 0;
 #if HAVE_MPI
-        if (myRank_ == 0) {
-            // the first rank starts at index zero
+        MPI_Exscan(&numMaster,        // send buffer
+                   &domesticOffset_,  // receive buffer
+                   1,                 // count
+                   MPI_INT,           // data type
+                   MPI_SUM,           // operation
+                   foreignOverlap_.communicator()); // communicator
+
+        // the result of MPI_Exscan is undefined for the first rank
+        if (myRank_ == 0)
             domesticOffset_ = 0;
-        }
-        else {
-            // all other ranks retrieve their offset from the next
-            // lower rank
-            MPI_Recv(&domesticOffset_, // buffer
-                     1,                // count
-                     MPI_INT,          // data type
-                     static_cast<int>(myRank_ - 1), // peer rank
-                     0,                // tag
-                     MPI_COMM_WORLD,   // communicator
-                     MPI_STATUS_IGNORE);
-        }
+#endif // HAVE_MPI
 
         // create maps for all indices for which the current process
         // is the master
-        int numMaster = 0;
-        for (unsigned i = 0; i < foreignOverlap_.numLocal(); ++i) {
+        numDomestic_ = 0;
+        domesticToGlobal_.assign(numLocal, -1);
+        globalToDomestic_.clear();
+        globalToDomestic_.reserve(numLocal);
+
+        int masterIdx = 0;
+        for (unsigned i = 0; i < numLocal; ++i) {
             if (!foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
                 continue;
 
             addIndex(static_cast<Index>(i),
-                     static_cast<Index>(domesticOffset_ + numMaster));
-            ++numMaster;
+                     static_cast<Index>(domesticOffset_ + masterIdx));
+            ++masterIdx;
         }
 
-        if (myRank_ < mpiSize_ - 1) {
-            // send the domestic offset plus the number of master
-            // indices to the process which is one rank higher
-            int tmp = domesticOffset_ + numMaster;
-            MPI_Send(&tmp,            // buff
-                     1,               // count
-                     MPI_INT,         // data type
-                     static_cast<int>(myRank_ + 1), // peer rank
-                     0,               // tag
-                     MPI_COMM_WORLD); // communicator
-        }
-
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = peerSet_().end();
-        // receive the border indices from the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                receiveBorderFrom_(*peerIt);
-        }
-
-        // send the border indices to the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                sendBorderTo_(*peerIt);
-        }
-
-        // receive the border indices from the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                receiveBorderFrom_(*peerIt);
-        }
-
-        // send the border indices to the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                sendBorderTo_(*peerIt);
-        }
+#if HAVE_MPI
+        exchangeBorderIndices_();
 #endif // HAVE_MPI
     }
 
-    void sendBorderTo_(ProcessRank peerRank)
-    {
 #if HAVE_MPI
-        // send (local index on myRank, global index) pairs to the
-        // peers
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
+    // send the global indices of the border indices for which we are
+    // master to the neighboring processes and receive the ones for
+    // which a neighbor is the master. Since the global indices of the
+    // master indices are already known, all messages can be sent at
+    // once.
+    void exchangeBorderIndices_()
+    {
+        const PeerSet& neighborPeerSet = foreignOverlap_.neighborPeerSet();
+        Communicator comm = foreignOverlap_.communicator();
+
+        // collect the (peer index, global index) pairs for each
+        // neighbor
+        std::map<ProcessRank, std::vector<PeerIndexGlobalIndex> > sendLists;
+        auto borderIt = borderList_().begin();
+        const auto& borderEndIt = borderList_().end();
         for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            BorderDistance borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
+            if (borderIt->borderDistance != 0)
                 continue;
 
             Index localIdx = foreignOverlap_.nativeToLocal(borderIt->localIdx);
-            Index peerIdx = borderIt->peerIdx;
-            assert(localIdx >= 0);
-            if (foreignOverlap_.iAmMasterOf(localIdx)) {
-                sendBorderIndex(borderPeer, localIdx, peerIdx);
-            }
+            if (localIdx < 0 || !foreignOverlap_.iAmMasterOf(localIdx))
+                continue;
+
+            PeerIndexGlobalIndex entry;
+            entry.peerIdx = borderIt->peerIdx;
+            entry.globalIdx = domesticToGlobal(localIdx);
+            sendLists[borderIt->peerRank].push_back(entry);
         }
-#endif // HAVE_MPI
-    }
 
-    void receiveBorderFrom_(ProcessRank peerRank)
-    {
-#if HAVE_MPI
-        // retrieve the global indices for which we are not master
-        // from the processes with lower rank
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
-        for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            BorderDistance borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
-                continue;
+        std::map<ProcessRank, MpiBuffer<unsigned> > numIndicesSendBufs;
+        std::map<ProcessRank, MpiBuffer<PeerIndexGlobalIndex> > indicesSendBufs;
+        auto peerIt = neighborPeerSet.begin();
+        const auto& peerEndIt = neighborPeerSet.end();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            ProcessRank peerRank = *peerIt;
+            const auto& sendList = sendLists[peerRank];
+
+            auto& numIndicesSendBuf = numIndicesSendBufs[peerRank];
+            numIndicesSendBuf.resize(1);
+            numIndicesSendBuf[0] = static_cast<unsigned>(sendList.size());
+            numIndicesSendBuf.send(peerRank, comm);
+
+            auto& indicesSendBuf = indicesSendBufs[peerRank];
+            indicesSendBuf.resize(sendList.size());
+            for (size_t i = 0; i < sendList.size(); ++i)
+                indicesSendBuf[i] = sendList[i];
+            indicesSendBuf.send(peerRank, comm);
+        }
 
-            Index nativeIdx = borderIt->localIdx;
-            Index localIdx = foreignOverlap_.nativeToLocal(nativeIdx);
-            if (localIdx >= 0 && foreignOverlap_.masterRank(localIdx) == borderPeer)
-                receiveBorderIndex(borderPeer);
+        // receive the global indices for which a neighbor is the
+        // master
+        peerIt = neighborPeerSet.begin();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            ProcessRank peerRank = *peerIt;
+
+            MpiBuffer<unsigned> numIndicesRecvBuf(1);
+            numIndicesRecvBuf.receive(peerRank, comm);
+            unsigned numIndices = numIndicesRecvBuf[0];
+
+            MpiBuffer<PeerIndexGlobalIndex> indicesRecvBuf(numIndices);
+            indicesRecvBuf.receive(peerRank, comm);
+            for (unsigned i = 0; i < numIndices; ++i) {
+                Index domesticIdx = foreignOverlap_.nativeToLocal(indicesRecvBuf[i].peerIdx);
+                if (domesticIdx >= 0)
+                    addIndex(domesticIdx, indicesRecvBuf[i].globalIdx);
+            }
         }
-#endif // HAVE_MPI
-    }
 
-    const PeerSet& peerSet_() const
-    { return foreignOverlap_.peerSet(); }
+        // make sure all data was sent
+        peerIt = neighborPeerSet.begin();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            numIndicesSendBufs[*peerIt].wait();
+            indicesSendBufs[*peerIt].wait();
+        }
+    }
+#endif // HAVE_MPI
 
     const BorderList& borderList_() const
     { return foreignOverlap_.borderList(); }
@@ -39,6 +39,9 @@
  * - \c SOR: A successive overrelaxation (SOR) preconditioner
  * - \c ILUn: An ILU(n) preconditioner
  * - \c ILU0: A specialized (and optimized) ILU(0) preconditioner
+ * - \c LevelScheduledIlu0: An ILU(0) preconditioner which uses multiple threads
+ * - \c SellJacobi: A Jacobi preconditioner which uses the SELL-C-sigma storage of the
+ *   overlapping matrix
  */
 #ifndef EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
 #define EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
@@ -46,30 +49,40 @@
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 
+#include "levelscheduledilu0.hh"
+#include "selljacobi.hh"
+
 #include <dune/istl/preconditioners.hh>
 
+#include <memory>
+
 namespace Ewoms {
 namespace Properties {
 NEW_PROP_TAG(Scalar);
 NEW_PROP_TAG(JacobianMatrix);
-NEW_PROP_TAG(OverlappingMatrix);
+NEW_PROP_TAG(OverlappingPreconditionerMatrix);
 NEW_PROP_TAG(OverlappingVector);
+NEW_PROP_TAG(OverlappingPreconditionerVector);
 NEW_PROP_TAG(PreconditionerOrder);
 NEW_PROP_TAG(PreconditionerRelaxation);
 } // namespace Properties
 
 namespace Linear {
-#define EWOMS_WRAP_ISTL_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE)               \
+#define EWOMS_WRAP_ISTL_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE, COPIES_MATRIX) \
     template <class TypeTag>                                                    \
     class PreconditionerWrapper##PREC_NAME                                      \
     {                                                                           \
         typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;                 \
-        typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) JacobianMatrix; \
-        typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector; \
+        typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerMatrix) PreconditionerMatrix; \
+        typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerVector) PreconditionerVector; \
                                                                                 \
     public:                                                                     \
-        typedef ISTL_PREC_TYPE<JacobianMatrix, OverlappingVector,               \
-                               OverlappingVector> SequentialPreconditioner;     \
+        typedef ISTL_PREC_TYPE<PreconditionerMatrix, PreconditionerVector,      \
+                               PreconditionerVector> SequentialPreconditioner;  \
+        /* true if the preconditioner does not reference the matrix after */   \
+        /* prepare() has been called */                                         \
+        static constexpr bool copiesMatrix = COPIES_MATRIX;                     \
+                                                                                \
         PreconditionerWrapper##PREC_NAME()                                      \
         {}                                                                      \
                                                                                 \
@@ -82,7 +95,7 @@ namespace Linear {
                                  "preconditioner");                             \
         }                                                                       \
                                                                                 \
-        void prepare(JacobianMatrix& matrix)                                    \
+        void prepare(PreconditionerMatrix& matrix)                              \
         {                                                                       \
             int order = EWOMS_GET_PARAM(TypeTag, int, PreconditionerOrder);     \
             Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);   \
@@ -102,17 +115,21 @@ namespace Linear {
 
 // the same as the EWOMS_WRAP_ISTL_PRECONDITIONER macro, but without
 // an 'order' argument for the preconditioner's constructor
-#define EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE)        \
+#define EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(PREC_NAME, ISTL_PREC_TYPE, COPIES_MATRIX) \
     template <class TypeTag>                                                    \
     class PreconditionerWrapper##PREC_NAME                                      \
     {                                                                           \
         typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;                 \
-        typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix; \
-        typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector; \
+        typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerMatrix) PreconditionerMatrix; \
+        typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerVector) PreconditionerVector; \
                                                                                 \
     public:                                                                     \
-        typedef ISTL_PREC_TYPE<OverlappingMatrix, OverlappingVector,            \
-                               OverlappingVector> SequentialPreconditioner;     \
+        typedef ISTL_PREC_TYPE<PreconditionerMatrix, PreconditionerVector,      \
+                               PreconditionerVector> SequentialPreconditioner;  \
+        /* true if the preconditioner does not reference the matrix after */   \
+        /* prepare() has been called */                                         \
+        static constexpr bool copiesMatrix = COPIES_MATRIX;                     \
+                                                                                \
         PreconditionerWrapper##PREC_NAME()                                      \
         {}                                                                      \
                                                                                 \
@@ -123,7 +140,7 @@ namespace Linear {
                                  "preconditioner");                             \
         }                                                                       \
                                                                                 \
-        void prepare(OverlappingMatrix& matrix)                                 \
+        void prepare(PreconditionerMatrix& matrix)                              \
         {                                                                       \
             Scalar relaxationFactor =                                           \
                 EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);     \
@@ -141,15 +158,112 @@ namespace Linear {
         SequentialPreconditioner *seqPreCond_;                                  \
     };
 
-EWOMS_WRAP_ISTL_PRECONDITIONER(Jacobi, Dune::SeqJac)
-// EWOMS_WRAP_ISTL_PRECONDITIONER(Richardson, Dune::Richardson)
-EWOMS_WRAP_ISTL_PRECONDITIONER(GaussSeidel, Dune::SeqGS)
-EWOMS_WRAP_ISTL_PRECONDITIONER(SOR, Dune::SeqSOR)
-EWOMS_WRAP_ISTL_PRECONDITIONER(SSOR, Dune::SeqSSOR)
-EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(ILU0, Dune::SeqILU0)
-EWOMS_WRAP_ISTL_PRECONDITIONER(ILUn, Dune::SeqILUn)
+EWOMS_WRAP_ISTL_PRECONDITIONER(Jacobi, Dune::SeqJac, false)
+// EWOMS_WRAP_ISTL_PRECONDITIONER(Richardson, Dune::Richardson, false)
+EWOMS_WRAP_ISTL_PRECONDITIONER(GaussSeidel, Dune::SeqGS, false)
+EWOMS_WRAP_ISTL_PRECONDITIONER(SOR, Dune::SeqSOR, false)
+EWOMS_WRAP_ISTL_PRECONDITIONER(SSOR, Dune::SeqSSOR, false)
+EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(ILU0, Dune::SeqILU0, true)
+EWOMS_WRAP_ISTL_PRECONDITIONER(ILUn, Dune::SeqILUn, true)
 
 #undef EWOMS_WRAP_ISTL_PRECONDITIONER
+
+/*!
+ * \brief Wrapper for the thread-parallel ILU(0) preconditioner.
+ *
+ * The level schedule of the matrix is kept as long as its sparsity pattern does not
+ * change.
+ */
+template <class TypeTag>
+class PreconditionerWrapperLevelScheduledIlu0
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerMatrix) PreconditionerMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerVector) PreconditionerVector;
+
+public:
+    typedef LevelScheduledIlu0<PreconditionerMatrix, PreconditionerVector,
+                               PreconditionerVector> SequentialPreconditioner;
+
+    // the factorization is stored in a matrix of its own
+    static constexpr bool copiesMatrix = true;
+
+    PreconditionerWrapperLevelScheduledIlu0()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+    }
+
+    void prepare(PreconditionerMatrix& matrix)
+    {
+        if (!schedule_ || !schedule_->matches(matrix))
+            schedule_ = std::make_shared<Ilu0LevelSchedule>(matrix);
+
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        seqPreCond_.reset(new SequentialPreconditioner(matrix, relaxationFactor, schedule_));
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    { seqPreCond_.reset(); }
+
+private:
+    std::shared_ptr<const Ilu0LevelSchedule> schedule_;
+    std::unique_ptr<SequentialPreconditioner> seqPreCond_;
+};
+
+/*!
+ * \brief Wrapper for the Jacobi preconditioner which operates on the SELL-C-sigma
+ *        storage of the overlapping matrix.
+ *
+ * The order of the preconditioner is the number of Jacobi steps.
+ */
+template <class TypeTag>
+class PreconditionerWrapperSellJacobi
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerMatrix) PreconditionerMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerVector) PreconditionerVector;
+
+public:
+    typedef SellJacobi<PreconditionerMatrix, PreconditionerVector,
+                       PreconditionerVector> SequentialPreconditioner;
+
+    // the preconditioner references the matrix
+    static constexpr bool copiesMatrix = false;
+
+    PreconditionerWrapperSellJacobi()
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, int, PreconditionerOrder,
+                             "The order of the preconditioner");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+    }
+
+    void prepare(PreconditionerMatrix& matrix)
+    {
+        int order = EWOMS_GET_PARAM(TypeTag, int, PreconditionerOrder);
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        seqPreCond_.reset(new SequentialPreconditioner(matrix, order, relaxationFactor));
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    { seqPreCond_.reset(); }
+
+private:
+    std::unique_ptr<SequentialPreconditioner> seqPreCond_;
+};
 }} // namespace Linear, Ewoms
 
 #endif
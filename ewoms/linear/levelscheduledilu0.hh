@@ -0,0 +1,403 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::LevelScheduledIlu0
+ */
+#ifndef EWOMS_LEVEL_SCHEDULED_ILU0_HH
+#define EWOMS_LEVEL_SCHEDULED_ILU0_HH
+
+#include <opm/common/Unused.hpp>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/paamg/smoother.hh>
+#include <dune/istl/paamg/construction.hh>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/version.hh>
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief The order in which the rows of a sparse matrix can be processed by the
+ *        factorization and the triangular solves of an ILU(0) preconditioner.
+ *
+ * The rows are grouped into levels: A row of the lower triangular part of the matrix only
+ * depends on rows of previous levels, so all rows of a level can be processed
+ * concurrently. The same applies to the upper triangular part where the levels are
+ * processed in reverse order. Since this only depends on the sparsity pattern of the
+ * matrix, it needs to be computed only once per pattern.
+ */
+class Ilu0LevelSchedule
+{
+public:
+    template <class Matrix>
+    explicit Ilu0LevelSchedule(const Matrix& A)
+    {
+        size_t numRows = A.N();
+        patternHash_ = patternHash(A);
+
+        // level of each row for the forward sweep
+        std::vector<unsigned> rowLevel(numRows, 0);
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            unsigned level = 0;
+            const auto& row = A[rowIdx];
+            for (auto colIt = row.begin(); colIt != row.end() && colIt.index() < rowIdx; ++colIt)
+                level = std::max(level, rowLevel[colIt.index()] + 1);
+            rowLevel[rowIdx] = level;
+        }
+        sortByLevel_(rowLevel, lowerRows_, lowerLevelOffsets_);
+
+        // level of each row for the backward sweep
+        for (size_t i = 0; i < numRows; ++i) {
+            size_t rowIdx = numRows - 1 - i;
+            unsigned level = 0;
+            const auto& row = A[rowIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                if (colIt.index() > rowIdx)
+                    level = std::max(level, rowLevel[colIt.index()] + 1);
+            rowLevel[rowIdx] = level;
+        }
+        sortByLevel_(rowLevel, upperRows_, upperLevelOffsets_);
+    }
+
+    /*!
+     * \brief Returns a hash of the sparsity pattern of a matrix.
+     *
+     * This is used to find out whether a schedule can be used for a given matrix.
+     */
+    template <class Matrix>
+    static size_t patternHash(const Matrix& A)
+    {
+        size_t hash = A.N();
+        for (size_t rowIdx = 0; rowIdx < A.N(); ++rowIdx) {
+            const auto& row = A[rowIdx];
+            for (auto colIt = row.begin(); colIt != row.end(); ++colIt)
+                hash = hash*31 + colIt.index();
+            hash = hash*37 + row.size();
+        }
+        return hash;
+    }
+
+    /*!
+     * \brief Returns true if the schedule was computed for a matrix with the same
+     *        sparsity pattern.
+     */
+    template <class Matrix>
+    bool matches(const Matrix& A) const
+    { return A.N() == lowerRows_.size() && patternHash(A) == patternHash_; }
+
+    //! The number of levels of the lower triangular part of the matrix
+    size_t numLowerLevels() const
+    { return lowerLevelOffsets_.size() - 1; }
+
+    //! The number of levels of the upper triangular part of the matrix
+    size_t numUpperLevels() const
+    { return upperLevelOffsets_.size() - 1; }
+
+    //! The rows of the lower triangular part of the matrix sorted by their level
+    const std::vector<unsigned>& lowerRows() const
+    { return lowerRows_; }
+
+    //! The rows of the upper triangular part of the matrix sorted by their level
+    const std::vector<unsigned>& upperRows() const
+    { return upperRows_; }
+
+    //! The index of the first row of a level in lowerRows()
+    size_t lowerLevelBegin(size_t levelIdx) const
+    { return lowerLevelOffsets_[levelIdx]; }
+
+    //! The index of the first row of a level in upperRows()
+    size_t upperLevelBegin(size_t levelIdx) const
+    { return upperLevelOffsets_[levelIdx]; }
+
+private:
+    static void sortByLevel_(const std::vector<unsigned>& rowLevel,
+                             std::vector<unsigned>& rows,
+                             std::vector<size_t>& levelOffsets)
+    {
+        unsigned numLevels = 0;
+        for (unsigned level : rowLevel)
+            numLevels = std::max(numLevels, level + 1);
+
+        // counting sort of the rows by their level
+        levelOffsets.assign(numLevels + 1, 0);
+        for (unsigned level : rowLevel)
+            ++levelOffsets[level + 1];
+        for (unsigned levelIdx = 0; levelIdx < numLevels; ++levelIdx)
+            levelOffsets[levelIdx + 1] += levelOffsets[levelIdx];
+
+        std::vector<size_t> pos(levelOffsets.begin(), levelOffsets.end() - 1);
+        rows.resize(rowLevel.size());
+        for (unsigned rowIdx = 0; rowIdx < rowLevel.size(); ++rowIdx)
+            rows[pos[rowLevel[rowIdx]]++] = rowIdx;
+    }
+
+    size_t patternHash_;
+    std::vector<unsigned> lowerRows_;
+    std::vector<size_t> lowerLevelOffsets_;
+    std::vector<unsigned> upperRows_;
+    std::vector<size_t> upperLevelOffsets_;
+};
+
+/*!
+ * \brief A block ILU(0) preconditioner which uses threads for the factorization and for
+ *        the triangular solves.
+ *
+ * The rows are processed in the order given by an Ilu0LevelSchedule. Since this does
+ * not change the order of the operations for any given row, the results are the same
+ * as the ones of Dune::SeqILU0. The parallelism which can be exploited depends on the
+ * number of rows per level, i.e., on the matrix graph and the numbering of the
+ * degrees of freedom.
+ */
+template <class M, class X, class Y>
+class LevelScheduledIlu0 : public Dune::Preconditioner<X, Y>
+{
+    typedef typename M::block_type MatrixBlock;
+    typedef Dune::BCRSMatrix<MatrixBlock> FactorMatrix;
+
+public:
+    typedef M matrix_type;
+    typedef X domain_type;
+    typedef Y range_type;
+    typedef typename X::field_type field_type;
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,6)
+    //! the kind of computations supported by the operator. Either overlapping or non-overlapping
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+#else
+    // redefine the category
+    enum { category = Dune::SolverCategory::sequential };
+#endif
+
+    /*!
+     * \brief Create the preconditioner and factorize the matrix.
+     *
+     * \param A The matrix to be factorized
+     * \param relaxationFactor The factor by which the result of the preconditioner is
+     *                         scaled
+     * \param schedule The level schedule for the sparsity pattern of the matrix. If it
+     *                 is not specified, it is computed by the constructor.
+     */
+    LevelScheduledIlu0(const M& A,
+                       field_type relaxationFactor,
+                       std::shared_ptr<const Ilu0LevelSchedule> schedule = nullptr)
+        : ilu_(A)
+        , relaxationFactor_(relaxationFactor)
+        , schedule_(schedule)
+    {
+        if (!schedule_)
+            schedule_ = std::make_shared<Ilu0LevelSchedule>(A);
+        assert(schedule_->matches(A));
+
+        diagonal_.resize(ilu_.N(), nullptr);
+        for (size_t rowIdx = 0; rowIdx < ilu_.N(); ++rowIdx) {
+            auto diagIt = ilu_[rowIdx].find(rowIdx);
+            if (diagIt == ilu_[rowIdx].end())
+                OPM_THROW(Opm::NumericalProblem,
+                          "Row " << rowIdx << " of the matrix does not have a diagonal entry");
+            diagonal_[rowIdx] = &(*diagIt);
+        }
+
+        decompose_();
+    }
+
+    void pre(X& x OPM_UNUSED, Y& b OPM_UNUSED) override
+    {}
+
+    void apply(X& v, const Y& d) override
+    {
+        const auto& schedule = *schedule_;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            // forward sweep: solve L*y = d, y is stored in v
+            for (size_t levelIdx = 0; levelIdx < schedule.numLowerLevels(); ++levelIdx) {
+                int begin = static_cast<int>(schedule.lowerLevelBegin(levelIdx));
+                int end = static_cast<int>(schedule.lowerLevelBegin(levelIdx + 1));
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int i = begin; i < end; ++i) {
+                    unsigned rowIdx = schedule.lowerRows()[static_cast<size_t>(i)];
+                    auto tmp = d[rowIdx];
+                    const auto& row = ilu_[rowIdx];
+                    for (auto colIt = row.begin(); colIt.index() < rowIdx; ++colIt)
+                        colIt->mmv(v[colIt.index()], tmp);
+                    v[rowIdx] = tmp;
+                }
+            }
+
+            // backward sweep: solve U*v = y
+            for (size_t levelIdx = 0; levelIdx < schedule.numUpperLevels(); ++levelIdx) {
+                int begin = static_cast<int>(schedule.upperLevelBegin(levelIdx));
+                int end = static_cast<int>(schedule.upperLevelBegin(levelIdx + 1));
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int i = begin; i < end; ++i) {
+                    unsigned rowIdx = schedule.upperRows()[static_cast<size_t>(i)];
+                    auto tmp = v[rowIdx];
+                    const auto& row = ilu_[rowIdx];
+                    auto colIt = row.find(rowIdx);
+                    for (++colIt; colIt != row.end(); ++colIt)
+                        colIt->mmv(v[colIt.index()], tmp);
+
+                    // the inverse of the diagonal block is stored by decompose_()
+                    v[rowIdx] = 0.0;
+                    diagonal_[rowIdx]->umv(tmp, v[rowIdx]);
+                }
+            }
+
+            // the relaxation must only be applied once the backward sweep is finished
+            // because the rows of the following levels use the unrelaxed solution. this
+            // is the same as what Dune::SeqILU0 does.
+            int numRows = static_cast<int>(v.size());
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (int rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                v[static_cast<unsigned>(rowIdx)] *= relaxationFactor_;
+        }
+    }
+
+    void post(X& x OPM_UNUSED) override
+    {}
+
+private:
+    // compute the ILU(0) decomposition. the entries of L are stored below the diagonal
+    // and the ones of U above, and the diagonal blocks of U are stored inverted.
+    void decompose_()
+    {
+        const auto& schedule = *schedule_;
+        int numFailures = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (size_t levelIdx = 0; levelIdx < schedule.numLowerLevels(); ++levelIdx) {
+            int begin = static_cast<int>(schedule.lowerLevelBegin(levelIdx));
+            int end = static_cast<int>(schedule.lowerLevelBegin(levelIdx + 1));
+#ifdef _OPENMP
+#pragma omp for schedule(static) reduction(+:numFailures)
+#endif
+            for (int i = begin; i < end; ++i) {
+                unsigned rowIdx = schedule.lowerRows()[static_cast<size_t>(i)];
+                auto& row = ilu_[rowIdx];
+
+                // all rows which row i depends on belong to previous levels and have
+                // thus already been decomposed
+                for (auto ijIt = row.begin(); ijIt.index() < rowIdx; ++ijIt) {
+                    size_t j = ijIt.index();
+
+                    // L_ij = A_ij * U_jj^-1
+                    ijIt->rightmultiply(*diagonal_[j]);
+
+                    // A_ik -= L_ij * U_jk for all k > j which are in the pattern of row i
+                    const auto& rowJ = ilu_[j];
+                    auto jkIt = rowJ.find(j);
+                    auto ikIt = ijIt;
+                    for (++jkIt, ++ikIt; jkIt != rowJ.end() && ikIt != row.end(); ) {
+                        if (jkIt.index() < ikIt.index())
+                            ++jkIt;
+                        else if (ikIt.index() < jkIt.index())
+                            ++ikIt;
+                        else {
+                            MatrixBlock tmp(*ijIt);
+                            tmp.rightmultiply(*jkIt);
+                            *ikIt -= tmp;
+                            ++ikIt;
+                            ++jkIt;
+                        }
+                    }
+                }
+
+                try {
+                    diagonal_[rowIdx]->invert();
+                }
+                catch (const Dune::FMatrixError&) {
+                    ++numFailures;
+                }
+            }
+        }
+
+        if (numFailures > 0)
+            OPM_THROW(Opm::NumericalProblem,
+                      "ILU(0) decomposition failed: singular diagonal block");
+    }
+
+    FactorMatrix ilu_;
+    std::vector<MatrixBlock*> diagonal_;
+    field_type relaxationFactor_;
+    std::shared_ptr<const Ilu0LevelSchedule> schedule_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+namespace Dune {
+namespace Amg {
+/*!
+ * \brief Allows the level scheduled ILU(0) to be used as the smoother of the AMG.
+ */
+template <class M, class X, class Y>
+struct ConstructionTraits<Ewoms::Linear::LevelScheduledIlu0<M, X, Y> >
+{
+    typedef Ewoms::Linear::LevelScheduledIlu0<M, X, Y> Smoother;
+    typedef DefaultConstructionArgs<Smoother> Arguments;
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
+    static inline std::shared_ptr<Smoother> construct(Arguments& args)
+    {
+        return std::make_shared<Smoother>(args.getMatrix(),
+                                          args.getArgs().relaxationFactor);
+    }
+#else
+    static inline Smoother* construct(Arguments& args)
+    {
+        return new Smoother(args.getMatrix(),
+                            args.getArgs().relaxationFactor);
+    }
+
+    static inline void deconstruct(Smoother* smoother)
+    { delete smoother; }
+#endif
+};
+
+} // namespace Amg
+} // namespace Dune
+
+#endif
@@ -0,0 +1,349 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::LinearSystemIO
+ */
+#ifndef EWOMS_LINEAR_SYSTEM_IO_HH
+#define EWOMS_LINEAR_SYSTEM_IO_HH
+
+#include "overlaptypes.hh"
+#include "blacklist.hh"
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief Writes and reads linear systems of equations using a compact binary format.
+ *
+ * Each file contains the non-overlapping ("native") matrix and right hand side of a
+ * single process, the weights of its equations and the information about the process'
+ * partition which is required to construct the overlapping linear system, i.e., its
+ * border list and its black list. Like the matrix, the right hand side is stored before
+ * the entries of the process border are added up. This allows to replay the linear solver on exactly
+ * the same systems of equations which were encountered by a simulation, either
+ * sequentially or in parallel with the original partitioning.
+ *
+ * All floating point values are stored in double precision and all integers use a
+ * fixed width. The byte order is the one of the machine which wrote the file.
+ */
+class LinearSystemIO
+{
+    static const uint32_t formatVersion_ = 1;
+
+public:
+    /*!
+     * \brief The meta data of a linear system stored in a file.
+     */
+    struct Header
+    {
+        uint32_t numRowsPerBlock;
+        uint32_t numColsPerBlock;
+        int32_t rank;
+        int32_t commSize;
+        uint64_t numRows;
+        uint64_t numNonZeros;
+    };
+
+    /*!
+     * \brief Returns the canonical name of the file for the linear system of a given
+     *        process.
+     *
+     * \param baseName The name of the file without the rank specific suffix
+     * \param rank The rank of the process
+     */
+    static std::string systemFileName(const std::string& baseName, int rank)
+    {
+        std::ostringstream oss;
+        oss << baseName << "_r" << rank << ".ewls";
+        return oss.str();
+    }
+
+    /*!
+     * \brief Write the linear system of the local process to a file.
+     */
+    template <class Matrix, class Vector, class WeightVector>
+    static void write(const std::string& fileName,
+                      const Matrix& matrix,
+                      const Vector& rhs,
+                      const WeightVector& eqWeights,
+                      const BorderList& borderList,
+                      const BlackList& blackList,
+                      int rank,
+                      int commSize)
+    {
+        typedef typename Matrix::block_type MatrixBlock;
+
+        std::ofstream os(fileName, std::ios::binary);
+        if (!os)
+            OPM_THROW(std::runtime_error,
+                      "Could not open file '" << fileName << "' for writing");
+
+        os.write(magic_(), magicSize_);
+        writeValue_(os, static_cast<uint32_t>(formatVersion_));
+
+        Header header;
+        header.numRowsPerBlock = MatrixBlock::rows;
+        header.numColsPerBlock = MatrixBlock::cols;
+        header.rank = rank;
+        header.commSize = commSize;
+        header.numRows = matrix.N();
+        header.numNonZeros = matrix.nonzeroes();
+        writeHeader_(os, header);
+
+        // the sparsity pattern
+        for (size_t rowIdx = 0; rowIdx < matrix.N(); ++rowIdx)
+            writeValue_(os, static_cast<uint32_t>(matrix[rowIdx].getsize()));
+        for (size_t rowIdx = 0; rowIdx < matrix.N(); ++rowIdx) {
+            auto colIt = matrix[rowIdx].begin();
+            const auto& colEndIt = matrix[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt)
+                writeValue_(os, static_cast<uint32_t>(colIt.index()));
+        }
+
+        // the values of the matrix entries
+        for (size_t rowIdx = 0; rowIdx < matrix.N(); ++rowIdx) {
+            auto colIt = matrix[rowIdx].begin();
+            const auto& colEndIt = matrix[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt)
+                for (unsigned i = 0; i < header.numRowsPerBlock; ++i)
+                    for (unsigned j = 0; j < header.numColsPerBlock; ++j)
+                        writeValue_(os, static_cast<double>((*colIt)[i][j]));
+        }
+
+        writeBlockVector_(os, rhs, matrix.N());
+        writeBlockVector_(os, eqWeights, matrix.N());
+
+        // the border list
+        writeValue_(os, static_cast<uint64_t>(borderList.size()));
+        auto borderIt = borderList.begin();
+        const auto& borderEndIt = borderList.end();
+        for (; borderIt != borderEndIt; ++borderIt) {
+            writeValue_(os, static_cast<int32_t>(borderIt->localIdx));
+            writeValue_(os, static_cast<int32_t>(borderIt->peerIdx));
+            writeValue_(os, static_cast<uint32_t>(borderIt->peerRank));
+            writeValue_(os, static_cast<uint32_t>(borderIt->borderDistance));
+        }
+
+        // the black list
+        const auto& blackListedIndices = blackList.nativeIndices();
+        writeValue_(os, static_cast<uint64_t>(blackListedIndices.size()));
+        auto blackIt = blackListedIndices.begin();
+        const auto& blackEndIt = blackListedIndices.end();
+        for (; blackIt != blackEndIt; ++blackIt)
+            writeValue_(os, static_cast<int32_t>(*blackIt));
+
+        const auto& peerBlackLists = blackList.peerBlackLists();
+        writeValue_(os, static_cast<uint64_t>(peerBlackLists.size()));
+        auto peerIt = peerBlackLists.begin();
+        const auto& peerEndIt = peerBlackLists.end();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            writeValue_(os, static_cast<uint32_t>(peerIt->first));
+            writeValue_(os, static_cast<uint64_t>(peerIt->second.size()));
+            for (const auto& entry : peerIt->second) {
+                writeValue_(os, static_cast<int32_t>(entry.nativeIndexOfPeer));
+                writeValue_(os, static_cast<int32_t>(entry.myOwnNativeIndex));
+            }
+        }
+
+        if (!os)
+            OPM_THROW(std::runtime_error,
+                      "Error while writing the linear system to '" << fileName << "'");
+    }
+
+    /*!
+     * \brief Read a linear system which was written by write().
+     *
+     * The block size of the matrix must match the one of the file.
+     */
+    template <class Matrix, class Vector>
+    static Header read(const std::string& fileName,
+                       Matrix& matrix,
+                       Vector& rhs,
+                       Vector& eqWeights,
+                       BorderList& borderList,
+                       BlackList& blackList)
+    {
+        typedef typename Matrix::block_type MatrixBlock;
+
+        std::ifstream is(fileName, std::ios::binary);
+        if (!is)
+            OPM_THROW(std::runtime_error,
+                      "Could not open file '" << fileName << "' for reading");
+
+        char magic[magicSize_];
+        is.read(magic, magicSize_);
+        if (!is || std::memcmp(magic, magic_(), magicSize_) != 0)
+            OPM_THROW(std::runtime_error,
+                      "File '" << fileName << "' does not contain a linear system");
+
+        uint32_t version = readValue_<uint32_t>(is);
+        if (version != formatVersion_)
+            OPM_THROW(std::runtime_error,
+                      "Unsupported version " << version << " of the linear system format");
+
+        Header header = readHeader_(is);
+        if (header.numRowsPerBlock != static_cast<uint32_t>(MatrixBlock::rows)
+            || header.numColsPerBlock != static_cast<uint32_t>(MatrixBlock::cols))
+            OPM_THROW(std::runtime_error,
+                      "The linear system in '" << fileName << "' uses "
+                      << header.numRowsPerBlock << "x" << header.numColsPerBlock
+                      << " blocks, but " << MatrixBlock::rows << "x" << MatrixBlock::cols
+                      << " blocks are required");
+
+        size_t numRows = static_cast<size_t>(header.numRows);
+        size_t numNonZeros = static_cast<size_t>(header.numNonZeros);
+
+        // the sparsity pattern
+        std::vector<uint32_t> rowSizes(numRows);
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            rowSizes[rowIdx] = readValue_<uint32_t>(is);
+
+        matrix.setSize(numRows, numRows, numNonZeros);
+        matrix.setBuildMode(Matrix::row_wise);
+        auto createIt = matrix.createbegin();
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx, ++createIt)
+            for (uint32_t i = 0; i < rowSizes[rowIdx]; ++i)
+                createIt.insert(readValue_<uint32_t>(is));
+
+        // the values of the matrix entries
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            auto colIt = matrix[rowIdx].begin();
+            const auto& colEndIt = matrix[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt)
+                for (unsigned i = 0; i < header.numRowsPerBlock; ++i)
+                    for (unsigned j = 0; j < header.numColsPerBlock; ++j)
+                        (*colIt)[i][j] = readValue_<double>(is);
+        }
+
+        readBlockVector_(is, rhs, numRows);
+        readBlockVector_(is, eqWeights, numRows);
+
+        // the border list
+        borderList.clear();
+        uint64_t numBorderIndices = readValue_<uint64_t>(is);
+        for (uint64_t i = 0; i < numBorderIndices; ++i) {
+            BorderIndex borderIdx;
+            borderIdx.localIdx = static_cast<Index>(readValue_<int32_t>(is));
+            borderIdx.peerIdx = static_cast<Index>(readValue_<int32_t>(is));
+            borderIdx.peerRank = static_cast<ProcessRank>(readValue_<uint32_t>(is));
+            borderIdx.borderDistance = static_cast<BorderDistance>(readValue_<uint32_t>(is));
+            borderList.push_back(borderIdx);
+        }
+
+        // the black list
+        blackList = BlackList();
+        uint64_t numBlackListed = readValue_<uint64_t>(is);
+        for (uint64_t i = 0; i < numBlackListed; ++i)
+            blackList.addIndex(static_cast<Index>(readValue_<int32_t>(is)));
+
+        uint64_t numPeers = readValue_<uint64_t>(is);
+        for (uint64_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            ProcessRank peerRank = static_cast<ProcessRank>(readValue_<uint32_t>(is));
+            BlackList::PeerBlackList peerBlackList(static_cast<size_t>(readValue_<uint64_t>(is)));
+            for (auto& entry : peerBlackList) {
+                entry.nativeIndexOfPeer = static_cast<Index>(readValue_<int32_t>(is));
+                entry.myOwnNativeIndex = static_cast<Index>(readValue_<int32_t>(is));
+            }
+            blackList.setPeerList(peerRank, peerBlackList);
+        }
+
+        if (!is)
+            OPM_THROW(std::runtime_error,
+                      "Error while reading the linear system from '" << fileName << "'");
+
+        return header;
+    }
+
+private:
+    static const size_t magicSize_ = 8;
+
+    static const char* magic_()
+    { return "EWOMSLS"; } // including the terminating zero, this is 8 bytes
+
+    template <class T>
+    static void writeValue_(std::ostream& os, const T& value)
+    { os.write(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    template <class T>
+    static T readValue_(std::istream& is)
+    {
+        T value;
+        is.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    }
+
+    static void writeHeader_(std::ostream& os, const Header& header)
+    {
+        writeValue_(os, header.numRowsPerBlock);
+        writeValue_(os, header.numColsPerBlock);
+        writeValue_(os, header.rank);
+        writeValue_(os, header.commSize);
+        writeValue_(os, header.numRows);
+        writeValue_(os, header.numNonZeros);
+    }
+
+    static Header readHeader_(std::istream& is)
+    {
+        Header header;
+        header.numRowsPerBlock = readValue_<uint32_t>(is);
+        header.numColsPerBlock = readValue_<uint32_t>(is);
+        header.rank = readValue_<int32_t>(is);
+        header.commSize = readValue_<int32_t>(is);
+        header.numRows = readValue_<uint64_t>(is);
+        header.numNonZeros = readValue_<uint64_t>(is);
+        return header;
+    }
+
+    template <class BlockVector>
+    static void writeBlockVector_(std::ostream& os, const BlockVector& v, size_t numRows)
+    {
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            for (unsigned i = 0; i < v[rowIdx].size(); ++i)
+                writeValue_(os, static_cast<double>(v[rowIdx][i]));
+    }
+
+    template <class BlockVector>
+    static void readBlockVector_(std::istream& is, BlockVector& v, size_t numRows)
+    {
+        v.resize(numRows);
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx)
+            for (unsigned i = 0; i < v[rowIdx].size(); ++i)
+                v[rowIdx][i] = readValue_<double>(is);
+    }
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
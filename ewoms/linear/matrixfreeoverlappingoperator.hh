@@ -0,0 +1,137 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::MatrixFreeOverlappingOperator
+ */
+#ifndef EWOMS_MATRIX_FREE_OVERLAPPING_OPERATOR_HH
+#define EWOMS_MATRIX_FREE_OVERLAPPING_OPERATOR_HH
+
+#include <dune/istl/operators.hh>
+#include <dune/common/version.hh>
+
+#include <memory>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief An overlap aware linear operator which does not require the assembled matrix.
+ *
+ * The product of the Jacobian matrix and a vector is computed by the linearizer on the
+ * non-overlapping ("native") vectors, i.e., the linearizer must provide an
+ * applyJacobian(nativeX, nativeY) method. The result is scaled by the weights of the
+ * equations and the entries on the process borders are added up the same way as it is
+ * done for the assembled matrix.
+ *
+ * The overlapping matrix which is passed to the constructor only contains the part of
+ * the Jacobian which is stored by the linearizer. It is used to construct the
+ * preconditioner, and to provide the overlap.
+ */
+template <class OverlappingMatrix, class OverlappingVector, class NativeVector, class Linearizer>
+class MatrixFreeOverlappingOperator
+    : public Dune::LinearOperator<OverlappingVector, OverlappingVector>
+{
+    typedef typename OverlappingMatrix::Overlap Overlap;
+    typedef typename OverlappingVector::block_type VectorBlock;
+
+public:
+    //! export types
+    typedef OverlappingVector domain_type;
+    typedef OverlappingVector range_type;
+    typedef typename domain_type::field_type field_type;
+
+    MatrixFreeOverlappingOperator(const OverlappingMatrix& reducedMatrix,
+                                  Linearizer& linearizer,
+                                  const std::vector<VectorBlock>& eqWeights)
+        : reducedMatrix_(reducedMatrix)
+        , linearizer_(linearizer)
+        , eqWeights_(eqWeights)
+    {}
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,6)
+    //! the kind of computations supported by the operator. Either overlapping or non-overlapping
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::overlapping; }
+#else
+    // redefine the category
+    enum { category = Dune::SolverCategory::overlapping };
+#endif
+
+    //! apply operator to x:  \f$ y = A(x) \f$
+    virtual void apply(const domain_type& x, range_type& y) const override
+    {
+        x.assignTo(nativeX_);
+        linearizer_.applyJacobian(nativeX_, nativeY_);
+
+        // scale the rows the same way as the assembled matrix
+        int numNative = static_cast<int>(nativeY_.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int nativeRowIdx = 0; nativeRowIdx < numNative; ++nativeRowIdx) {
+            auto& row = nativeY_[static_cast<unsigned>(nativeRowIdx)];
+            const auto& weights = eqWeights_[static_cast<unsigned>(nativeRowIdx)];
+            for (unsigned eqIdx = 0; eqIdx < row.size(); ++eqIdx)
+                row[eqIdx] *= weights[eqIdx];
+        }
+
+        y.assignAddBorder(nativeY_);
+    }
+
+    //! apply operator to x, scale and add:  \f$ y = y + \alpha A(x) \f$
+    virtual void applyscaleadd(field_type alpha,
+                               const domain_type& x,
+                               range_type& y) const override
+    {
+        if (!tmp_)
+            tmp_.reset(new range_type(y));
+
+        apply(x, *tmp_);
+        y.axpy(alpha, *tmp_);
+    }
+
+    /*!
+     * \brief Returns the part of the Jacobian matrix which is stored.
+     */
+    const OverlappingMatrix& reducedMatrix() const
+    { return reducedMatrix_; }
+
+    const Overlap& overlap() const
+    { return reducedMatrix_.overlap(); }
+
+private:
+    const OverlappingMatrix& reducedMatrix_;
+    Linearizer& linearizer_;
+    const std::vector<VectorBlock>& eqWeights_;
+
+    mutable NativeVector nativeX_;
+    mutable NativeVector nativeY_;
+    mutable std::unique_ptr<range_type> tmp_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
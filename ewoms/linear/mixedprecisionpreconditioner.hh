@@ -0,0 +1,186 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::MixedPrecisionPreconditioner
+ */
+#ifndef EWOMS_MIXED_PRECISION_PRECONDITIONER_HH
+#define EWOMS_MIXED_PRECISION_PRECONDITIONER_HH
+
+#include <opm/common/Unused.hpp>
+
+#include <dune/istl/preconditioners.hh>
+
+#include <dune/common/version.hh>
+
+#include <type_traits>
+#include <memory>
+#include <cassert>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief Applies a preconditioner which uses a different floating point type than the
+ *        linear solver.
+ *
+ * This allows to store the matrix of the preconditioner (e.g., the ILU factors or the
+ * AMG hierarchy) in single precision while the Krylov iteration and the convergence
+ * checks of the linear solver are done in double precision. Since the preconditioner
+ * is only required to approximate the inverse of the matrix, the reduced precision
+ * merely makes it a bit less exact.
+ *
+ * The vectors of the linear solver are converted to the precision of the preconditioner
+ * before it is applied and the result is converted back afterwards. The pre() and
+ * post() methods of the inner preconditioner operate on these converted vectors and
+ * are assumed not to modify the solution, i.e., their results are not copied back.
+ *
+ * If the floating point types of the preconditioner and of the linear solver are the
+ * same, this class simply forwards all calls to the inner preconditioner.
+ */
+template <class InnerPreconditioner,
+          class OuterVector,
+          bool isMixed = !std::is_same<typename InnerPreconditioner::domain_type::field_type,
+                                       typename OuterVector::field_type>::value>
+class MixedPrecisionPreconditioner
+    : public Dune::Preconditioner<OuterVector, OuterVector>
+{
+    typedef typename InnerPreconditioner::domain_type InnerVector;
+
+public:
+    typedef OuterVector domain_type;
+    typedef OuterVector range_type;
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,6)
+    //! the kind of computations supported by the operator. Either overlapping or non-overlapping
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::overlapping; }
+#else
+    // redefine the category
+    enum { category = Dune::SolverCategory::overlapping };
+#endif
+
+    /*!
+     * \brief Create the mixed precision preconditioner.
+     *
+     * \param innerPreCond The preconditioner which uses reduced precision
+     * \param prototype A vector which exhibits the layout of the vectors expected by
+     *                  the inner preconditioner
+     */
+    MixedPrecisionPreconditioner(std::shared_ptr<InnerPreconditioner> innerPreCond,
+                                 const InnerVector* prototype)
+        : innerPreCond_(innerPreCond)
+        , innerX_(*prototype)
+        , innerD_(*prototype)
+    {}
+
+    void pre(domain_type& x, range_type& b) override
+    {
+        convert_(innerX_, x);
+        convert_(innerD_, b);
+        innerPreCond_->pre(innerX_, innerD_);
+    }
+
+    void apply(domain_type& x, const range_type& d) override
+    {
+        convert_(innerD_, d);
+        innerX_ = 0.0;
+        innerPreCond_->apply(innerX_, innerD_);
+        convert_(x, innerX_);
+    }
+
+    void post(domain_type& x) override
+    {
+        convert_(innerX_, x);
+        innerPreCond_->post(innerX_);
+    }
+
+private:
+    template <class DestVector, class SrcVector>
+    static void convert_(DestVector& dest, const SrcVector& src)
+    {
+        typedef typename DestVector::field_type DestScalar;
+
+        assert(dest.size() == src.size());
+        int n = static_cast<int>(src.size());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int blockIdx = 0; blockIdx < n; ++blockIdx) {
+            auto& destBlock = dest[static_cast<unsigned>(blockIdx)];
+            const auto& srcBlock = src[static_cast<unsigned>(blockIdx)];
+            for (unsigned i = 0; i < destBlock.size(); ++i)
+                destBlock[i] = static_cast<DestScalar>(srcBlock[i]);
+        }
+    }
+
+    std::shared_ptr<InnerPreconditioner> innerPreCond_;
+    InnerVector innerX_;
+    InnerVector innerD_;
+};
+
+/*!
+ * \brief Specialization of the mixed precision preconditioner for the case where the
+ *        preconditioner and the linear solver use the same floating point type.
+ */
+template <class InnerPreconditioner, class OuterVector>
+class MixedPrecisionPreconditioner<InnerPreconditioner, OuterVector, /*isMixed=*/false>
+    : public Dune::Preconditioner<OuterVector, OuterVector>
+{
+    typedef typename InnerPreconditioner::domain_type InnerVector;
+
+public:
+    typedef OuterVector domain_type;
+    typedef OuterVector range_type;
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,6)
+    //! the kind of computations supported by the operator. Either overlapping or non-overlapping
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::overlapping; }
+#else
+    // redefine the category
+    enum { category = Dune::SolverCategory::overlapping };
+#endif
+
+    MixedPrecisionPreconditioner(std::shared_ptr<InnerPreconditioner> innerPreCond,
+                                 const InnerVector* prototype OPM_UNUSED = nullptr)
+        : innerPreCond_(innerPreCond)
+    {}
+
+    void pre(domain_type& x, range_type& b) override
+    { innerPreCond_->pre(x, b); }
+
+    void apply(domain_type& x, const range_type& d) override
+    { innerPreCond_->apply(x, d); }
+
+    void post(domain_type& x) override
+    { innerPreCond_->post(x); }
+
+private:
+    std::shared_ptr<InnerPreconditioner> innerPreCond_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
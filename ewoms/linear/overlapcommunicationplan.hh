@@ -0,0 +1,249 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::OverlapCommunicationPlan
+ */
+#ifndef EWOMS_OVERLAP_COMMUNICATION_PLAN_HH
+#define EWOMS_OVERLAP_COMMUNICATION_PLAN_HH
+
+#include "overlaptypes.hh"
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <vector>
+#include <cassert>
+#include <cstddef>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief Returns a new tag for the messages of a communication plan.
+ *
+ * Plans whose exchanges may be in flight at the same time must use different tags
+ * because MPI matches the messages of a peer process only by their tag. All
+ * processes must thus request the tags of their plans in the same order. Tag 0 is
+ * reserved for plans which are only used by blocking exchanges.
+ */
+inline int newOverlapCommunicationTag()
+{
+    // the MPI standard guarantees that tags up to 32767 are valid
+    static const int maxTag = 32767;
+    static int lastTag = 0;
+
+    lastTag = lastTag%maxTag + 1;
+    return lastTag;
+}
+
+/*!
+ * \brief Manages the buffers and the persistent MPI requests which are required to
+ *        repeatedly exchange values with a fixed set of peer processes.
+ *
+ * The send and receive buffers of all peers are stored contiguously, i.e., the values
+ * for the first peer come first, then the ones for the second peer, etc. The MPI
+ * requests are created once using MPI_Send_init() and MPI_Recv_init(), and each
+ * exchange is initiated using a single call to MPI_Startall() and completed using a
+ * single call to MPI_Waitall().
+ *
+ * The plan is set up by calling addPeer() for each peer process, followed by a call to
+ * finalize(). Afterwards, the number and the order of the values which are exchanged
+ * with each peer must not change anymore. Since the buffers and the requests are owned
+ * by the plan, each object which exchanges values concurrently with other ones needs a
+ * plan of its own.
+ */
+template <class ValueType>
+class OverlapCommunicationPlan
+{
+public:
+    OverlapCommunicationPlan()
+        : finalized_(false)
+    {
+        sendOffsets_.push_back(0);
+        recvOffsets_.push_back(0);
+    }
+
+    // plans own MPI requests which refer to their buffers and thus can't be copied
+    OverlapCommunicationPlan(const OverlapCommunicationPlan&) = delete;
+
+    ~OverlapCommunicationPlan()
+    {
+#if HAVE_MPI
+        int mpiIsFinalized;
+        MPI_Finalized(&mpiIsFinalized);
+        if (mpiIsFinalized)
+            return;
+
+        for (unsigned i = 0; i < requests_.size(); ++i)
+            MPI_Request_free(&requests_[i]);
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Add a peer process with which values are exchanged.
+     *
+     * \param peerRank The rank of the peer process
+     * \param numSend The number of values which are send to the peer
+     * \param numRecv The number of values which are received from the peer
+     */
+    void addPeer(ProcessRank peerRank, size_t numSend, size_t numRecv)
+    {
+        assert(!finalized_);
+
+        peerRanks_.push_back(peerRank);
+        sendOffsets_.push_back(sendOffsets_.back() + numSend);
+        recvOffsets_.push_back(recvOffsets_.back() + numRecv);
+    }
+
+    /*!
+     * \brief Allocate the buffers and create the persistent MPI requests.
+     *
+     * The ranks of the peer processes are relative to the communicator comm. The
+     * messages of the plan use the given tag, which must be the same for the plans
+     * of all peers. (see newOverlapCommunicationTag().)
+     */
+    void finalize(Communicator comm, int tag = 0)
+    {
+        assert(!finalized_);
+        finalized_ = true;
+
+        sendValues_.resize(sendOffsets_.back());
+        recvValues_.resize(recvOffsets_.back());
+
+#if HAVE_MPI
+        // the receive requests come first in the array of requests so that they are
+        // posted before the send requests are started
+        size_t numPeers = peerRanks_.size();
+        requests_.resize(2*numPeers);
+        for (unsigned peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            size_t numBytes = sizeof(ValueType)*(recvOffsets_[peerIdx + 1] - recvOffsets_[peerIdx]);
+            MPI_Recv_init(recvValues_.data() + recvOffsets_[peerIdx],
+                          static_cast<int>(numBytes),
+                          MPI_BYTE,
+                          static_cast<int>(peerRanks_[peerIdx]),
+                          tag,
+                          comm,
+                          &requests_[peerIdx]);
+        }
+
+        for (unsigned peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            size_t numBytes = sizeof(ValueType)*(sendOffsets_[peerIdx + 1] - sendOffsets_[peerIdx]);
+            MPI_Send_init(sendValues_.data() + sendOffsets_[peerIdx],
+                          static_cast<int>(numBytes),
+                          MPI_BYTE,
+                          static_cast<int>(peerRanks_[peerIdx]),
+                          tag,
+                          comm,
+                          &requests_[numPeers + peerIdx]);
+        }
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Returns the number of peer processes of the plan.
+     */
+    size_t numPeers() const
+    { return peerRanks_.size(); }
+
+    /*!
+     * \brief Returns the rank of a peer process given its index in the plan.
+     */
+    ProcessRank peerRank(unsigned peerIdx) const
+    { return peerRanks_[peerIdx]; }
+
+    /*!
+     * \brief Returns the offset of the first value in the send buffer for a peer.
+     *
+     * The offset for peerIdx == numPeers() is the total size of the send buffer.
+     */
+    size_t sendOffset(unsigned peerIdx) const
+    { return sendOffsets_[peerIdx]; }
+
+    /*!
+     * \brief Returns the offset of the first value in the receive buffer for a peer.
+     *
+     * The offset for peerIdx == numPeers() is the total size of the receive buffer.
+     */
+    size_t recvOffset(unsigned peerIdx) const
+    { return recvOffsets_[peerIdx]; }
+
+    /*!
+     * \brief Returns the send buffer of all peers.
+     */
+    std::vector<ValueType>& sendValues()
+    { return sendValues_; }
+
+    /*!
+     * \brief Returns the receive buffer of all peers.
+     */
+    const std::vector<ValueType>& recvValues() const
+    { return recvValues_; }
+
+    /*!
+     * \brief Initiate the exchange of the values with all peers.
+     *
+     * The send buffer must have been filled before this method is called and must not
+     * be modified before wait() returns.
+     */
+    void start()
+    {
+        assert(finalized_);
+#if HAVE_MPI
+        if (!requests_.empty())
+            MPI_Startall(static_cast<int>(requests_.size()), requests_.data());
+#endif // HAVE_MPI
+    }
+
+    /*!
+     * \brief Wait until all values have been sent and received.
+     */
+    void wait()
+    {
+        assert(finalized_);
+#if HAVE_MPI
+        if (!requests_.empty())
+            MPI_Waitall(static_cast<int>(requests_.size()), requests_.data(), MPI_STATUSES_IGNORE);
+#endif // HAVE_MPI
+    }
+
+private:
+    bool finalized_;
+
+    std::vector<ProcessRank> peerRanks_;
+    std::vector<size_t> sendOffsets_;
+    std::vector<size_t> recvOffsets_;
+
+    std::vector<ValueType> sendValues_;
+    std::vector<ValueType> recvValues_;
+
+#if HAVE_MPI
+    std::vector<MPI_Request> requests_;
+#endif // HAVE_MPI
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
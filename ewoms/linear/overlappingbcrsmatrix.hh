@@ -30,6 +30,8 @@
 #include <ewoms/linear/domesticoverlapfrombcrsmatrix.hh>
 #include <ewoms/linear/globalindices.hh>
 #include <ewoms/linear/blacklist.hh>
+#include <ewoms/linear/overlapcommunicationplan.hh>
+#include <ewoms/linear/sellcsigmamatrix.hh>
 #include <ewoms/parallel/mpibuffer.hh>
 
 #include <opm/common/Valgrind.hpp>
@@ -40,6 +42,7 @@
 #include <algorithm>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -67,21 +70,64 @@ public:
     typedef typename ParentType::block_type block_type;
     typedef typename ParentType::field_type field_type;
 
-    // no real copying done at the moment
+private:
+    typedef SellCSigmaMatrix<block_type> SellMatrix;
+
+public:
+    // the copy shares the overlap with the original matrix, but it gets its own
+    // communication plan and the addresses of its own blocks. the SELL-C-sigma storage
+    // is not copied, i.e., the copy uses the BCRS storage for matrix-vector products.
     OverlappingBCRSMatrix(const OverlappingBCRSMatrix& other)
         : ParentType(other)
-    {}
+        , myRank_(other.myRank_)
+        , overlap_(other.overlap_)
+        , borderRows_(other.borderRows_)
+        , interiorRows_(other.interiorRows_)
+        , nativeRowOffsets_(other.nativeRowOffsets_)
+    {
+        // map the addresses of the blocks of the original matrix to the ones of the
+        // copy. this works because both matrices exhibit the same sparsity pattern.
+        std::unordered_map<const block_type*, block_type*> blockMap;
+        for (unsigned rowIdx = 0; rowIdx < this->N(); ++rowIdx) {
+            auto colIt = (*this)[rowIdx].begin();
+            auto otherColIt = other[rowIdx].begin();
+            const auto& colEndIt = (*this)[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt, ++otherColIt)
+                blockMap[&(*otherColIt)] = &(*colIt);
+        }
+
+        auto mapBlock = [&blockMap](const block_type* otherBlock) -> block_type*
+        { return otherBlock ? blockMap.at(otherBlock) : nullptr; };
+
+        nativeBlockDest_.reserve(other.nativeBlockDest_.size());
+        for (const auto* block : other.nativeBlockDest_)
+            nativeBlockDest_.push_back(mapBlock(block));
+        sendBlocks_.reserve(other.sendBlocks_.size());
+        for (const auto* block : other.sendBlocks_)
+            sendBlocks_.push_back(mapBlock(block));
+        recvBlocks_.reserve(other.recvBlocks_.size());
+        for (const auto* block : other.recvBlocks_)
+            recvBlocks_.push_back(mapBlock(block));
+
+        // the MPI requests of a plan refer to its buffers, so the copy needs its own one
+        for (unsigned peerIdx = 0; peerIdx < other.commPlan_.numPeers(); ++peerIdx)
+            commPlan_.addPeer(other.commPlan_.peerRank(peerIdx),
+                              other.commPlan_.sendOffset(peerIdx + 1) - other.commPlan_.sendOffset(peerIdx),
+                              other.commPlan_.recvOffset(peerIdx + 1) - other.commPlan_.recvOffset(peerIdx));
+        commPlan_.finalize(overlap_->communicator());
+    }
 
     template <class NativeBCRSMatrix>
     OverlappingBCRSMatrix(const NativeBCRSMatrix& nativeMatrix,
                           const BorderList& borderList,
                           const BlackList& blackList,
-                          unsigned overlapSize)
+                          unsigned overlapSize,
+                          Communicator comm = Dune::MPIHelper::getCommunicator())
     {
-        overlap_ = std::make_shared<Overlap>(nativeMatrix, borderList, blackList, overlapSize);
+        overlap_ = std::make_shared<Overlap>(nativeMatrix, borderList, blackList, overlapSize, comm);
         myRank_ = 0;
 #if HAVE_MPI
-        MPI_Comm_rank(MPI_COMM_WORLD, &myRank_);
+        MPI_Comm_rank(comm, &myRank_);
 #endif // HAVE_MPI
 
         // build the overlapping matrix from the non-overlapping
@@ -89,29 +135,29 @@ public:
         build_(nativeMatrix);
     }
 
-    ~OverlappingBCRSMatrix()
+    /*!
+     * \brief Create an overlapping matrix whose overlap is determined by a different
+     *        sparsity pattern than the one of the non-overlapping matrix.
+     *
+     * This is required if the non-overlapping matrix only stores a part of the linear
+     * operator, e.g., if the operator is applied matrix-free. The stencil pattern must
+     * contain all non-zero blocks of the non-overlapping matrix.
+     */
+    template <class NativeBCRSMatrix, class StencilPattern>
+    OverlappingBCRSMatrix(const NativeBCRSMatrix& nativeMatrix,
+                          const StencilPattern& stencilPattern,
+                          const BorderList& borderList,
+                          const BlackList& blackList,
+                          unsigned overlapSize,
+                          Communicator comm = Dune::MPIHelper::getCommunicator())
     {
-        if (overlap_.use_count() == 0)
-            return;
-
-        // delete all MPI buffers
-        const PeerSet& peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-
-            delete rowSizesRecvBuff_[peerRank];
-            delete rowIndicesRecvBuff_[peerRank];
-            delete entryColIndicesRecvBuff_[peerRank];
-            delete entryValuesRecvBuff_[peerRank];
+        overlap_ = std::make_shared<Overlap>(stencilPattern, borderList, blackList, overlapSize, comm);
+        myRank_ = 0;
+#if HAVE_MPI
+        MPI_Comm_rank(comm, &myRank_);
+#endif // HAVE_MPI
 
-            delete numRowsSendBuff_[peerRank];
-            delete rowSizesSendBuff_[peerRank];
-            delete rowIndicesSendBuff_[peerRank];
-            delete entryColIndicesSendBuff_[peerRank];
-            delete entryValuesSendBuff_[peerRank];
-        }
+        build_(nativeMatrix);
     }
 
     ParentType& asParent()
@@ -126,6 +172,138 @@ public:
     const Overlap& overlap() const
     { return *overlap_; }
 
+    /*!
+     * \brief Returns the indices of the rows which are required by peer processes.
+     *
+     * These are the rows which must be up to date before the communication of a vector
+     * can be initiated.
+     */
+    const std::vector<unsigned>& borderRows() const
+    { return borderRows_; }
+
+    /*!
+     * \brief Returns the indices of the rows which are not required by any peer process.
+     */
+    const std::vector<unsigned>& interiorRows() const
+    { return interiorRows_; }
+
+    /*!
+     * \brief Compute \f$ y = A x \f$ for the rows required by peer processes.
+     */
+    template <class DomainVector, class RangeVector>
+    void mvBorder(const DomainVector& x, RangeVector& y) const
+    {
+        if (sellBorder_)
+            sellBorder_->mv(x, y);
+        else
+            mvRows_(borderRows_, x, y);
+    }
+
+    /*!
+     * \brief Compute \f$ y = A x \f$ for the rows not required by any peer process.
+     */
+    template <class DomainVector, class RangeVector>
+    void mvInterior(const DomainVector& x, RangeVector& y) const
+    {
+        if (sellInterior_)
+            sellInterior_->mv(x, y);
+        else
+            mvRows_(interiorRows_, x, y);
+    }
+
+    /*!
+     * \brief Compute \f$ y = y + \alpha A x \f$ for the rows required by peer processes.
+     */
+    template <class DomainVector, class RangeVector>
+    void usmvBorder(field_type alpha, const DomainVector& x, RangeVector& y) const
+    {
+        if (sellBorder_)
+            sellBorder_->usmv(alpha, x, y);
+        else
+            usmvRows_(borderRows_, alpha, x, y);
+    }
+
+    /*!
+     * \brief Compute \f$ y = y + \alpha A x \f$ for the rows not required by any peer
+     *        process.
+     */
+    template <class DomainVector, class RangeVector>
+    void usmvInterior(field_type alpha, const DomainVector& x, RangeVector& y) const
+    {
+        if (sellInterior_)
+            sellInterior_->usmv(alpha, x, y);
+        else
+            usmvRows_(interiorRows_, alpha, x, y);
+    }
+
+    /*!
+     * \brief Use an additional copy of the matrix in the SELL-C-sigma format for the
+     *        matrix-vector products.
+     *
+     * The copy is used by the mvBorder(), mvInterior(), usmvBorder() and usmvInterior()
+     * methods. Since it does not automatically follow changes of the matrix entries,
+     * updateSellStorage() must be called after the matrix has been modified.
+     *
+     * \param sortingWindow The number of consecutive rows which are sorted by their
+     *                      length to reduce the amount of padding
+     */
+    void enableSellStorage(unsigned sortingWindow = 128)
+    {
+        sellBorder_.reset(new SellMatrix);
+        sellBorder_->build(*this, borderRows_, sortingWindow);
+
+        sellInterior_.reset(new SellMatrix);
+        sellInterior_->build(*this, interiorRows_, sortingWindow);
+    }
+
+    /*!
+     * \brief Returns true iff the matrix-vector products use the SELL-C-sigma format.
+     */
+    bool sellStorageEnabled() const
+    { return static_cast<bool>(sellInterior_); }
+
+    /*!
+     * \brief Copy the current values of the matrix entries to the SELL-C-sigma storage.
+     *
+     * If the SELL-C-sigma storage is not enabled, this method is a no-op.
+     */
+    void updateSellStorage()
+    {
+        if (sellBorder_)
+            sellBorder_->updateValues();
+        if (sellInterior_)
+            sellInterior_->updateValues();
+    }
+
+    /*!
+     * \brief Invert the diagonal blocks of the SELL-C-sigma storage for
+     *        sellJacobiStep().
+     *
+     * This must be called after updateSellStorage().
+     */
+    void updateSellInverseDiagonal()
+    {
+        sellBorder_->updateInverseDiagonal();
+        sellInterior_->updateInverseDiagonal();
+    }
+
+    /*!
+     * \brief Perform a damped Jacobi step \f$ x_{new} = x + \omega D^{-1} (b - A x)
+     *        \f$ for all rows using the SELL-C-sigma storage.
+     *
+     * The SELL-C-sigma storage must be enabled and updateSellInverseDiagonal() must
+     * have been called before. x and xNew must not be the same vector.
+     */
+    template <class DomainVector, class RangeVector>
+    void sellJacobiStep(typename DomainVector::field_type relaxationFactor,
+                        const DomainVector& x,
+                        DomainVector& xNew,
+                        const RangeVector& b) const
+    {
+        sellBorder_->jacobiStep(relaxationFactor, x, xNew, b);
+        sellInterior_->jacobiStep(relaxationFactor, x, xNew, b);
+    }
+
     /*!
      * \brief Assign and syncronize the overlapping matrix from a non-overlapping one.
      */
@@ -211,77 +389,106 @@ public:
                                 "row");
     }
 
+    /*!
+     * \brief Copy the entries of a non-overlapping matrix to the overlapping one.
+     *
+     * The non-overlapping matrix must exhibit the same sparsity pattern as the one which
+     * was used to construct the overlapping matrix.
+     */
     template <class NativeBCRSMatrix>
     void assignFromNative(const NativeBCRSMatrix& nativeMatrix)
     {
         // first, set everything to 0,
         BCRSMatrix::operator=(0.0);
 
-        // then copy the domestic entries of the native matrix to the overlapping matrix
-        for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
-            Index domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
-            if (domesticRowIdx < 0) {
-                continue; // row corresponds to a black-listed entry
-            }
+        assert(nativeMatrix.N() + 1 == nativeRowOffsets_.size());
+        assert(nativeMatrix.nonzeroes() == nativeBlockDest_.size());
 
-            auto nativeColIt = nativeMatrix[nativeRowIdx].begin();
-            const auto& nativeColEndIt = nativeMatrix[nativeRowIdx].end();
-            for (; nativeColIt != nativeColEndIt; ++nativeColIt) {
-                Index domesticColIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeColIt.index()));
-
-                // make sure to include all off-diagonal entries, even those which belong
-                // to DOFs which are managed by a peer process. For this, we have to
-                // re-map the column index of the black-listed index to a native one.
-                if (domesticColIdx < 0)
-                    domesticColIdx = overlap_->blackList().nativeToDomestic(static_cast<Index>(nativeColIt.index()));
+        // then copy the domestic entries of the native matrix to the overlapping matrix
+        int numNativeRows = static_cast<int>(nativeMatrix.N());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int nativeRowIdx = 0; nativeRowIdx < numNativeRows; ++nativeRowIdx) {
+            block_type* const* dest = nativeBlockDest_.data() + nativeRowOffsets_[static_cast<unsigned>(nativeRowIdx)];
 
-                if (domesticColIdx < 0)
-                    // there is no domestic index which corresponds to a black-listed
-                    // one. this can happen if the grid overlap is larger than the
-                    // algebraic one...
-                    continue;
+            auto nativeColIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].begin();
+            const auto& nativeColEndIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].end();
+            for (; nativeColIt != nativeColEndIt; ++nativeColIt, ++dest) {
+                if (!(*dest))
+                    continue; // the entry is not represented by the overlapping matrix
 
                 // we need to copy the block matrices manually since it seems that (at
                 // least some versions of) Dune have an endless recursion bug when
                 // assigning dense matrices of different field type
                 const auto& src = *nativeColIt;
-                auto& dest = (*this)[static_cast<unsigned>(domesticRowIdx)][static_cast<unsigned>(domesticColIdx)];
+                block_type& destBlock = **dest;
                 for (unsigned i = 0; i < src.rows; ++i) {
                     for (unsigned j = 0; j < src.cols; ++j) {
-                        dest[i][j] = static_cast<field_type>(src[i][j]);
+                        destBlock[i][j] = static_cast<field_type>(src[i][j]);
                     }
                 }
             }
         }
     }
 
-    // communicates and adds up the contents of overlapping rows
-    void syncAdd()
+    /*!
+     * \brief Copy the entries of a non-overlapping matrix to the overlapping one and
+     *        scale each row of the blocks by a weight.
+     *
+     * \param nativeMatrix The non-overlapping matrix. It must exhibit the same sparsity
+     *                     pattern as the one which was used to construct the overlapping
+     *                     matrix.
+     * \param rowWeights The weights of the block rows, indexed by the native row index
+     *                   and the row within a block.
+     */
+    template <class NativeBCRSMatrix, class RowWeights>
+    void assignFromNative(const NativeBCRSMatrix& nativeMatrix, const RowWeights& rowWeights)
     {
-        // first, send all entries to the peers
-        const PeerSet& peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
+        // first, set everything to 0,
+        BCRSMatrix::operator=(0.0);
 
-            sendEntries_(peerRank);
-        }
+        assert(nativeMatrix.N() + 1 == nativeRowOffsets_.size());
+        assert(nativeMatrix.nonzeroes() == nativeBlockDest_.size());
+        assert(rowWeights.size() == nativeMatrix.N());
 
-        // then, receive entries from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
+        // then copy and scale the domestic entries of the native matrix
+        int numNativeRows = static_cast<int>(nativeMatrix.N());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int nativeRowIdx = 0; nativeRowIdx < numNativeRows; ++nativeRowIdx) {
+            block_type* const* dest = nativeBlockDest_.data() + nativeRowOffsets_[static_cast<unsigned>(nativeRowIdx)];
+            const auto& weights = rowWeights[static_cast<unsigned>(nativeRowIdx)];
+
+            auto nativeColIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].begin();
+            const auto& nativeColEndIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].end();
+            for (; nativeColIt != nativeColEndIt; ++nativeColIt, ++dest) {
+                if (!(*dest))
+                    continue; // the entry is not represented by the overlapping matrix
 
-            receiveAddEntries_(peerRank);
+                const auto& src = *nativeColIt;
+                block_type& destBlock = **dest;
+                for (unsigned i = 0; i < src.rows; ++i) {
+                    field_type w = static_cast<field_type>(weights[i]);
+                    for (unsigned j = 0; j < src.cols; ++j) {
+                        destBlock[i][j] = static_cast<field_type>(src[i][j])*w;
+                    }
+                }
+            }
         }
+    }
 
-        // finally, make sure that everything which we send was
-        // received by the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            entryValuesSendBuff_[peerRank]->wait();
+    // communicates and adds up the contents of overlapping rows
+    void syncAdd()
+    {
+        exchangeEntries_();
+
+        // add the received entries to the matrix
+        const auto& recvValues = commPlan_.recvValues();
+        for (unsigned bufferIdx = 0; bufferIdx < recvBlocks_.size(); ++bufferIdx) {
+            if (recvBlocks_[bufferIdx])
+                *recvBlocks_[bufferIdx] += recvValues[bufferIdx];
         }
     }
 
@@ -289,30 +496,13 @@ public:
     // the master
     void syncCopy()
     {
-        // first, send all entries to the peers
-        const PeerSet& peerSet = overlap_->peerSet();
-        typename PeerSet::const_iterator peerIt = peerSet.begin();
-        typename PeerSet::const_iterator peerEndIt = peerSet.end();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-
-            sendEntries_(peerRank);
-        }
-
-        // then, receive entries from the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
+        exchangeEntries_();
 
-            receiveCopyEntries_(peerRank);
-        }
-
-        // finally, make sure that everything which we send was
-        // received by the peers
-        peerIt = peerSet.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            entryValuesSendBuff_[peerRank]->wait();
+        // copy the received entries into the matrix
+        const auto& recvValues = commPlan_.recvValues();
+        for (unsigned bufferIdx = 0; bufferIdx < recvBlocks_.size(); ++bufferIdx) {
+            if (recvBlocks_[bufferIdx])
+                *recvBlocks_[bufferIdx] = recvValues[bufferIdx];
         }
     }
 
@@ -328,6 +518,83 @@ private:
 
         // communicate the entries
         buildIndices_(nativeMatrix);
+
+        // set up the plan for communicating the values of the matrix entries and get
+        // rid of the buffers which were only required to build the matrix structure
+        setupCommPlan_();
+        freeSetupBuffers_();
+
+        // split the rows into the ones which need to be communicated and the remaining
+        // ones
+        classifyRows_();
+    }
+
+    void classifyRows_()
+    {
+        size_t numDomestic = overlap_->numDomestic();
+        std::vector<bool> isBorderRow(numDomestic, false);
+
+        const PeerSet& peerSet = overlap_->peerSet();
+        typename PeerSet::const_iterator peerIt = peerSet.begin();
+        typename PeerSet::const_iterator peerEndIt = peerSet.end();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            ProcessRank peerRank = *peerIt;
+
+            size_t numOverlapRows = overlap_->foreignOverlapSize(peerRank);
+            for (unsigned overlapOffset = 0; overlapOffset < numOverlapRows; ++overlapOffset) {
+                Index domesticRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, overlapOffset);
+                isBorderRow[static_cast<unsigned>(domesticRowIdx)] = true;
+            }
+        }
+
+        borderRows_.clear();
+        interiorRows_.clear();
+        for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
+            if (isBorderRow[rowIdx])
+                borderRows_.push_back(rowIdx);
+            else
+                interiorRows_.push_back(rowIdx);
+        }
+    }
+
+    template <class DomainVector, class RangeVector>
+    void mvRows_(const std::vector<unsigned>& rowIndices,
+                 const DomainVector& x,
+                 RangeVector& y) const
+    {
+        auto rowIdxIt = rowIndices.begin();
+        const auto& rowIdxEndIt = rowIndices.end();
+        for (; rowIdxIt != rowIdxEndIt; ++rowIdxIt) {
+            unsigned rowIdx = *rowIdxIt;
+            auto& yRow = y[rowIdx];
+            yRow = 0.0;
+
+            const auto& row = (*this)[rowIdx];
+            auto colIt = row.begin();
+            const auto& colEndIt = row.end();
+            for (; colIt != colEndIt; ++colIt)
+                colIt->umv(x[colIt.index()], yRow);
+        }
+    }
+
+    template <class DomainVector, class RangeVector>
+    void usmvRows_(const std::vector<unsigned>& rowIndices,
+                   field_type alpha,
+                   const DomainVector& x,
+                   RangeVector& y) const
+    {
+        auto rowIdxIt = rowIndices.begin();
+        const auto& rowIdxEndIt = rowIndices.end();
+        for (; rowIdxIt != rowIdxEndIt; ++rowIdxIt) {
+            unsigned rowIdx = *rowIdxIt;
+            auto& yRow = y[rowIdx];
+
+            const auto& row = (*this)[rowIdx];
+            auto colIt = row.begin();
+            const auto& colEndIt = row.end();
+            for (; colIt != colEndIt; ++colIt)
+                colIt->usmv(alpha, x[colIt.index()], yRow);
+        }
     }
 
     template <class NativeBCRSMatrix>
@@ -438,6 +705,55 @@ private:
 
         // free the memory occupied by the array of the matrix entries
         entries_.clear();
+
+        // remember where the entries of the native matrix end up in the overlapping one
+        setupNativeMapping_(nativeMatrix);
+    }
+
+    // compute the addresses of the overlapping matrix' blocks which correspond to the
+    // non-zero blocks of the native matrix. this only works because the BCRS matrix does
+    // not reallocate its entries after its structure has been built.
+    template <class NativeBCRSMatrix>
+    void setupNativeMapping_(const NativeBCRSMatrix& nativeMatrix)
+    {
+        nativeRowOffsets_.resize(nativeMatrix.N() + 1);
+        nativeBlockDest_.clear();
+        nativeBlockDest_.reserve(nativeMatrix.nonzeroes());
+
+        nativeRowOffsets_[0] = 0;
+        for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
+            Index domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
+
+            auto nativeColIt = nativeMatrix[nativeRowIdx].begin();
+            const auto& nativeColEndIt = nativeMatrix[nativeRowIdx].end();
+            for (; nativeColIt != nativeColEndIt; ++nativeColIt) {
+                if (domesticRowIdx < 0) {
+                    // row corresponds to a black-listed entry
+                    nativeBlockDest_.push_back(nullptr);
+                    continue;
+                }
+
+                Index domesticColIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeColIt.index()));
+
+                // make sure to include all off-diagonal entries, even those which belong
+                // to DOFs which are managed by a peer process. For this, we have to
+                // re-map the column index of the black-listed index to a native one.
+                if (domesticColIdx < 0)
+                    domesticColIdx = overlap_->blackList().nativeToDomestic(static_cast<Index>(nativeColIt.index()));
+
+                if (domesticColIdx < 0) {
+                    // there is no domestic index which corresponds to a black-listed
+                    // one. this can happen if the grid overlap is larger than the
+                    // algebraic one...
+                    nativeBlockDest_.push_back(nullptr);
+                    continue;
+                }
+
+                nativeBlockDest_.push_back(&(*this)[static_cast<unsigned>(domesticRowIdx)][static_cast<unsigned>(domesticColIdx)]);
+            }
+
+            nativeRowOffsets_[nativeRowIdx + 1] = nativeBlockDest_.size();
+        }
     }
 
     // send the overlap indices to a peer
@@ -449,7 +765,7 @@ private:
         size_t numOverlapRows = overlap_->foreignOverlapSize(peerRank);
         numRowsSendBuff_[peerRank] = new MpiBuffer<unsigned>(1);
         (*numRowsSendBuff_[peerRank])[0] = static_cast<unsigned>(numOverlapRows);
-        numRowsSendBuff_[peerRank]->send(peerRank);
+        numRowsSendBuff_[peerRank]->send(peerRank, overlap_->communicator());
 
         // allocate the buffers which hold the global indices of each row and the number
         // of entries which need to be communicated by the respective row
@@ -513,13 +829,9 @@ private:
         }
 
         // actually communicate with the peer
-        rowSizesSendBuff_[peerRank]->send(peerRank);
-        rowIndicesSendBuff_[peerRank]->send(peerRank);
-        entryColIndicesSendBuff_[peerRank]->send(peerRank);
-
-        // create the send buffers for the values of the matrix
-        // entries
-        entryValuesSendBuff_[peerRank] = new MpiBuffer<block_type>(numEntries);
+        rowSizesSendBuff_[peerRank]->send(peerRank, overlap_->communicator());
+        rowIndicesSendBuff_[peerRank]->send(peerRank, overlap_->communicator());
+        entryColIndicesSendBuff_[peerRank]->send(peerRank, overlap_->communicator());
 #endif // HAVE_MPI
     }
 
@@ -531,15 +843,15 @@ private:
         unsigned numOverlapRows;
         auto& numRowsRecvBuff = numRowsRecvBuff_[peerRank];
         numRowsRecvBuff.resize(1);
-        numRowsRecvBuff.receive(peerRank);
+        numRowsRecvBuff.receive(peerRank, overlap_->communicator());
         numOverlapRows = numRowsRecvBuff[0];
 
         // create receive buffer for the row sizes and receive them
         // from the peer
         rowSizesRecvBuff_[peerRank] = new MpiBuffer<unsigned>(numOverlapRows);
         rowIndicesRecvBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
-        rowSizesRecvBuff_[peerRank]->receive(peerRank);
-        rowIndicesRecvBuff_[peerRank]->receive(peerRank);
+        rowSizesRecvBuff_[peerRank]->receive(peerRank, overlap_->communicator());
+        rowIndicesRecvBuff_[peerRank]->receive(peerRank, overlap_->communicator());
 
         // calculate the total number of indices which are send by the
         // peer
@@ -549,10 +861,9 @@ private:
 
         // create the buffer to store the column indices of the matrix entries
         entryColIndicesRecvBuff_[peerRank] = new MpiBuffer<Index>(totalIndices);
-        entryValuesRecvBuff_[peerRank] = new MpiBuffer<block_type>(totalIndices);
 
         // communicate with the peer
-        entryColIndicesRecvBuff_[peerRank]->receive(peerRank);
+        entryColIndicesRecvBuff_[peerRank]->receive(peerRank, overlap_->communicator());
 
         // convert the global indices in the receive buffers to
         // domestic ones
@@ -572,89 +883,93 @@ private:
 #endif // HAVE_MPI
     }
 
-    void sendEntries_(ProcessRank peerRank)
+    void setupCommPlan_()
     {
-#if HAVE_MPI
-        auto &mpiSendBuff = *entryValuesSendBuff_[peerRank];
-
-        auto &mpiRowIndicesSendBuff = *rowIndicesSendBuff_[peerRank];
-        auto &mpiRowSizesSendBuff = *rowSizesSendBuff_[peerRank];
-        auto &mpiColIndicesSendBuff = *entryColIndicesSendBuff_[peerRank];
+        const PeerSet& peerSet = overlap_->peerSet();
+        typename PeerSet::const_iterator peerIt = peerSet.begin();
+        typename PeerSet::const_iterator peerEndIt = peerSet.end();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            ProcessRank peerRank = *peerIt;
 
-        // fill the send buffer
-        unsigned k = 0;
-        for (unsigned i = 0; i < mpiRowIndicesSendBuff.size(); ++i) {
-            Index domRowIdx = mpiRowIndicesSendBuff[i];
+            const auto& sendRowIndices = *rowIndicesSendBuff_[peerRank];
+            const auto& sendRowSizes = *rowSizesSendBuff_[peerRank];
+            const auto& sendColIndices = *entryColIndicesSendBuff_[peerRank];
+
+            const auto& recvRowIndices = *rowIndicesRecvBuff_[peerRank];
+            const auto& recvRowSizes = *rowSizesRecvBuff_[peerRank];
+            const auto& recvColIndices = *entryColIndicesRecvBuff_[peerRank];
+
+            commPlan_.addPeer(peerRank, sendColIndices.size(), recvColIndices.size());
+
+            // the BCRS matrix does not reallocate its entries after it has been built,
+            // so we can remember the addresses of the blocks which need to be
+            // communicated
+            unsigned k = 0;
+            for (unsigned i = 0; i < sendRowIndices.size(); ++i) {
+                unsigned domRowIdx = static_cast<unsigned>(sendRowIndices[i]);
+                for (unsigned j = 0; j < sendRowSizes[i]; ++j, ++k) {
+                    unsigned domColIdx = static_cast<unsigned>(sendColIndices[k]);
+                    sendBlocks_.push_back(&(*this)[domRowIdx][domColIdx]);
+                }
+            }
 
-            for (Index j = 0; j < static_cast<Index>(mpiRowSizesSendBuff[i]); ++j)
-            {
-                // move to the next column which is in the overlap
-                Index domColIdx = mpiColIndicesSendBuff[k];
+            k = 0;
+            for (unsigned i = 0; i < recvRowIndices.size(); ++i) {
+                unsigned domRowIdx = static_cast<unsigned>(recvRowIndices[i]);
+                for (unsigned j = 0; j < recvRowSizes[i]; ++j, ++k) {
+                    Index domColIdx = recvColIndices[k];
 
-                // add the values of this column to the send buffer
-                mpiSendBuff[k] = (*this)[static_cast<unsigned>(domRowIdx)][static_cast<unsigned>(domColIdx)];
-                ++k;
+                    if (domColIdx < 0)
+                        // the matrix for the current process does not know about this
+                        // DOF
+                        recvBlocks_.push_back(nullptr);
+                    else
+                        recvBlocks_.push_back(&(*this)[domRowIdx][static_cast<unsigned>(domColIdx)]);
+                }
             }
         }
 
-        mpiSendBuff.send(peerRank);
-#endif // HAVE_MPI
+        commPlan_.finalize(overlap_->communicator());
     }
 
-    void receiveAddEntries_(ProcessRank peerRank)
+    void freeSetupBuffers_()
     {
-#if HAVE_MPI
-        auto &mpiRecvBuff = *entryValuesRecvBuff_[peerRank];
-
-        auto &mpiRowIndicesRecvBuff = *rowIndicesRecvBuff_[peerRank];
-        auto &mpiRowSizesRecvBuff = *rowSizesRecvBuff_[peerRank];
-        auto &mpiColIndicesRecvBuff = *entryColIndicesRecvBuff_[peerRank];
+        const PeerSet& peerSet = overlap_->peerSet();
+        typename PeerSet::const_iterator peerIt = peerSet.begin();
+        typename PeerSet::const_iterator peerEndIt = peerSet.end();
+        for (; peerIt != peerEndIt; ++peerIt) {
+            ProcessRank peerRank = *peerIt;
 
-        mpiRecvBuff.receive(peerRank);
+            delete rowSizesRecvBuff_[peerRank];
+            delete rowIndicesRecvBuff_[peerRank];
+            delete entryColIndicesRecvBuff_[peerRank];
 
-        // retrieve the values from the receive buffer
-        unsigned k = 0;
-        for (unsigned i = 0; i < mpiRowIndicesRecvBuff.size(); ++i) {
-            Index domRowIdx = mpiRowIndicesRecvBuff[i];
-            for (unsigned j = 0; j < mpiRowSizesRecvBuff[i]; ++j, ++k) {
-                Index domColIdx = mpiColIndicesRecvBuff[k];
+            delete numRowsSendBuff_[peerRank];
+            delete rowSizesSendBuff_[peerRank];
+            delete rowIndicesSendBuff_[peerRank];
+            delete entryColIndicesSendBuff_[peerRank];
+        }
 
-                if (domColIdx < 0)
-                    // the matrix for the current process does not know about this DOF
-                    continue;
+        numRowsSendBuff_.clear();
+        rowSizesSendBuff_.clear();
+        rowIndicesSendBuff_.clear();
+        entryColIndicesSendBuff_.clear();
 
-                (*this)[static_cast<unsigned>(domRowIdx)][static_cast<unsigned>(domColIdx)] += mpiRecvBuff[k];
-            }
-        }
-#endif // HAVE_MPI
+        numRowsRecvBuff_.clear();
+        rowSizesRecvBuff_.clear();
+        rowIndicesRecvBuff_.clear();
+        entryColIndicesRecvBuff_.clear();
     }
 
-    void receiveCopyEntries_(int peerRank)
+    // copy the entries required by the peers into the send buffer and exchange them
+    void exchangeEntries_()
     {
-#if HAVE_MPI
-        MpiBuffer<block_type> &mpiRecvBuff = *entryValuesRecvBuff_[peerRank];
-
-        MpiBuffer<Index> &mpiRowIndicesRecvBuff = *rowIndicesRecvBuff_[peerRank];
-        MpiBuffer<unsigned> &mpiRowSizesRecvBuff = *rowSizesRecvBuff_[peerRank];
-        MpiBuffer<Index> &mpiColIndicesRecvBuff = *entryColIndicesRecvBuff_[peerRank];
+        auto& sendValues = commPlan_.sendValues();
+        for (unsigned bufferIdx = 0; bufferIdx < sendBlocks_.size(); ++bufferIdx)
+            sendValues[bufferIdx] = *sendBlocks_[bufferIdx];
 
-        mpiRecvBuff.receive(peerRank);
-
-        // retrieve the values from the receive buffer
-        unsigned k = 0;
-        for (unsigned i = 0; i < mpiRowIndicesRecvBuff.size(); ++i) {
-            Index domRowIdx = mpiRowIndicesRecvBuff[i];
-            for (unsigned j = 0; j < mpiRowSizesRecvBuff[i]; ++j, ++k) {
-                Index domColIdx = mpiColIndicesRecvBuff[k];
-
-                if (domColIdx < 0)
-                    // the matrix for the current process does not know about this DOF
-                    continue;
-
-                (*this)[static_cast<unsigned>(domRowIdx)][static_cast<unsigned>(domColIdx)] = mpiRecvBuff[k];
-            }
-        }
-#endif // HAVE_MPI
+        commPlan_.start();
+        commPlan_.wait();
     }
 
     void globalToDomesticBuff_(MpiBuffer<Index>& idxBuff)
@@ -667,17 +982,34 @@ private:
     Entries entries_;
     std::shared_ptr<Overlap> overlap_;
 
+    std::vector<unsigned> borderRows_;
+    std::vector<unsigned> interiorRows_;
+
+    // the optional copies of the border and interior rows in the SELL-C-sigma format
+    std::unique_ptr<SellMatrix> sellBorder_;
+    std::unique_ptr<SellMatrix> sellInterior_;
+
+    // the destination blocks of the non-zero blocks of the native matrix and the offset
+    // of the first block of each native row within this array
+    std::vector<size_t> nativeRowOffsets_;
+    std::vector<block_type*> nativeBlockDest_;
+
+    // the plan used to communicate the values of the matrix entries and the blocks
+    // which correspond to the entries of its send and receive buffers
+    OverlapCommunicationPlan<block_type> commPlan_;
+    std::vector<const block_type*> sendBlocks_;
+    std::vector<block_type*> recvBlocks_;
+
+    // these buffers are only used while the structure of the matrix is built
     std::map<ProcessRank, MpiBuffer<unsigned> *> numRowsSendBuff_;
     std::map<ProcessRank, MpiBuffer<unsigned> *> rowSizesSendBuff_;
     std::map<ProcessRank, MpiBuffer<Index> *> rowIndicesSendBuff_;
     std::map<ProcessRank, MpiBuffer<Index> *> entryColIndicesSendBuff_;
-    std::map<ProcessRank, MpiBuffer<block_type> *> entryValuesSendBuff_;
 
     std::map<ProcessRank, MpiBuffer<unsigned> > numRowsRecvBuff_;
     std::map<ProcessRank, MpiBuffer<unsigned> *> rowSizesRecvBuff_;
     std::map<ProcessRank, MpiBuffer<Index> *> rowIndicesRecvBuff_;
     std::map<ProcessRank, MpiBuffer<Index> *> entryColIndicesRecvBuff_;
-    std::map<ProcessRank, MpiBuffer<block_type> *> entryValuesRecvBuff_;
 };
 
 } // namespace Linear
@@ -28,6 +28,7 @@
 #define EWOMS_OVERLAPPING_BLOCK_VECTOR_HH
 
 #include "overlaptypes.hh"
+#include "overlapcommunicationplan.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
 #include <opm/common/Valgrind.hpp>
@@ -37,6 +38,7 @@
 
 #include <memory>
 #include <map>
+#include <vector>
 #include <iostream>
 
 namespace Ewoms {
@@ -58,18 +60,17 @@ public:
      */
     OverlappingBlockVector(const Overlap& overlap)
         : ParentType(overlap.numDomestic()), overlap_(&overlap)
-    { createBuffers_(); }
+    { createCommIndices_(); }
 
     /*!
      * \brief Copy constructor.
+     *
+     * The copy shares the indices of the values which are exchanged with the peer
+     * processes, but it uses its own buffers and MPI requests.
      */
     OverlappingBlockVector(const OverlappingBlockVector& obv)
         : ParentType(obv)
-        , numIndicesSendBuff_(obv.numIndicesSendBuff_)
-        , indicesSendBuff_(obv.indicesSendBuff_)
-        , indicesRecvBuff_(obv.indicesRecvBuff_)
-        , valuesSendBuff_(obv.valuesSendBuff_)
-        , valuesRecvBuff_(obv.valuesRecvBuff_)
+        , commIndices_(obv.commIndices_)
         , overlap_(obv.overlap_)
     {}
 
@@ -92,11 +93,10 @@ public:
     OverlappingBlockVector& operator=(const OverlappingBlockVector& obv)
     {
         ParentType::operator=(obv);
-        numIndicesSendBuff_ = obv.numIndicesSendBuff_;
-        indicesSendBuff_ = obv.indicesSendBuff_;
-        indicesRecvBuff_ = obv.indicesRecvBuff_;
-        valuesSendBuff_ = obv.valuesSendBuff_;
-        valuesRecvBuff_ = obv.valuesRecvBuff_;
+        if (commIndices_ != obv.commIndices_) {
+            commIndices_ = obv.commIndices_;
+            commPlan_.reset();
+        }
         overlap_ = obv.overlap_;
         return *this;
     }
@@ -173,52 +173,59 @@ public:
      */
     void sync()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
+        startSync();
+        finishSync();
+    }
 
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            sendEntries_(peerRank);
-        }
+    /*!
+     * \brief Start to syncronize the values of the block vector from their master
+     *        process without waiting for the communication to complete.
+     *
+     * Only the entries which are sent to peer processes (i.e., the ones in the foreign
+     * overlap) must be up to date when calling this method. All other entries may be
+     * modified until finishSync() is called. Between startSync() and finishSync(), no
+     * other communication operation may be executed on the vector.
+     */
+    void startSync()
+    { startExchange_(); }
 
-        // recieve all entries to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            receiveFromMaster_(peerRank);
+    /*!
+     * \brief Complete a syncronization which was initiated using startSync().
+     */
+    void finishSync()
+    {
+        commPlan_->wait();
+
+        // copy the values for which the sending peer is the master into the vector
+        const auto& recvValues = commPlan_->recvValues();
+        const auto& recvIndices = commIndices_->recvIndices;
+        const auto& recvFromMaster = commIndices_->recvFromMaster;
+        for (unsigned i = 0; i < recvFromMaster.size(); ++i) {
+            unsigned bufferIdx = recvFromMaster[i];
+            (*this)[recvIndices[bufferIdx]] = recvValues[bufferIdx];
         }
-
-        // wait until we have send everything
-        waitSendFinished_();
     }
 
+    /*!
+     * \brief Returns the overlap object used by the vector.
+     */
+    const Overlap& overlap() const
+    { return *overlap_; }
+
     /*!
      * \brief Syncronize all values of the block vector by adding up
      *        the values of all peer ranks.
      */
     void syncAdd()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
+        startExchange_();
+        commPlan_->wait();
 
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            sendEntries_(peerRank);
-        }
-
-        // recieve all entries to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            receiveAdd_(peerRank);
-        }
-
-        // wait until we have send everything
-        waitSendFinished_();
+        // add up the values of rows on the shared boundary
+        const auto& recvValues = commPlan_->recvValues();
+        const auto& recvIndices = commIndices_->recvIndices;
+        for (unsigned bufferIdx = 0; bufferIdx < recvIndices.size(); ++bufferIdx)
+            (*this)[recvIndices[bufferIdx]] += recvValues[bufferIdx];
     }
 
     /*!
@@ -227,26 +234,19 @@ public:
      */
     void syncAddBorder()
     {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            sendEntries_(peerRank);
-        }
-
-        // recieve all entries to the peers
-        peerIt = overlap_->peerSet().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            ProcessRank peerRank = *peerIt;
-            receiveAddBorder_(peerRank);
+        startExchange_();
+        commPlan_->wait();
+
+        // add up the values of rows on the shared boundary, and copy all other ones
+        const auto& recvValues = commPlan_->recvValues();
+        const auto& recvIndices = commIndices_->recvIndices;
+        const auto& recvIsBorder = commIndices_->recvIsBorder;
+        for (unsigned bufferIdx = 0; bufferIdx < recvIndices.size(); ++bufferIdx) {
+            if (recvIsBorder[bufferIdx])
+                (*this)[recvIndices[bufferIdx]] += recvValues[bufferIdx];
+            else
+                (*this)[recvIndices[bufferIdx]] = recvValues[bufferIdx];
         }
-
-        // wait until we have send everything
-        waitSendFinished_();
-
     }
 
     void print() const
@@ -258,10 +258,41 @@ public:
     }
 
 private:
-    void createBuffers_()
+    typedef OverlapCommunicationPlan<FieldVector> CommPlan;
+
+    // the peers of the vector and the domestic indices of the values in its send and
+    // receive buffers. these are immutable and shared by all copies of a vector.
+    struct CommIndices
+    {
+        // the rank of each peer and the number of values exchanged with it
+        std::vector<ProcessRank> peerRanks;
+        std::vector<size_t> numSend;
+        std::vector<size_t> numRecv;
+
+        // domestic index of each entry of the send buffer
+        std::vector<unsigned> sendIndices;
+
+        // domestic index of each entry of the receive buffer
+        std::vector<unsigned> recvIndices;
+
+        // specifies whether an entry of the receive buffer is on the border with the
+        // sending peer
+        std::vector<unsigned char> recvIsBorder;
+
+        // the offsets of the entries of the receive buffer which were sent by their
+        // master process
+        std::vector<unsigned> recvFromMaster;
+    };
+
+    void createCommIndices_()
     {
+        auto commIndices = std::make_shared<CommIndices>();
+
 #if HAVE_MPI
-        // create array for the front indices
+        std::map<ProcessRank, std::shared_ptr<MpiBuffer<unsigned> > > numIndicesSendBuff;
+        std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff;
+        std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesRecvBuff;
+
         typename PeerSet::const_iterator peerIt;
         typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
 
@@ -271,23 +302,22 @@ private:
             ProcessRank peerRank = *peerIt;
 
             size_t numEntries = overlap_->foreignOverlapSize(peerRank);
-            numIndicesSendBuff_[peerRank] = std::make_shared<MpiBuffer<unsigned> >(1);
-            indicesSendBuff_[peerRank] = std::make_shared<MpiBuffer<Index> >(numEntries);
-            valuesSendBuff_[peerRank] = std::make_shared<MpiBuffer<FieldVector> >(numEntries);
+            numIndicesSendBuff[peerRank] = std::make_shared<MpiBuffer<unsigned> >(1);
+            indicesSendBuff[peerRank] = std::make_shared<MpiBuffer<Index> >(numEntries);
 
             // fill the indices buffer with global indices
-            MpiBuffer<Index>& indicesSendBuff = *indicesSendBuff_[peerRank];
+            MpiBuffer<Index>& peerIndicesSendBuff = *indicesSendBuff[peerRank];
             for (unsigned i = 0; i < numEntries; ++i) {
                 Index domRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, i);
-                indicesSendBuff[i] = overlap_->domesticToGlobal(domRowIdx);
+                peerIndicesSendBuff[i] = overlap_->domesticToGlobal(domRowIdx);
             }
 
             // first, send the number of indices
-            (*numIndicesSendBuff_[peerRank])[0] = static_cast<unsigned>(numEntries);
-            numIndicesSendBuff_[peerRank]->send(peerRank);
+            (*numIndicesSendBuff[peerRank])[0] = static_cast<unsigned>(numEntries);
+            numIndicesSendBuff[peerRank]->send(peerRank, overlap_->communicator());
 
             // then, send the indices themselfs
-            indicesSendBuff.send(peerRank);
+            peerIndicesSendBuff.send(peerRank, overlap_->communicator());
         }
 
         // receive the indices from the peers
@@ -297,124 +327,87 @@ private:
 
             // receive size of overlap to peer
             MpiBuffer<unsigned> numRowsRecvBuff(1);
-            numRowsRecvBuff.receive(peerRank);
+            numRowsRecvBuff.receive(peerRank, overlap_->communicator());
             unsigned numRows = numRowsRecvBuff[0];
 
-            // then, create the MPI buffers
-            indicesRecvBuff_[peerRank] = std::shared_ptr<MpiBuffer<Index> >(
-                new MpiBuffer<Index>(numRows));
-            valuesRecvBuff_[peerRank] = std::shared_ptr<MpiBuffer<FieldVector> >(
-                new MpiBuffer<FieldVector>(numRows));
-            MpiBuffer<Index>& indicesRecvBuff = *indicesRecvBuff_[peerRank];
-
             // next, receive the actual indices
-            indicesRecvBuff.receive(peerRank);
-
-            // finally, translate the global indices to domestic ones
-            for (unsigned i = 0; i != numRows; ++i) {
-                Index globalRowIdx = indicesRecvBuff[i];
-                Index domRowIdx = overlap_->globalToDomestic(globalRowIdx);
-
-                indicesRecvBuff[i] = domRowIdx;
-            }
+            indicesRecvBuff[peerRank] = std::make_shared<MpiBuffer<Index> >(numRows);
+            indicesRecvBuff[peerRank]->receive(peerRank, overlap_->communicator());
         }
 
         // wait for all send operations to complete
         peerIt = overlap_->peerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank peerRank = *peerIt;
-            numIndicesSendBuff_[peerRank]->wait();
-            indicesSendBuff_[peerRank]->wait();
-
-            // convert the global indices of the send buffer to
-            // domestic ones
-            MpiBuffer<Index>& indicesSendBuff = *indicesSendBuff_[peerRank];
-            for (unsigned i = 0; i < indicesSendBuff.size(); ++i) {
-                indicesSendBuff[i] = overlap_->globalToDomestic(indicesSendBuff[i]);
-            }
+            numIndicesSendBuff[peerRank]->wait();
+            indicesSendBuff[peerRank]->wait();
         }
-#endif // HAVE_MPI
-    }
-
-    void sendEntries_(ProcessRank peerRank)
-    {
-        // copy the values into the send buffer
-        const MpiBuffer<Index>& indices = *indicesSendBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesSendBuff_[peerRank];
-        for (unsigned i = 0; i < indices.size(); ++i)
-            values[i] = (*this)[static_cast<unsigned>(indices[i])];
-
-        values.send(peerRank);
-    }
 
-    void waitSendFinished_()
-    {
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
-
-        // send all entries to all peers
+        // set up the communication plan and convert the global indices of the send and
+        // receive buffers to domestic ones
         peerIt = overlap_->peerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
             ProcessRank peerRank = *peerIt;
-            valuesSendBuff_[peerRank]->wait();
-        }
-    }
+            const MpiBuffer<Index>& peerIndicesSendBuff = *indicesSendBuff[peerRank];
+            const MpiBuffer<Index>& peerIndicesRecvBuff = *indicesRecvBuff[peerRank];
 
-    void receiveFromMaster_(ProcessRank peerRank)
-    {
-        const MpiBuffer<Index>& indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesRecvBuff_[peerRank];
+            commIndices->peerRanks.push_back(peerRank);
+            commIndices->numSend.push_back(peerIndicesSendBuff.size());
+            commIndices->numRecv.push_back(peerIndicesRecvBuff.size());
 
-        // receive the values from the peer
-        values.receive(peerRank);
+            for (unsigned i = 0; i < peerIndicesSendBuff.size(); ++i) {
+                Index domRowIdx = overlap_->globalToDomestic(peerIndicesSendBuff[i]);
+                commIndices->sendIndices.push_back(static_cast<unsigned>(domRowIdx));
+            }
 
-        // copy them into the block vector
-        for (unsigned j = 0; j < indices.size(); ++j) {
-            Index domRowIdx = indices[j];
-            if (overlap_->masterRank(domRowIdx) == peerRank) {
-                (*this)[static_cast<unsigned>(domRowIdx)] = values[j];
+            for (unsigned i = 0; i < peerIndicesRecvBuff.size(); ++i) {
+                Index domRowIdx = overlap_->globalToDomestic(peerIndicesRecvBuff[i]);
+                unsigned bufferIdx = static_cast<unsigned>(commIndices->recvIndices.size());
+
+                commIndices->recvIndices.push_back(static_cast<unsigned>(domRowIdx));
+                commIndices->recvIsBorder.push_back(overlap_->isBorderWith(domRowIdx, peerRank));
+                if (overlap_->masterRank(domRowIdx) == peerRank)
+                    commIndices->recvFromMaster.push_back(bufferIdx);
             }
         }
+#endif // HAVE_MPI
+
+        commIndices_ = commIndices;
     }
 
-    void receiveAddBorder_(ProcessRank peerRank)
+    // create the buffers and the MPI requests of the vector. this is done when the
+    // vector is synchronized for the first time, so that the temporary copies which
+    // are never synchronized do not need them. since all exchanges are collective,
+    // the plans of the peers get the same tag.
+    void createCommPlan_()
     {
-        const MpiBuffer<Index>& indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesRecvBuff_[peerRank];
-
-        // receive the values from the peer
-        values.receive(peerRank);
-
-        // add up the values of rows on the shared boundary
-        for (unsigned j = 0; j < indices.size(); ++j) {
-            Index domRowIdx = indices[j];
-            if (overlap_->isBorderWith(domRowIdx, peerRank))
-                (*this)[static_cast<unsigned>(domRowIdx)] += values[j];
-            else
-                (*this)[static_cast<unsigned>(domRowIdx)] = values[j];
-        }
+        const CommIndices& commIndices = *commIndices_;
+
+        commPlan_.reset(new CommPlan);
+        for (unsigned peerIdx = 0; peerIdx < commIndices.peerRanks.size(); ++peerIdx)
+            commPlan_->addPeer(commIndices.peerRanks[peerIdx],
+                               commIndices.numSend[peerIdx],
+                               commIndices.numRecv[peerIdx]);
+        commPlan_->finalize(overlap_->communicator(), newOverlapCommunicationTag());
     }
 
-    void receiveAdd_(ProcessRank peerRank)
+    // copy the values which are required by the peers into the send buffer and start
+    // the communication
+    void startExchange_()
     {
-        const MpiBuffer<Index>& indices = *indicesRecvBuff_[peerRank];
-        MpiBuffer<FieldVector>& values = *valuesRecvBuff_[peerRank];
+        if (!commPlan_)
+            createCommPlan_();
 
-        // receive the values from the peer
-        values.receive(peerRank);
+        auto& sendValues = commPlan_->sendValues();
+        const auto& sendIndices = commIndices_->sendIndices;
+        for (unsigned bufferIdx = 0; bufferIdx < sendIndices.size(); ++bufferIdx)
+            sendValues[bufferIdx] = (*this)[sendIndices[bufferIdx]];
 
-        // add up the values of rows on the shared boundary
-        for (unsigned j = 0; j < indices.size(); ++j) {
-            Index domRowIdx = indices[j];
-            (*this)[static_cast<unsigned>(domRowIdx)] += values[j];
-        }
+        commPlan_->start();
     }
 
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<unsigned> > > numIndicesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<Index> > > indicesRecvBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<FieldVector> > > valuesSendBuff_;
-    std::map<ProcessRank, std::shared_ptr<MpiBuffer<FieldVector> > > valuesRecvBuff_;
+    std::shared_ptr<const CommIndices> commIndices_;
+    std::unique_ptr<CommPlan> commPlan_;
 
     const Overlap *overlap_;
 };
@@ -35,6 +35,10 @@ namespace Linear {
 
 /*!
  * \brief An overlap aware linear operator usable by ISTL.
+ *
+ * To hide the latency of the communication, the rows of the matrix which are required
+ * by peer processes are computed first. Then, the communication of the result is
+ * initiated and the remaining rows are computed while the messages are in flight.
  */
 template <class OverlappingMatrix, class DomainVector, class RangeVector>
 class OverlappingOperator
@@ -62,16 +66,20 @@ public:
     //! apply operator to x:  \f$ y = A(x) \f$
     virtual void apply(const DomainVector& x, RangeVector& y) const override
     {
-        A_.mv(x, y);
-        y.sync();
+        A_.mvBorder(x, y);
+        y.startSync();
+        A_.mvInterior(x, y);
+        y.finishSync();
     }
 
     //! apply operator to x, scale and add:  \f$ y = y + \alpha A(x) \f$
     virtual void applyscaleadd(field_type alpha, const DomainVector& x,
                                RangeVector& y) const override
     {
-        A_.usmv(alpha, x, y);
-        y.sync();
+        A_.usmvBorder(alpha, x, y);
+        y.startSync();
+        A_.usmvInterior(alpha, x, y);
+        y.finishSync();
     }
 
     //! returns the matrix
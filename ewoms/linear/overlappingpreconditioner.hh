@@ -77,7 +77,7 @@ public:
                           1,               // number of objects in buffers
                           MPI_SHORT,       // data type
                           MPI_MIN,         // operation
-                          MPI_COMM_WORLD); // communicator
+                          overlap_->communicator()); // communicator
         }
         catch (...)
         {
@@ -87,7 +87,7 @@ public:
                           1,               // number of objects in buffers
                           MPI_SHORT,       // data type
                           MPI_MIN,         // operation
-                          MPI_COMM_WORLD); // communicator
+                          overlap_->communicator()); // communicator
         }
 
         if (success) {
@@ -112,34 +112,45 @@ public:
             // make sure that all processes react the same if the
             // sequential preconditioner on one process throws an
             // exception
+            short localSuccess = 1;
             short success;
             try
             {
                 // execute the sequential preconditioner
                 seqPreCond_.apply(x, d);
-                short localSuccess = 1;
-                MPI_Allreduce(&localSuccess,   // source buffer
-                              &success,        // destination buffer
-                              1,               // number of objects in buffers
-                              MPI_SHORT,       // data type
-                              MPI_MIN,         // operation
-                              MPI_COMM_WORLD); // communicator
             }
             catch (...)
             {
-                short localSuccess = 0;
-                MPI_Allreduce(&localSuccess,   // source buffer
-                              &success,        // destination buffer
-                              1,               // number of objects in buffers
-                              MPI_SHORT,       // data type
-                              MPI_MIN,         // operation
-                              MPI_COMM_WORLD); // communicator
+                localSuccess = 0;
             }
 
-            if (success) {
+#if MPI_VERSION >= 3
+            // find out whether the preconditioner succeeded on all processes while
+            // the results on the overlap are communicated. if it did not, the
+            // communicated values are garbage, but they will be thrown away anyway.
+            MPI_Request successRequest;
+            MPI_Iallreduce(&localSuccess,   // source buffer
+                           &success,        // destination buffer
+                           1,               // number of objects in buffers
+                           MPI_SHORT,       // data type
+                           MPI_MIN,         // operation
+                           overlap_->communicator(), // communicator
+                           &successRequest);
+            x.sync();
+            MPI_Wait(&successRequest, MPI_STATUS_IGNORE);
+#else
+            MPI_Allreduce(&localSuccess,   // source buffer
+                          &success,        // destination buffer
+                          1,               // number of objects in buffers
+                          MPI_SHORT,       // data type
+                          MPI_MIN,         // operation
+                          overlap_->communicator()); // communicator
+
+            if (success)
                 x.sync();
-            }
-            else
+#endif // MPI_VERSION >= 3
+
+            if (!success)
                 OPM_THROW(Opm::NumericalProblem,
                           "Preconditioner threw an exception on some process.");
         }
@@ -161,7 +172,7 @@ public:
                           1,               // number of objects in buffers
                           MPI_SHORT,       // data type
                           MPI_MIN,         // operation
-                          MPI_COMM_WORLD); // communicator
+                          overlap_->communicator()); // communicator
         }
         catch (...)
         {
@@ -171,7 +182,7 @@ public:
                           1,               // number of objects in buffers
                           MPI_SHORT,       // data type
                           MPI_MIN,         // operation
-                          MPI_COMM_WORLD); // communicator
+                          overlap_->communicator()); // communicator
         }
 
         if (success) {
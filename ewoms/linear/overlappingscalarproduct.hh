@@ -60,8 +60,10 @@ public:
     enum { category = Dune::SolverCategory::overlapping };
 #endif
 
+    // the global sums are computed using the same communicator as the overlap, i.e.,
+    // not necessarily MPI_COMM_WORLD
     OverlappingScalarProduct(const Overlap& overlap)
-        : overlap_(overlap), comm_( Dune::MPIHelper::getCollectiveCommunication() )
+        : overlap_(overlap), comm_(overlap.communicator())
     {}
 
     field_type dot(const OverlappingBlockVector& x,
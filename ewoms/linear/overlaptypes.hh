@@ -29,6 +29,8 @@
 #ifndef EWOMS_OVERLAP_TYPES_HH
 #define EWOMS_OVERLAP_TYPES_HH
 
+#include <dune/common/parallel/mpihelper.hh>
+
 #include <set>
 #include <list>
 #include <vector>
@@ -53,6 +55,13 @@ typedef unsigned ProcessRank;
  */
 typedef unsigned BorderDistance;
 
+/*!
+ * \brief The type of the MPI communicator used by the parallel linear algebra.
+ *
+ * If MPI is available, this is MPI_Comm, else it is a dummy type.
+ */
+typedef Dune::MPIHelper::MPICommunicator Communicator;
+
 /*!
  * \brief This structure stores an index and a process rank
  */
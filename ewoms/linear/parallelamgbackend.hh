@@ -30,11 +30,15 @@
 #include "parallelbasebackend.hh"
 #include "bicgstabsolver.hh"
 #include "combinedcriterion.hh"
+#include "mixedprecisionpreconditioner.hh"
+#include "levelscheduledilu0.hh"
 
 #include <dune/istl/paamg/amg.hh>
 #include <dune/istl/paamg/pinfo.hh>
 #include <dune/istl/owneroverlapcopy.hh>
 
+#include <type_traits>
+#include <memory>
 #include <iostream>
 
 namespace Ewoms {
@@ -49,12 +53,21 @@ NEW_TYPE_TAG(ParallelAmgLinearSolver, INHERITS_FROM(ParallelBaseLinearSolver));
 NEW_PROP_TAG(AmgCoarsenTarget);
 NEW_PROP_TAG(LinearSolverMaxError);
 
+/*!
+ * \brief Use the thread-parallel ILU(0) preconditioner instead of SOR as the smoother of
+ *        the AMG.
+ */
+NEW_PROP_TAG(AmgUseThreadedIlu0Smoother);
+
 //! The target number of DOFs per processor for the parallel algebraic
 //! multi-grid solver
 SET_INT_PROP(ParallelAmgLinearSolver, AmgCoarsenTarget, 5000);
 
 SET_SCALAR_PROP(ParallelAmgLinearSolver, LinearSolverMaxError, 1e7);
 
+//! use the SOR smoother by default
+SET_BOOL_PROP(ParallelAmgLinearSolver, AmgUseThreadedIlu0Smoother, false);
+
 SET_TYPE_PROP(ParallelAmgLinearSolver, LinearSolverBackend,
               Ewoms::Linear::ParallelAmgBackend<TypeTag>);
 } // namespace Properties
@@ -72,7 +85,7 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
     typedef ParallelBaseBackend<TypeTag> ParentType;
 
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
-    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverScalar) LinearSolverScalar;
+    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverMatrixScalar) LinearSolverMatrixScalar;
     typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
     typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
     typedef typename GET_PROP_TYPE(TypeTag, Overlap) Overlap;
@@ -83,15 +96,17 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
     typedef typename ParentType::ParallelScalarProduct ParallelScalarProduct;
 
     static constexpr int numEq = GET_PROP_VALUE(TypeTag, NumEq);
-    typedef Dune::FieldVector<LinearSolverScalar, numEq> VectorBlock;
-    typedef Dune::FieldMatrix<LinearSolverScalar, numEq, numEq> MatrixBlock;
+    typedef Dune::FieldVector<LinearSolverMatrixScalar, numEq> VectorBlock;
+    typedef Dune::FieldMatrix<LinearSolverMatrixScalar, numEq, numEq> MatrixBlock;
 
     typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
     typedef Dune::BlockVector<VectorBlock> Vector;
 
     // define the smoother used for the AMG and specify its
     // arguments
-    typedef Dune::SeqSOR<Matrix, Vector, Vector> SequentialSmoother;
+    typedef typename std::conditional<GET_PROP_VALUE(TypeTag, AmgUseThreadedIlu0Smoother),
+                                      LevelScheduledIlu0<Matrix, Vector, Vector>,
+                                      Dune::SeqSOR<Matrix, Vector, Vector> >::type SequentialSmoother;
 // typedef Dune::SeqSSOR<Matrix,Vector,Vector> SequentialSmoother;
 // typedef Dune::SeqJac<Matrix,Vector,Vector> SequentialSmoother;
 // typedef Dune::SeqILU0<Matrix,Vector,Vector> SequentialSmoother;
@@ -121,9 +136,13 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
     typedef Dune::Amg::AMG<FineOperator, Vector, ParallelSmoother> AMG;
 #endif
 
+    // the AMG hierarchy uses the floating point type of the matrix whereas the Krylov
+    // solver uses the one of the overlapping vectors
+    typedef MixedPrecisionPreconditioner<AMG, OverlappingVector> AmgPreconditioner;
+
     typedef BiCGStabSolver<ParallelOperator,
                            OverlappingVector,
-                           AMG> RawLinearSolver;
+                           AmgPreconditioner> RawLinearSolver;
 
 public:
     ParallelAmgBackend(const Simulator& simulator)
@@ -145,26 +164,36 @@ public:
 protected:
     friend ParentType;
 
-    std::shared_ptr<AMG> preparePreconditioner_()
+    std::shared_ptr<AmgPreconditioner> preparePreconditioner_()
     {
 #if HAVE_MPI
         // create and initialize DUNE's OwnerOverlapCopyCommunication
         // using the domestic overlap
-        istlComm_ = std::make_shared<OwnerOverlapCopyCommunication>(MPI_COMM_WORLD);
-        setupAmgIndexSet_(this->overlappingMatrix_->overlap(), istlComm_->indexSet());
+        const auto& overlap = this->overlappingMatrix_->overlap();
+        istlComm_ = std::make_shared<OwnerOverlapCopyCommunication>(overlap.communicator());
+        setupAmgIndexSet_(overlap, istlComm_->indexSet());
         istlComm_->remoteIndices().template rebuild<false>();
 #endif
 
-        // create the parallel scalar product and the parallel operator
+        // create the parallel scalar product and the parallel operator. the AMG
+        // hierarchy is built from the matrix which uses the floating point type of the
+        // preconditioner.
 #if HAVE_MPI
-        fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_, *istlComm_);
+        fineOperator_ = std::make_shared<FineOperator>(this->preconditionerMatrix_(), *istlComm_);
 #else
-        fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_);
+        fineOperator_ = std::make_shared<FineOperator>(this->preconditionerMatrix_());
 #endif
 
         setupAmg_();
 
-        return amg_;
+        // in mixed precision mode, the AMG needs its own vectors. they are copied by
+        // the constructor of the mixed precision preconditioner.
+        std::unique_ptr<Vector> amgVectorPrototype;
+        if (!std::is_same<LinearSolverMatrixScalar,
+                          typename OverlappingVector::field_type>::value)
+            amgVectorPrototype.reset(new Vector(this->overlappingMatrix_->overlap().numDomestic()));
+
+        return std::make_shared<AmgPreconditioner>(amg_, amgVectorPrototype.get());
     }
 
     void cleanupPreconditioner_()
@@ -172,7 +201,7 @@ protected:
 
     std::shared_ptr<RawLinearSolver> prepareSolver_(ParallelOperator& parOperator,
                                                     ParallelScalarProduct& parScalarProduct,
-                                                    AMG& parPreCond)
+                                                    AmgPreconditioner& parPreCond)
     {
         const auto& gridView = this->simulator_.gridView();
         typedef CombinedCriterion<OverlappingVector, decltype(gridView.comm())> CCC;
@@ -200,7 +229,11 @@ protected:
     }
 
     bool runSolver_(std::shared_ptr<RawLinearSolver> solver)
-    { return solver->apply(*this->overlappingx_); }
+    {
+        bool converged = solver->apply(*this->overlappingx_);
+        this->numIterations_ = solver->report().iterations();
+        return converged;
+    }
 
     void cleanupSolver_()
     { /* nothing to do */ }
@@ -30,8 +30,10 @@
 #include <ewoms/linear/overlappingbcrsmatrix.hh>
 #include <ewoms/linear/overlappingblockvector.hh>
 #include <ewoms/linear/overlappingpreconditioner.hh>
+#include <ewoms/linear/mixedprecisionpreconditioner.hh>
 #include <ewoms/linear/overlappingscalarproduct.hh>
 #include <ewoms/linear/overlappingoperator.hh>
+#include <ewoms/linear/linearsystemio.hh>
 #include <ewoms/linear/parallelbasebackend.hh>
 #include <ewoms/linear/istlpreconditionerwrappers.hh>
 
@@ -39,12 +41,19 @@
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
 #include <dune/grid/io/file/vtk/vtkwriter.hh>
 
 #include <dune/common/fvector.hh>
 
 #include <sstream>
+#include <string>
 #include <memory>
+#include <vector>
+#include <type_traits>
+#include <stdexcept>
 #include <iostream>
 
 namespace Ewoms {
@@ -64,8 +73,11 @@ NEW_PROP_TAG(BorderListCreator);
 NEW_PROP_TAG(Overlap);
 NEW_PROP_TAG(OverlappingVector);
 NEW_PROP_TAG(OverlappingMatrix);
+NEW_PROP_TAG(OverlappingPreconditionerMatrix);
+NEW_PROP_TAG(OverlappingPreconditionerVector);
 NEW_PROP_TAG(OverlappingScalarProduct);
 NEW_PROP_TAG(OverlappingLinearOperator);
+NEW_PROP_TAG(EnableMatrixFreeLinearization);
 
 //! The type of the linear solver to be used
 NEW_PROP_TAG(LinearSolverBackend);
@@ -77,6 +89,17 @@ NEW_PROP_TAG(PreconditionerWrapper);
 //! The floating point type used internally by the linear solver
 NEW_PROP_TAG(LinearSolverScalar);
 
+/*!
+ * \brief The floating point type used by the preconditioner.
+ *
+ * By default, this is the same as the LinearSolverScalar. Setting it to a less precise
+ * type (e.g., float) makes the preconditioner use a copy of the matrix which is stored
+ * in this type. This halves the memory bandwidth required by the preconditioner while
+ * the matrix-vector products of the Krylov iteration and its convergence checks still
+ * use the LinearSolverScalar.
+ */
+NEW_PROP_TAG(LinearSolverMatrixScalar);
+
 /*!
  * \brief The size of the algebraic overlap of the linear solver.
  *
@@ -103,6 +126,36 @@ NEW_PROP_TAG(LinearSolverVerbosity);
 //! Maximum number of iterations eyecuted by the linear solver
 NEW_PROP_TAG(LinearSolverMaxIterations);
 
+/*!
+ * \brief The factor by which the solution of the previous linear solve is multiplied to
+ *        get the initial solution of the next one.
+ *
+ * If this is 0, the linear solver always starts with the zero vector.
+ */
+NEW_PROP_TAG(LinearSolverWarmStartFactor);
+
+/*!
+ * \brief Specify whether the matrix-vector products of the linear solver should use a
+ *        copy of the matrix in the SIMD friendly SELL-C-sigma format.
+ */
+NEW_PROP_TAG(LinearSolverUseSellStorage);
+
+//! The number of consecutive rows which are sorted by length for the SELL-C-sigma format
+NEW_PROP_TAG(LinearSolverSellSortingWindow);
+
+/*!
+ * \brief The directory to which the linear systems of equations are written.
+ *
+ * If this is empty, the linear systems are not captured.
+ */
+NEW_PROP_TAG(LinearSystemCaptureDirectory);
+
+//! Comma separated list of the time step indices for which linear systems are captured
+NEW_PROP_TAG(LinearSystemCaptureTimeSteps);
+
+//! Comma separated list of the Newton iterations for which linear systems are captured
+NEW_PROP_TAG(LinearSystemCaptureNewtonIterations);
+
 //! The order of the sequential preconditioner
 NEW_PROP_TAG(PreconditionerOrder);
 
@@ -154,24 +207,33 @@ protected:
     typedef typename GET_PROP_TYPE(TypeTag, Overlap) Overlap;
     typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
     typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerMatrix) PreconditionerMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingPreconditionerVector) PreconditionerVector;
 
     typedef typename GET_PROP_TYPE(TypeTag, PreconditionerWrapper) PreconditionerWrapper;
     typedef typename PreconditionerWrapper::SequentialPreconditioner SequentialPreconditioner;
 
     typedef Ewoms::Linear::OverlappingPreconditioner<SequentialPreconditioner,
-                                                     Overlap> ParallelPreconditioner;
+                                                     Overlap> InnerParallelPreconditioner;
+    typedef Ewoms::Linear::MixedPrecisionPreconditioner<InnerParallelPreconditioner,
+                                                        OverlappingVector> ParallelPreconditioner;
     typedef Ewoms::Linear::OverlappingScalarProduct<OverlappingVector,
                                                     Overlap> ParallelScalarProduct;
-    typedef Ewoms::Linear::OverlappingOperator<OverlappingMatrix,
-                                               OverlappingVector,
-                                               OverlappingVector> ParallelOperator;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingLinearOperator) ParallelOperator;
 
     enum { dimWorld = GridView::dimensionworld };
 
+    // true if the preconditioner uses a different floating point type than the Krylov
+    // solver
+    static constexpr bool isMixedPrecision_ =
+        !std::is_same<PreconditionerVector, OverlappingVector>::value;
+
 public:
     ParallelBaseBackend(const Simulator& simulator)
         : simulator_(simulator)
         , gridSequenceNumber_( -1 )
+        , hasPreviousSolution_(false)
+        , numIterations_(0)
     {
         overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
@@ -194,6 +256,28 @@ public:
                              "The maximum number of iterations of the linear solver");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverVerbosity,
                              "The verbosity level of the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, LinearSolverWarmStartFactor,
+                             "The factor by which the solution of the previous linear solve "
+                             "is multiplied to get the initial solution of the next one. "
+                             "0 means to always start with the zero vector");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, LinearSolverUseSellStorage,
+                             "Use the SELL-C-sigma format for the matrix-vector products "
+                             "of the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, LinearSolverSellSortingWindow,
+                             "The number of consecutive rows which are sorted by their "
+                             "length for the SELL-C-sigma format");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, LinearSystemCaptureDirectory,
+                             "The directory to which the linear systems of equations are "
+                             "written for replaying them later. If empty, the linear systems "
+                             "are not written");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, LinearSystemCaptureTimeSteps,
+                             "Comma separated list of the indices of the time steps for "
+                             "which the linear systems are written. If empty, all time steps "
+                             "are considered");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, LinearSystemCaptureNewtonIterations,
+                             "Comma separated list of the Newton iterations for which the "
+                             "linear systems are written. If empty, all iterations are "
+                             "considered");
 
         PreconditionerWrapper::registerParameters();
     }
@@ -203,7 +287,7 @@ public:
      *        equations the next time it is called.
      */
     void eraseMatrix()
-    { cleanup_(); }
+    { asImp_().cleanup_(); }
 
     void prepareMatrix(const Matrix& M)
     {
@@ -212,15 +296,29 @@ public:
         prepare_(M);
 
         // copy the interior values of the non-overlapping linear system of
-        // equations to the overlapping one. On ther border, we add up
-        // the values of all processes (using the assignAdd() methods)
-        overlappingMatrix_->assignFromNative(M);
+        // equations to the overlapping one and scale each equation by its weight. On
+        // ther border, we add up the values of all processes (using the syncAdd()
+        // method)
+        //
+        // note that the rows are scaled before they are summed up, i.e., the weights of
+        // a border row need to be the same on all processes which share it. this was
+        // already the case before the scaling was merged into assignFromNative(),
+        // because rescale_() has always been called before syncAdd(). (the weights
+        // returned by the eqWeight() method of the models only depend on the equation,
+        // not on the degree of freedom or the process.)
+        asImp_().updateEqWeights_();
+        overlappingMatrix_->assignFromNative(M, eqWeights_);
+
+        // write the linear system to disk if requested. this uses the right hand side
+        // which was passed to prepareRhs(), i.e., before its border entries were added up.
+        captureLinearSystem_(M);
 
         asImp_().rescale_();
 
         // synchronize all entries from their master processes and add entries on the
         // process border
         overlappingMatrix_->syncAdd();
+        overlappingMatrix_->updateSellStorage();
         // the entries on the border have already been added in prepareRhs()
         overlappingb_->sync();
     }
@@ -231,6 +329,11 @@ public:
         // have been created
         prepare_(M);
 
+        // the captured linear systems are replayed using the same backend, so their
+        // right hand side must be saved before the border entries are added up
+        if (captureRequested_())
+            capturedRhs_ = b;
+
         overlappingb_->assignAddBorder(b);
 
         // copy the result back to the non-overlapping vector. This is
@@ -240,6 +343,13 @@ public:
         overlappingb_->assignTo(b);
     }
 
+    /*!
+     * \brief Returns the number of iterations which were required by the last call
+     *        to solve().
+     */
+    unsigned numIterations() const
+    { return numIterations_; }
+
     /*!
      * \brief Actually solve the linear system of equations.
      *
@@ -247,7 +357,15 @@ public:
      */
     bool solve(Vector& x)
     {
-        (*overlappingx_) = 0.0;
+        // the linear systems of subsequent Newton iterations are closely related, so
+        // their solutions usually are, too. the solvers fall back to the zero vector if
+        // this initial solution turns out to be worse than it.
+        Scalar warmStartFactor = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverWarmStartFactor);
+        if (hasPreviousSolution_ && warmStartFactor != 0.0)
+            (*overlappingx_) *= warmStartFactor;
+        else
+            (*overlappingx_) = 0.0;
+        hasPreviousSolution_ = false;
 
         auto parPreCond = asImp_().preparePreconditioner_();
 
@@ -259,10 +377,10 @@ public:
 
         // create the parallel scalar product and the parallel operator
         ParallelScalarProduct parScalarProduct(overlappingMatrix_->overlap());
-        ParallelOperator parOperator(*overlappingMatrix_);
+        auto parOperator = asImp_().prepareOperator_();
 
         // retrieve the linear solver
-        auto solver = asImp_().prepareSolver_(parOperator,
+        auto solver = asImp_().prepareSolver_(*parOperator,
                                               parScalarProduct,
                                               *parPreCond);
 
@@ -273,6 +391,19 @@ public:
 
         // run the linear solver and have some fun
         bool result = asImp_().runSolver_(solver);
+        hasPreviousSolution_ = result;
+
+        // report the number of iterations. this allows to judge whether reducing the
+        // precision of the preconditioner pays off for a given case.
+        totalIterations_ += numIterations_;
+        if (EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity) > 0
+            && simulator_.gridView().comm().rank() == 0)
+        {
+            std::cout << "Linear solver took " << numIterations_ << " iterations ("
+                      << totalIterations_ << " in total"
+                      << (isMixedPrecision_?", mixed precision preconditioner":"")
+                      << ")\n" << std::flush;
+        }
 
         // copy the result back to the non-overlapping vector
         overlappingx_->assignTo(x);
@@ -303,39 +434,134 @@ protected:
         BorderListCreator borderListCreator(simulator_.gridView(),
                                             simulator_.model().dofMapper());
 
+        // the linear solver uses the same MPI communicator as the grid
+#if HAVE_MPI
+        Linear::Communicator comm = simulator_.gridView().comm();
+#else
+        Linear::Communicator comm = Dune::MPIHelper::getCommunicator();
+#endif
+
         // create the overlapping Jacobian matrix
         unsigned overlapSize = EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverOverlapSize);
-        overlappingMatrix_ = new OverlappingMatrix(M,
-                                                   borderListCreator.borderList(),
-                                                   borderListCreator.blackList(),
-                                                   overlapSize);
+        overlappingMatrix_ = asImp_().createOverlappingMatrix_(M, borderListCreator, overlapSize, comm);
+        if (EWOMS_GET_PARAM(TypeTag, bool, LinearSolverUseSellStorage))
+            overlappingMatrix_->enableSellStorage(EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverSellSortingWindow));
 
         // create the overlapping vectors for the residual and the
         // solution
         overlappingb_ = new OverlappingVector(overlappingMatrix_->overlap());
         overlappingx_ = new OverlappingVector(*overlappingb_);
 
+        // if the preconditioner uses a different precision, it needs its own vectors
+        if (isMixedPrecision_)
+            precondVectorPrototype_.reset(new PreconditionerVector(overlappingMatrix_->overlap()));
+
         // writeOverlapToVTK_();
     }
 
+    // create the overlapping matrix. by default, its overlap is determined by the
+    // sparsity pattern of the non-overlapping matrix.
+    OverlappingMatrix* createOverlappingMatrix_(const Matrix& M,
+                                                const BorderListCreator& borderListCreator,
+                                                unsigned overlapSize,
+                                                Linear::Communicator comm)
+    {
+        return new OverlappingMatrix(M,
+                                     borderListCreator.borderList(),
+                                     borderListCreator.blackList(),
+                                     overlapSize,
+                                     comm);
+    }
+
+    // returns true if the current linear system is to be written to disk
+    bool captureRequested_() const
+    {
+        std::string captureDir = EWOMS_GET_PARAM(TypeTag, std::string, LinearSystemCaptureDirectory);
+        if (captureDir.empty())
+            return false;
+
+        int timeStepIdx = simulator_.timeStepIndex();
+        int newtonIterIdx = simulator_.model().newtonMethod().numIterations();
+        return
+            isSelected_(EWOMS_GET_PARAM(TypeTag, std::string, LinearSystemCaptureTimeSteps), timeStepIdx)
+            && isSelected_(EWOMS_GET_PARAM(TypeTag, std::string, LinearSystemCaptureNewtonIterations), newtonIterIdx);
+    }
+
+    void captureLinearSystem_(const Matrix& M)
+    {
+        if (!captureRequested_())
+            return;
+
+        if (capturedRhs_.size() != M.N())
+            OPM_THROW(std::logic_error,
+                      "The right hand side of a captured linear system must be passed to "
+                      "prepareRhs() before prepareMatrix() is called");
+
+        std::string captureDir = EWOMS_GET_PARAM(TypeTag, std::string, LinearSystemCaptureDirectory);
+        int timeStepIdx = simulator_.timeStepIndex();
+        int newtonIterIdx = simulator_.model().newtonMethod().numIterations();
+
+        BorderListCreator borderListCreator(simulator_.gridView(),
+                                            simulator_.model().dofMapper());
+
+        const auto& comm = simulator_.gridView().comm();
+        std::ostringstream oss;
+        oss << captureDir << "/linsys_t" << timeStepIdx << "_i" << newtonIterIdx;
+        LinearSystemIO::write(LinearSystemIO::systemFileName(oss.str(), comm.rank()),
+                              M,
+                              capturedRhs_,
+                              eqWeights_,
+                              borderListCreator.borderList(),
+                              borderListCreator.blackList(),
+                              comm.rank(),
+                              comm.size());
+    }
+
+    // returns true if an index is contained in a comma separated list of indices or if
+    // the list is empty
+    static bool isSelected_(const std::string& indexList, int idx)
+    {
+        if (indexList.empty())
+            return true;
+
+        std::istringstream iss(indexList);
+        std::string token;
+        while (std::getline(iss, token, ',')) {
+            if (!token.empty() && std::stoi(token) == idx)
+                return true;
+        }
+        return false;
+    }
+
+    // retrieve the weights of all equations of all native rows from the model
+    void updateEqWeights_()
+    {
+        const auto& model = simulator_.model();
+        int numNative = static_cast<int>(overlappingMatrix_->overlap().numNative());
+        eqWeights_.resize(static_cast<size_t>(numNative));
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int nativeRowIdx = 0; nativeRowIdx < numNative; ++nativeRowIdx) {
+            auto& weights = eqWeights_[static_cast<unsigned>(nativeRowIdx)];
+            for (unsigned eqIdx = 0; eqIdx < weights.size(); ++eqIdx)
+                weights[eqIdx] = model.eqWeight(static_cast<unsigned>(nativeRowIdx), eqIdx);
+        }
+    }
+
+    // scale the right hand side by the equation weights. the matrix has already been
+    // scaled by assignFromNative().
     void rescale_()
     {
         const auto& overlap = overlappingMatrix_->overlap();
         for (unsigned domesticRowIdx = 0; domesticRowIdx < overlap.numLocal(); ++domesticRowIdx) {
             Index nativeRowIdx = overlap.domesticToNative(static_cast<Index>(domesticRowIdx));
-            auto& row = (*overlappingMatrix_)[domesticRowIdx];
-
-            auto colIt = row.begin();
-            const auto& colEndIt = row.end();
-            for (; colIt != colEndIt; ++ colIt) {
-                auto& entry = *colIt;
-                for (unsigned i = 0; i < entry.rows; ++i)
-                    entry[i] *= simulator_.model().eqWeight(nativeRowIdx, i);
-            }
+            const auto& weights = eqWeights_[static_cast<unsigned>(nativeRowIdx)];
 
             auto& rhsEntry = (*overlappingb_)[domesticRowIdx];
             for (unsigned i = 0; i < rhsEntry.size(); ++i)
-                rhsEntry[i] *= simulator_.model().eqWeight(nativeRowIdx, i);
+                rhsEntry[i] *= weights[i];
         }
     }
 
@@ -349,14 +575,26 @@ protected:
         overlappingMatrix_ = 0;
         overlappingb_ = 0;
         overlappingx_ = 0;
+        hasPreviousSolution_ = false;
+
+        precondVectorPrototype_.reset();
+        reducedPrecisionMatrix_.reset();
     }
 
+    std::shared_ptr<ParallelOperator> prepareOperator_()
+    { return std::make_shared<ParallelOperator>(*overlappingMatrix_); }
+
     std::shared_ptr<ParallelPreconditioner> preparePreconditioner_()
     {
         int preconditionerIsReady = 1;
         try {
             // update sequential preconditioner
-            precWrapper_.prepare(*overlappingMatrix_);
+            precWrapper_.prepare(preconditionerMatrix_());
+
+            // if the preconditioner keeps its own copy of the reduced precision
+            // matrix, there is no point in keeping it around as well.
+            if (isMixedPrecision_ && PreconditionerWrapper::copiesMatrix)
+                reducedPrecisionMatrix_.reset();
         }
         catch (const Dune::Exception& e) {
             std::cout << "Preconditioner threw exception \"" << e.what()
@@ -372,7 +610,11 @@ protected:
             OPM_THROW(Opm::NumericalProblem, "Creating the preconditioner failed");
 
         // create the parallel preconditioner
-        return std::make_shared<ParallelPreconditioner>(precWrapper_.get(), overlappingMatrix_->overlap());
+        auto innerPreCond =
+            std::make_shared<InnerParallelPreconditioner>(precWrapper_.get(),
+                                                          overlappingMatrix_->overlap());
+        return std::make_shared<ParallelPreconditioner>(innerPreCond,
+                                                        precondVectorPrototype_.get());
     }
 
     void cleanupPreconditioner_()
@@ -380,6 +622,59 @@ protected:
         precWrapper_.cleanup();
     }
 
+    // returns the matrix from which the preconditioner is constructed. if the
+    // preconditioner uses the same floating point type as the linear solver, this is
+    // the overlapping matrix itself.
+    PreconditionerMatrix& preconditionerMatrix_()
+    { return preconditionerMatrix_(std::integral_constant<bool, isMixedPrecision_>()); }
+
+    PreconditionerMatrix& preconditionerMatrix_(std::false_type)
+    { return *overlappingMatrix_; }
+
+    // convert the entries of the overlapping matrix to the floating point type of the
+    // preconditioner. the Krylov solver still uses the overlapping matrix.
+    PreconditionerMatrix& preconditionerMatrix_(std::true_type)
+    {
+        typedef typename PreconditionerMatrix::field_type PreconditionerScalar;
+
+        const OverlappingMatrix& A = *overlappingMatrix_;
+        if (!reducedPrecisionMatrix_) {
+            // copy the sparsity pattern. unless the matrix is released after the
+            // preconditioner has been set up, this only needs to be done once per grid.
+            reducedPrecisionMatrix_.reset(new PreconditionerMatrix(A.N(), A.M(), A.nonzeroes(),
+                                                                   PreconditionerMatrix::row_wise));
+            auto rowIt = reducedPrecisionMatrix_->createbegin();
+            const auto& rowEndIt = reducedPrecisionMatrix_->createend();
+            for (; rowIt != rowEndIt; ++rowIt) {
+                const auto& srcRow = A[rowIt.index()];
+                auto colIt = srcRow.begin();
+                const auto& colEndIt = srcRow.end();
+                for (; colIt != colEndIt; ++colIt)
+                    rowIt.insert(colIt.index());
+            }
+        }
+
+        int numRows = static_cast<int>(A.N());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto& srcRow = A[static_cast<unsigned>(rowIdx)];
+            auto& destRow = (*reducedPrecisionMatrix_)[static_cast<unsigned>(rowIdx)];
+
+            auto srcIt = srcRow.begin();
+            auto destIt = destRow.begin();
+            const auto& srcEndIt = srcRow.end();
+            for (; srcIt != srcEndIt; ++srcIt, ++destIt) {
+                for (unsigned i = 0; i < srcIt->N(); ++i)
+                    for (unsigned j = 0; j < srcIt->M(); ++j)
+                        (*destIt)[i][j] = static_cast<PreconditionerScalar>((*srcIt)[i][j]);
+            }
+        }
+
+        return *reducedPrecisionMatrix_;
+    }
+
     void writeOverlapToVTK_()
     {
         for (int lookedAtRank = 0;
@@ -420,10 +715,28 @@ protected:
     const Simulator& simulator_;
     int gridSequenceNumber_;
 
+    // true if overlappingx_ contains the solution of the last linear solve
+    bool hasPreviousSolution_;
+
+    // the number of iterations of the last linear solve. this is set by runSolver_()
+    unsigned numIterations_;
+
     OverlappingMatrix *overlappingMatrix_;
     OverlappingVector *overlappingb_;
     OverlappingVector *overlappingx_;
 
+    // only used if the preconditioner uses a different floating point type than the
+    // linear solver
+    std::unique_ptr<PreconditionerVector> precondVectorPrototype_;
+    std::unique_ptr<PreconditionerMatrix> reducedPrecisionMatrix_;
+
+    // the right hand side passed to prepareRhs(). only used if the linear system is
+    // captured
+    Vector capturedRhs_;
+
+    // the weights of the equations of each native row of the linear system
+    std::vector<typename OverlappingVector::block_type> eqWeights_;
+
     PreconditionerWrapper precWrapper_;
 };
 }} // namespace Linear, Ewoms
@@ -445,6 +758,12 @@ SET_TYPE_PROP(ParallelBaseLinearSolver,
               LinearSolverScalar,
               typename GET_PROP_TYPE(TypeTag, Scalar));
 
+//! by default, the preconditioner uses the same floating point type as the linear
+//! solver
+SET_TYPE_PROP(ParallelBaseLinearSolver,
+              LinearSolverMatrixScalar,
+              typename GET_PROP_TYPE(TypeTag, LinearSolverScalar));
+
 SET_PROP(ParallelBaseLinearSolver, OverlappingMatrix)
 {
     static constexpr int numEq = GET_PROP_VALUE(TypeTag, NumEq);
@@ -454,6 +773,22 @@ SET_PROP(ParallelBaseLinearSolver, OverlappingMatrix)
     typedef Ewoms::Linear::OverlappingBCRSMatrix<NonOverlappingMatrix> type;
 };
 
+//! the preconditioner uses the overlapping matrix directly if it does not use a reduced
+//! precision, else it uses a copy of the domestic part of the matrix
+SET_PROP(ParallelBaseLinearSolver, OverlappingPreconditionerMatrix)
+{
+    static constexpr int numEq = GET_PROP_VALUE(TypeTag, NumEq);
+    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverScalar) LinearSolverScalar;
+    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverMatrixScalar) LinearSolverMatrixScalar;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+    typedef Dune::FieldMatrix<LinearSolverMatrixScalar, numEq, numEq> MatrixBlock;
+
+    typedef typename std::conditional<std::is_same<LinearSolverScalar,
+                                                   LinearSolverMatrixScalar>::value,
+                                      OverlappingMatrix,
+                                      Dune::BCRSMatrix<MatrixBlock> >::type type;
+};
+
 SET_TYPE_PROP(ParallelBaseLinearSolver,
               Overlap,
               typename GET_PROP_TYPE(TypeTag, OverlappingMatrix)::Overlap);
@@ -467,6 +802,15 @@ SET_PROP(ParallelBaseLinearSolver, OverlappingVector)
     typedef Ewoms::Linear::OverlappingBlockVector<VectorBlock, Overlap> type;
 };
 
+SET_PROP(ParallelBaseLinearSolver, OverlappingPreconditionerVector)
+{
+    static constexpr int numEq = GET_PROP_VALUE(TypeTag, NumEq);
+    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverMatrixScalar) LinearSolverMatrixScalar;
+    typedef Dune::FieldVector<LinearSolverMatrixScalar, numEq> VectorBlock;
+    typedef typename GET_PROP_TYPE(TypeTag, Overlap) Overlap;
+    typedef Ewoms::Linear::OverlappingBlockVector<VectorBlock, Overlap> type;
+};
+
 SET_PROP(ParallelBaseLinearSolver, OverlappingScalarProduct)
 {
     typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
@@ -491,6 +835,20 @@ SET_INT_PROP(ParallelBaseLinearSolver, LinearSolverOverlapSize, 2);
 
 //! set the default number of maximum iterations for the linear solver
 SET_INT_PROP(ParallelBaseLinearSolver, LinearSolverMaxIterations, 1000);
+
+//! always start the linear solver with the zero vector by default
+SET_SCALAR_PROP(ParallelBaseLinearSolver, LinearSolverWarmStartFactor, 0.0);
+
+//! do not write the linear systems to disk by default
+SET_STRING_PROP(ParallelBaseLinearSolver, LinearSystemCaptureDirectory, "");
+SET_STRING_PROP(ParallelBaseLinearSolver, LinearSystemCaptureTimeSteps, "");
+SET_STRING_PROP(ParallelBaseLinearSolver, LinearSystemCaptureNewtonIterations, "");
+
+//! use the BCRS matrix for the matrix-vector products by default
+SET_BOOL_PROP(ParallelBaseLinearSolver, LinearSolverUseSellStorage, false);
+
+//! sort the rows within windows of 128 rows for the SELL-C-sigma format
+SET_INT_PROP(ParallelBaseLinearSolver, LinearSolverSellSortingWindow, 128);
 } // namespace Properties
 } // namespace Ewoms
 
@@ -144,7 +144,11 @@ protected:
     }
 
     bool runSolver_(std::shared_ptr<RawLinearSolver> solver)
-    { return solver->apply(*this->overlappingx_); }
+    {
+        bool converged = solver->apply(*this->overlappingx_);
+        this->numIterations_ = solver->report().iterations();
+        return converged;
+    }
 
     void cleanupSolver_()
     { /* nothing to do */ }
@@ -0,0 +1,169 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::ParallelGcroDrSolverBackend
+ */
+#ifndef EWOMS_PARALLEL_GCRO_DR_BACKEND_HH
+#define EWOMS_PARALLEL_GCRO_DR_BACKEND_HH
+
+#include "parallelbasebackend.hh"
+#include "gcrodrsolver.hh"
+#include "combinedcriterion.hh"
+
+#include <memory>
+
+namespace Ewoms {
+namespace Linear {
+template <class TypeTag>
+class ParallelGcroDrSolverBackend;
+}} // namespace Linear, Ewoms
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(ParallelGcroDrLinearSolver, INHERITS_FROM(ParallelBaseLinearSolver));
+
+NEW_PROP_TAG(LinearSolverMaxError);
+NEW_PROP_TAG(GMResRestart);
+
+//! The number of vectors which are recycled between linear solves
+NEW_PROP_TAG(LinearSolverRecycleSize);
+
+SET_TYPE_PROP(ParallelGcroDrLinearSolver,
+              LinearSolverBackend,
+              Ewoms::Linear::ParallelGcroDrSolverBackend<TypeTag>);
+
+SET_SCALAR_PROP(ParallelGcroDrLinearSolver, LinearSolverMaxError, 1e7);
+SET_INT_PROP(ParallelGcroDrLinearSolver, GMResRestart, 30);
+SET_INT_PROP(ParallelGcroDrLinearSolver, LinearSolverRecycleSize, 5);
+}} // namespace Properties, Ewoms
+
+namespace Ewoms {
+namespace Linear {
+/*!
+ * \ingroup Linear
+ *
+ * \brief Provides a linear solver backend which uses GMRES with Krylov subspace
+ *        recycling (GCRO-DR).
+ *
+ * The recycled subspace is kept between linear solves, so the linear systems of
+ * subsequent Newton iterations profit from the approximate eigenvectors which were
+ * determined by the previous ones. The preconditioner is chosen the same way as for the
+ * ParallelBiCGStabSolverBackend.
+ */
+template <class TypeTag>
+class ParallelGcroDrSolverBackend : public ParallelBaseBackend<TypeTag>
+{
+    typedef ParallelBaseBackend<TypeTag> ParentType;
+
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+    typedef typename ParentType::ParallelOperator ParallelOperator;
+    typedef typename ParentType::OverlappingVector OverlappingVector;
+    typedef typename ParentType::ParallelPreconditioner ParallelPreconditioner;
+    typedef typename ParentType::ParallelScalarProduct ParallelScalarProduct;
+
+    typedef GcroDrSolver<ParallelOperator,
+                         OverlappingVector,
+                         ParallelPreconditioner> RawLinearSolver;
+
+public:
+    ParallelGcroDrSolverBackend(const Simulator& simulator)
+        : ParentType(simulator)
+    { }
+
+    static void registerParameters()
+    {
+        ParentType::registerParameters();
+
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, LinearSolverMaxError,
+                             "The maximum residual error which the linear solver tolerates"
+                             " without giving up");
+        EWOMS_REGISTER_PARAM(TypeTag, int, GMResRestart,
+                             "Number of iterations after which the GMRES linear solver is restarted");
+        EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverRecycleSize,
+                             "The number of approximate eigenvectors which are recycled "
+                             "between the linear solves");
+    }
+
+protected:
+    friend ParentType;
+
+    void cleanup_()
+    {
+        ParentType::cleanup_();
+
+        // the layout of the vectors changes if the overlap is re-created
+        recycleSpace_.clear();
+    }
+
+    std::shared_ptr<RawLinearSolver> prepareSolver_(ParallelOperator& parOperator,
+                                                    ParallelScalarProduct& parScalarProduct,
+                                                    ParallelPreconditioner& parPreCond)
+    {
+        const auto& gridView = this->simulator_.gridView();
+        typedef CombinedCriterion<OverlappingVector, decltype(gridView.comm())> CCC;
+
+        Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+        Scalar linearSolverAbsTolerance = this->simulator_.model().newtonMethod().tolerance() / 10.0;
+
+        convCrit_.reset(new CCC(gridView.comm(),
+                                /*residualReductionTolerance=*/linearSolverTolerance,
+                                /*absoluteResidualTolerance=*/linearSolverAbsTolerance,
+                                EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverMaxError)));
+
+        recycleSpace_.setMaxSize(static_cast<unsigned>(EWOMS_GET_PARAM(TypeTag, int, LinearSolverRecycleSize)));
+
+        auto gcroDrSolver =
+            std::make_shared<RawLinearSolver>(parPreCond, *convCrit_, parScalarProduct, recycleSpace_);
+
+        int verbosity = 0;
+        if (parOperator.overlap().myRank() == 0)
+            verbosity = EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity);
+        gcroDrSolver->setVerbosity(verbosity);
+        gcroDrSolver->setMaxIterations(EWOMS_GET_PARAM(TypeTag, int, LinearSolverMaxIterations));
+        gcroDrSolver->setRestart(static_cast<unsigned>(EWOMS_GET_PARAM(TypeTag, int, GMResRestart)));
+        gcroDrSolver->setLinearOperator(&parOperator);
+        gcroDrSolver->setRhs(this->overlappingb_);
+
+        return gcroDrSolver;
+    }
+
+    bool runSolver_(std::shared_ptr<RawLinearSolver> solver)
+    {
+        bool converged = solver->apply(*this->overlappingx_);
+        this->numIterations_ = solver->report().iterations();
+        return converged;
+    }
+
+    void cleanupSolver_()
+    { /* nothing to do */ }
+
+    std::unique_ptr<ConvergenceCriterion<OverlappingVector> > convCrit_;
+    GcroDrRecycleSpace<OverlappingVector> recycleSpace_;
+};
+
+}} // namespace Linear, Ewoms
+
+#endif
@@ -0,0 +1,137 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::ParallelMatrixFreeBackend
+ */
+#ifndef EWOMS_PARALLEL_MATRIX_FREE_BACKEND_HH
+#define EWOMS_PARALLEL_MATRIX_FREE_BACKEND_HH
+
+#include "parallelbicgstabbackend.hh"
+#include "matrixfreeoverlappingoperator.hh"
+
+#include <memory>
+
+namespace Ewoms {
+namespace Linear {
+template <class TypeTag>
+class ParallelMatrixFreeBackend;
+}} // namespace Linear, Ewoms
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(ParallelMatrixFreeLinearSolver, INHERITS_FROM(ParallelBiCGStabLinearSolver));
+
+NEW_PROP_TAG(Linearizer);
+
+SET_TYPE_PROP(ParallelMatrixFreeLinearSolver,
+              LinearSolverBackend,
+              Ewoms::Linear::ParallelMatrixFreeBackend<TypeTag>);
+
+//! only store the diagonal blocks of the Jacobian matrix
+SET_BOOL_PROP(ParallelMatrixFreeLinearSolver, EnableMatrixFreeLinearization, true);
+
+SET_PROP(ParallelMatrixFreeLinearSolver, OverlappingLinearOperator)
+{
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+    typedef typename GET_PROP_TYPE(TypeTag, GlobalEqVector) GlobalEqVector;
+    typedef typename GET_PROP_TYPE(TypeTag, Linearizer) Linearizer;
+    typedef Ewoms::Linear::MatrixFreeOverlappingOperator<OverlappingMatrix,
+                                                         OverlappingVector,
+                                                         GlobalEqVector,
+                                                         Linearizer> type;
+};
+}} // namespace Properties, Ewoms
+
+namespace Ewoms {
+namespace Linear {
+/*!
+ * \ingroup Linear
+ *
+ * \brief A Jacobian-free Newton-Krylov linear solver backend.
+ *
+ * The linearizer only assembles the diagonal blocks of the Jacobian matrix and the
+ * contributions of the auxiliary equations (e.g., of wells). The BiCGStab solver applies
+ * the full Jacobian by letting the linearizer multiply the off-diagonal blocks of the
+ * local Jacobians of all elements with the vector. These blocks are kept from the last
+ * linearization, so applying the operator does not require to relinearize the
+ * elements, but the global matrix, and thus the overlapping matrix of the linear
+ * solver, only contains the diagonal blocks.
+ *
+ * The preconditioner is constructed from the stored part of the Jacobian and is thus
+ * usually a bit less effective than for the assembled matrix.
+ */
+template <class TypeTag>
+class ParallelMatrixFreeBackend : public ParallelBiCGStabSolverBackend<TypeTag>
+{
+    typedef ParallelBiCGStabSolverBackend<TypeTag> ParentType;
+
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) Matrix;
+    typedef typename GET_PROP_TYPE(TypeTag, BorderListCreator) BorderListCreator;
+
+    typedef typename ParentType::OverlappingMatrix OverlappingMatrix;
+    typedef typename ParentType::ParallelOperator ParallelOperator;
+
+public:
+    // applying the Jacobian synchronizes the ghost entries of the vector and uses
+    // scratch vectors of the linearizer, so this backend requires a non-constant
+    // simulator object
+    ParallelMatrixFreeBackend(Simulator& simulator)
+        : ParentType(simulator)
+        , mutableSimulator_(simulator)
+    { }
+
+protected:
+    friend ParallelBaseBackend<TypeTag>;
+
+    // the matrix only contains the diagonal blocks of the Jacobian, so the overlap is
+    // determined by the sparsity pattern of the full Jacobian
+    OverlappingMatrix* createOverlappingMatrix_(const Matrix& M,
+                                                const BorderListCreator& borderListCreator,
+                                                unsigned overlapSize,
+                                                Linear::Communicator comm)
+    {
+        const auto& linearizer = mutableSimulator_.model().linearizer();
+        return new OverlappingMatrix(M,
+                                     linearizer.stencilPattern(),
+                                     borderListCreator.borderList(),
+                                     borderListCreator.blackList(),
+                                     overlapSize,
+                                     comm);
+    }
+
+    std::shared_ptr<ParallelOperator> prepareOperator_()
+    {
+        return std::make_shared<ParallelOperator>(*this->overlappingMatrix_,
+                                                  mutableSimulator_.model().linearizer(),
+                                                  this->eqWeights_);
+    }
+
+    Simulator& mutableSimulator_;
+};
+
+}} // namespace Linear, Ewoms
+
+#endif
@@ -0,0 +1,417 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::SellCSigmaMatrix
+ */
+#ifndef EWOMS_SELL_C_SIGMA_MATRIX_HH
+#define EWOMS_SELL_C_SIGMA_MATRIX_HH
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/common/fmatrix.hh>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <cstddef>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief A copy of a subset of the rows of a block-compressed row storage (BCRS) matrix
+ *        in the sliced ELLPACK format with sorting (SELL-C-sigma).
+ *
+ * The rows are grouped into chunks of C rows each. Within each chunk, all rows are
+ * padded to the length of its longest row and the entries are stored "column major",
+ * i.e., the scalar value (i, j) of the k-th block of all C rows of a chunk is stored
+ * contiguously. This allows the matrix-vector product to process the C rows of a chunk
+ * using SIMD instructions instead of traversing the blocks of each row separately. To
+ * keep the amount of padding small, the rows are sorted by their length within windows
+ * of sigma rows before they are assigned to chunks.
+ *
+ * The structure of the matrix is copied from the BCRS matrix by the build() method,
+ * updateValues() copies the values of the entries. Since the BCRS matrix must not be
+ * re-allocated in between, it is sufficient to call build() once for each sparsity
+ * pattern.
+ *
+ * Besides the matrix-vector products, damped Jacobi steps can be performed on this
+ * format. For this, the inverted diagonal blocks are stored in the same "lane-major"
+ * layout by updateInverseDiagonal(). Preconditioners which need the matrix in
+ * triangular form, like ILU(0), are not provided and still use the BCRS matrix.
+ */
+template <class Block, unsigned chunkSize = 8>
+class SellCSigmaMatrix
+{
+    typedef typename Block::field_type Scalar;
+
+    static const int numRowsPerBlock = Block::rows;
+    static const int numColsPerBlock = Block::cols;
+    static const unsigned blockSize = numRowsPerBlock*numColsPerBlock;
+
+    static const unsigned invalidRow = std::numeric_limits<unsigned>::max();
+
+public:
+    SellCSigmaMatrix()
+    {}
+
+    /*!
+     * \brief Set up the structure of the matrix.
+     *
+     * \param A The BCRS matrix of which the rows should be copied
+     * \param rowIndices The indices of the rows of A which should be considered
+     * \param sortingWindow The number of consecutive rows which are sorted by length
+     */
+    template <class BCRSMatrix>
+    void build(const BCRSMatrix& A,
+               const std::vector<unsigned>& rowIndices,
+               unsigned sortingWindow)
+    {
+        sortingWindow = std::max(sortingWindow, 1u);
+        size_t numSelectedRows = rowIndices.size();
+        numRows_ = numSelectedRows;
+        size_t numChunks = (numSelectedRows + chunkSize - 1)/chunkSize;
+
+        // sort the rows by decreasing length within each sorting window
+        std::vector<unsigned> sortedRows(rowIndices);
+        for (size_t windowBegin = 0; windowBegin < numSelectedRows; windowBegin += sortingWindow) {
+            size_t windowEnd = std::min<size_t>(windowBegin + sortingWindow, numSelectedRows);
+            std::stable_sort(sortedRows.begin() + static_cast<std::ptrdiff_t>(windowBegin),
+                             sortedRows.begin() + static_cast<std::ptrdiff_t>(windowEnd),
+                             [&A](unsigned rowIdx1, unsigned rowIdx2)
+                             { return A[rowIdx1].getsize() > A[rowIdx2].getsize(); });
+        }
+
+        // determine the width of each chunk
+        chunkOffsets_.resize(numChunks + 1);
+        chunkOffsets_[0] = 0;
+        for (size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+            size_t width = 0;
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                size_t sortedIdx = chunkIdx*chunkSize + laneIdx;
+                if (sortedIdx < numSelectedRows)
+                    width = std::max<size_t>(width, A[sortedRows[sortedIdx]].getsize());
+            }
+            chunkOffsets_[chunkIdx + 1] = chunkOffsets_[chunkIdx] + width;
+        }
+
+        size_t numSlots = chunkOffsets_[numChunks];
+        rowIndices_.assign(numChunks*chunkSize, invalidRow);
+        colIndices_.assign(numSlots*chunkSize, 0);
+        srcBlocks_.assign(numSlots*chunkSize, nullptr);
+        values_.assign(numSlots*chunkSize*blockSize, 0.0);
+
+        numStoredBlocks_ = 0;
+        for (size_t chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                size_t sortedIdx = chunkIdx*chunkSize + laneIdx;
+                if (sortedIdx >= numSelectedRows)
+                    continue;
+
+                unsigned rowIdx = sortedRows[sortedIdx];
+                rowIndices_[chunkIdx*chunkSize + laneIdx] = rowIdx;
+
+                // the padding entries of a row reference the column of its first
+                // entry. since their value is zero, this does not change the result
+                // but avoids accessing some unrelated memory
+                const auto& row = A[rowIdx];
+                unsigned paddingColIdx = row.begin() != row.end() ? static_cast<unsigned>(row.begin().index()) : 0;
+
+                size_t slotIdx = chunkOffsets_[chunkIdx];
+                auto colIt = row.begin();
+                const auto& colEndIt = row.end();
+                for (; colIt != colEndIt; ++colIt, ++slotIdx) {
+                    colIndices_[slotIdx*chunkSize + laneIdx] = static_cast<unsigned>(colIt.index());
+                    srcBlocks_[slotIdx*chunkSize + laneIdx] = &(*colIt);
+                    ++numStoredBlocks_;
+                }
+                for (; slotIdx < chunkOffsets_[chunkIdx + 1]; ++slotIdx)
+                    colIndices_[slotIdx*chunkSize + laneIdx] = paddingColIdx;
+            }
+        }
+
+        updateValues();
+    }
+
+    /*!
+     * \brief Copy the values of the entries from the BCRS matrix which was passed to
+     *        build().
+     */
+    void updateValues()
+    {
+        int numSlots = static_cast<int>(srcBlocks_.size()/chunkSize);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int slotIdx = 0; slotIdx < numSlots; ++slotIdx) {
+            Scalar* slotValues = values_.data() + static_cast<size_t>(slotIdx)*chunkSize*blockSize;
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                const Block* srcBlock = srcBlocks_[static_cast<size_t>(slotIdx)*chunkSize + laneIdx];
+                if (!srcBlock)
+                    continue; // padding
+
+                for (int i = 0; i < numRowsPerBlock; ++i)
+                    for (int j = 0; j < numColsPerBlock; ++j)
+                        slotValues[(i*numColsPerBlock + j)*chunkSize + laneIdx] = (*srcBlock)[i][j];
+            }
+        }
+    }
+
+    /*!
+     * \brief Invert the diagonal blocks of the represented rows for jacobiStep().
+     *
+     * This must be called after updateValues() if Jacobi steps ought to be performed.
+     */
+    void updateInverseDiagonal()
+    {
+        int numChunks = static_cast<int>(rowIndices_.size()/chunkSize);
+        invDiagonal_.assign(static_cast<size_t>(numChunks)*chunkSize*blockSize, 0.0);
+
+        int numFailures = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:numFailures)
+#endif
+        for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+            Scalar* chunkInvDiag = invDiagonal_.data() + static_cast<size_t>(chunkIdx)*chunkSize*blockSize;
+            size_t slotBegin = chunkOffsets_[static_cast<size_t>(chunkIdx)];
+            size_t slotEnd = chunkOffsets_[static_cast<size_t>(chunkIdx) + 1];
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                unsigned rowIdx = rowIndices_[static_cast<size_t>(chunkIdx)*chunkSize + laneIdx];
+                if (rowIdx == invalidRow)
+                    continue;
+
+                const Block* diagBlock = nullptr;
+                for (size_t slotIdx = slotBegin; slotIdx < slotEnd && !diagBlock; ++slotIdx)
+                    if (srcBlocks_[slotIdx*chunkSize + laneIdx]
+                        && colIndices_[slotIdx*chunkSize + laneIdx] == rowIdx)
+                        diagBlock = srcBlocks_[slotIdx*chunkSize + laneIdx];
+                if (!diagBlock) {
+                    ++numFailures;
+                    continue;
+                }
+
+                Block invBlock(*diagBlock);
+                try {
+                    invBlock.invert();
+                }
+                catch (const Dune::FMatrixError&) {
+                    ++numFailures;
+                    continue;
+                }
+
+                for (int i = 0; i < numRowsPerBlock; ++i)
+                    for (int j = 0; j < numColsPerBlock; ++j)
+                        chunkInvDiag[(i*numColsPerBlock + j)*chunkSize + laneIdx] = invBlock[i][j];
+            }
+        }
+
+        if (numFailures > 0)
+            OPM_THROW(Opm::NumericalProblem,
+                      "Inverting the diagonal of the matrix failed: missing or singular diagonal block");
+    }
+
+    /*!
+     * \brief Returns the number of rows which are represented by the matrix.
+     */
+    size_t numRows() const
+    { return numRows_; }
+
+    /*!
+     * \brief Returns the ratio between the number of non-zero blocks and the number of
+     *        stored blocks including the padding.
+     */
+    double fillRatio() const
+    {
+        if (srcBlocks_.empty())
+            return 1.0;
+        return static_cast<double>(numStoredBlocks_)/srcBlocks_.size();
+    }
+
+    /*!
+     * \brief Compute \f$ y = A x \f$ for the represented rows.
+     */
+    template <class DomainVector, class RangeVector>
+    void mv(const DomainVector& x, RangeVector& y) const
+    { multiply_</*add=*/false>(1.0, x, y); }
+
+    /*!
+     * \brief Compute \f$ y = y + \alpha A x \f$ for the represented rows.
+     */
+    template <class DomainVector, class RangeVector>
+    void usmv(typename RangeVector::field_type alpha, const DomainVector& x, RangeVector& y) const
+    { multiply_</*add=*/true>(alpha, x, y); }
+
+    /*!
+     * \brief Perform a damped Jacobi step for the represented rows.
+     *
+     * This computes \f$ x_{new} = x + \omega D^{-1} (b - A x) \f$, where \f$ D \f$ is
+     * the block diagonal of the matrix. updateInverseDiagonal() must have been called
+     * before. x and xNew must not be the same vector.
+     */
+    template <class DomainVector, class RangeVector>
+    void jacobiStep(typename DomainVector::field_type relaxationFactor,
+                    const DomainVector& x,
+                    DomainVector& xNew,
+                    const RangeVector& b) const
+    {
+        typedef typename DomainVector::field_type DomainScalar;
+
+        int numChunks = static_cast<int>(rowIndices_.size()/chunkSize);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+            // the residual of the rows of the chunk
+            DomainScalar r[numRowsPerBlock][chunkSize];
+            chunkProduct_(static_cast<size_t>(chunkIdx), x, r);
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                unsigned rowIdx = rowIndices_[static_cast<size_t>(chunkIdx)*chunkSize + laneIdx];
+                for (int i = 0; i < numRowsPerBlock; ++i) {
+                    DomainScalar bi = (rowIdx == invalidRow) ? 0.0 : b[rowIdx][static_cast<unsigned>(i)];
+                    r[i][laneIdx] = bi - r[i][laneIdx];
+                }
+            }
+
+            // multiply the residual by the inverted diagonal blocks of the chunk
+            const Scalar* chunkInvDiag = invDiagonal_.data() + static_cast<size_t>(chunkIdx)*chunkSize*blockSize;
+            DomainScalar dx[numRowsPerBlock][chunkSize];
+            for (int i = 0; i < numRowsPerBlock; ++i) {
+                for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx)
+                    dx[i][laneIdx] = 0.0;
+                for (int j = 0; j < numColsPerBlock; ++j) {
+                    const Scalar* v = chunkInvDiag + (i*numColsPerBlock + j)*chunkSize;
+                    for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx)
+                        dx[i][laneIdx] += v[laneIdx]*r[j][laneIdx];
+                }
+            }
+
+            // scatter the update to the rows of the result
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                unsigned rowIdx = rowIndices_[static_cast<size_t>(chunkIdx)*chunkSize + laneIdx];
+                if (rowIdx == invalidRow)
+                    continue;
+
+                const auto& xRow = x[rowIdx];
+                auto& xNewRow = xNew[rowIdx];
+                for (int i = 0; i < numRowsPerBlock; ++i)
+                    xNewRow[static_cast<unsigned>(i)] =
+                        xRow[static_cast<unsigned>(i)] + relaxationFactor*dx[i][laneIdx];
+            }
+        }
+    }
+
+private:
+    // compute the product of the rows of a chunk with a vector
+    template <class DomainVector, class ResultScalar>
+    void chunkProduct_(size_t chunkIdx,
+                       const DomainVector& x,
+                       ResultScalar (&yLocal)[numRowsPerBlock][chunkSize]) const
+    {
+        for (int i = 0; i < numRowsPerBlock; ++i)
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx)
+                yLocal[i][laneIdx] = 0.0;
+
+        size_t slotBegin = chunkOffsets_[chunkIdx];
+        size_t slotEnd = chunkOffsets_[chunkIdx + 1];
+        for (size_t slotIdx = slotBegin; slotIdx < slotEnd; ++slotIdx) {
+            const unsigned* colIndices = colIndices_.data() + slotIdx*chunkSize;
+            const Scalar* slotValues = values_.data() + slotIdx*chunkSize*blockSize;
+
+            for (int j = 0; j < numColsPerBlock; ++j) {
+                // gather the relevant entries of the domain vector
+                ResultScalar xLocal[chunkSize];
+                for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx)
+                    xLocal[laneIdx] = x[colIndices[laneIdx]][static_cast<unsigned>(j)];
+
+                // the innermost loop goes over the rows of the chunk, i.e., over
+                // contiguous memory. this is the one which gets vectorized.
+                for (int i = 0; i < numRowsPerBlock; ++i) {
+                    const Scalar* v = slotValues + (i*numColsPerBlock + j)*chunkSize;
+                    for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx)
+                        yLocal[i][laneIdx] += v[laneIdx]*xLocal[laneIdx];
+                }
+            }
+        }
+    }
+
+    template <bool add, class DomainVector, class RangeVector>
+    void multiply_(typename RangeVector::field_type alpha,
+                   const DomainVector& x,
+                   RangeVector& y) const
+    {
+        typedef typename RangeVector::field_type RangeScalar;
+
+        int numChunks = static_cast<int>(rowIndices_.size()/chunkSize);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx) {
+            RangeScalar yLocal[numRowsPerBlock][chunkSize];
+            chunkProduct_(static_cast<size_t>(chunkIdx), x, yLocal);
+
+            // scatter the result to the rows of the range vector
+            for (unsigned laneIdx = 0; laneIdx < chunkSize; ++laneIdx) {
+                unsigned rowIdx = rowIndices_[static_cast<size_t>(chunkIdx)*chunkSize + laneIdx];
+                if (rowIdx == invalidRow)
+                    continue;
+
+                auto& yRow = y[rowIdx];
+                for (int i = 0; i < numRowsPerBlock; ++i) {
+                    if (add)
+                        yRow[static_cast<unsigned>(i)] += alpha*yLocal[i][laneIdx];
+                    else
+                        yRow[static_cast<unsigned>(i)] = yLocal[i][laneIdx];
+                }
+            }
+        }
+    }
+
+    // the index of the first slot of each chunk. the width of a chunk is given by the
+    // difference to the offset of the next one
+    std::vector<size_t> chunkOffsets_;
+
+    // the index of the matrix row which corresponds to each lane of each chunk
+    std::vector<unsigned> rowIndices_;
+
+    // the column indices and values of all slots in "lane-major" order
+    std::vector<unsigned> colIndices_;
+    std::vector<Scalar> values_;
+
+    // the inverted diagonal blocks of the rows of each chunk in "lane-major" order.
+    // only used by jacobiStep()
+    std::vector<Scalar> invDiagonal_;
+
+    // the blocks of the BCRS matrix which correspond to each stored entry. padding
+    // entries are represented by null pointers.
+    std::vector<const Block*> srcBlocks_;
+
+    size_t numRows_ = 0;
+    size_t numStoredBlocks_ = 0;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,118 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::Linear::SellJacobi
+ */
+#ifndef EWOMS_SELL_JACOBI_HH
+#define EWOMS_SELL_JACOBI_HH
+
+#include <opm/common/Unused.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/istl/preconditioner.hh>
+#include <dune/common/version.hh>
+
+#include <memory>
+#include <stdexcept>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief A damped block Jacobi preconditioner which operates on the SELL-C-sigma
+ *        storage of an overlapping BCRS matrix.
+ *
+ * This computes the same iterates as Dune::SeqJac, but the residuals are computed
+ * using the vectorized matrix-vector product of the SELL-C-sigma format and the
+ * inverted diagonal blocks are stored in the same layout. The matrix must use the
+ * SELL-C-sigma storage, i.e., the LinearSolverUseSellStorage parameter must be
+ * enabled. Since the storage is only provided by OverlappingBCRSMatrix, this
+ * preconditioner cannot be used with a reduced precision preconditioner matrix.
+ */
+template <class M, class X, class Y>
+class SellJacobi : public Dune::Preconditioner<X, Y>
+{
+public:
+    typedef M matrix_type;
+    typedef X domain_type;
+    typedef Y range_type;
+    typedef typename X::field_type field_type;
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,6)
+    //! the kind of computations supported by the operator. Either overlapping or non-overlapping
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+#else
+    // redefine the category
+    enum { category = Dune::SolverCategory::sequential };
+#endif
+
+    /*!
+     * \brief Create the preconditioner and invert the diagonal blocks of the matrix.
+     *
+     * \param A The matrix. Its SELL-C-sigma storage must be up to date.
+     * \param numIterations The number of Jacobi steps per application
+     * \param relaxationFactor The damping factor of the Jacobi steps
+     */
+    SellJacobi(M& A, int numIterations, field_type relaxationFactor)
+        : A_(A)
+        , numIterations_(numIterations)
+        , relaxationFactor_(relaxationFactor)
+    {
+        if (!A.sellStorageEnabled())
+            OPM_THROW(std::logic_error,
+                      "The SELL-C-sigma Jacobi preconditioner requires the matrix to use "
+                      "the SELL-C-sigma storage (parameter LinearSolverUseSellStorage)");
+
+        A.updateSellInverseDiagonal();
+    }
+
+    void pre(X& x OPM_UNUSED, Y& b OPM_UNUSED) override
+    {}
+
+    void apply(X& v, const Y& d) override
+    {
+        if (!tmp_ || tmp_->size() != v.size())
+            tmp_.reset(new X(v));
+
+        for (int i = 0; i < numIterations_; ++i) {
+            A_.sellJacobiStep(relaxationFactor_, v, *tmp_, d);
+            v = *tmp_;
+        }
+    }
+
+    void post(X& x OPM_UNUSED) override
+    {}
+
+private:
+    const M& A_;
+    int numIterations_;
+    field_type relaxationFactor_;
+    std::unique_ptr<X> tmp_;
+};
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -54,6 +54,8 @@
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/common/Exceptions.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <string>
 
@@ -429,6 +431,52 @@ public:
         priVars.setPvtRegionIndex(pvtRegionIdx);
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::binaryEntitySize
+     *
+     * The black-oil model appends the meaning of the primary variables and the PVT
+     * region index to the raw primary variables.
+     */
+    size_t binaryEntitySize() const
+    { return ParentType::binaryEntitySize() + 2*sizeof(int32_t); }
+
+    /*!
+     * \copydoc FvBaseDiscretization::serializeEntityBinary
+     */
+    template <class DofEntity>
+    void serializeEntityBinary(char* record, const DofEntity& dof) const
+    {
+        ParentType::serializeEntityBinary(record, dof);
+
+        unsigned dofIdx = static_cast<unsigned>(asImp_().dofMapper().index(dof));
+        const auto& priVars = this->solution(/*timeIdx=*/0)[dofIdx];
+
+        int32_t metaData[2] = {
+            static_cast<int32_t>(priVars.primaryVarsMeaning()),
+            static_cast<int32_t>(priVars.pvtRegionIndex())
+        };
+        std::memcpy(record + ParentType::binaryEntitySize(), metaData, sizeof(metaData));
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::deserializeEntityBinary
+     */
+    template <class DofEntity>
+    void deserializeEntityBinary(const char* record, const DofEntity& dof)
+    {
+        ParentType::deserializeEntityBinary(record, dof);
+
+        unsigned dofIdx = static_cast<unsigned>(asImp_().dofMapper().index(dof));
+        auto& priVars = this->solution(/*timeIdx=*/0)[dofIdx];
+
+        int32_t metaData[2];
+        std::memcpy(metaData, record + ParentType::binaryEntitySize(), sizeof(metaData));
+
+        typedef typename PrimaryVariables::PrimaryVarsMeaning PVM;
+        priVars.setPrimaryVarsMeaning(static_cast<PVM>(metaData[0]));
+        priVars.setPvtRegionIndex(static_cast<unsigned>(metaData[1]));
+    }
+
     /*!
      * \brief Deserializes the state of the model.
      *
@@ -94,17 +94,9 @@ protected:
     void endIteration_(SolutionVector& uCurrentIter,
                        const SolutionVector& uLastIter)
     {
-#if HAVE_MPI
-        // in the MPI enabled case we need to add up the number of DOF
-        // for which the interpretation changed over all processes.
-        int localSwitched = numPriVarsSwitched_;
-        MPI_Allreduce(&localSwitched,
-                      &numPriVarsSwitched_,
-                      /*num=*/1,
-                      MPI_INT,
-                      MPI_SUM,
-                      MPI_COMM_WORLD);
-#endif // HAVE_MPI
+        // in the parallel case we need to add up the number of DOF for which the
+        // interpretation changed over all processes.
+        numPriVarsSwitched_ = this->simulator_.gridView().comm().sum(numPriVarsSwitched_);
 
         this->simulator_.model().newtonMethod().endIterMsg()
             << ", num switched=" << numPriVarsSwitched_;
@@ -52,6 +52,8 @@
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/common/Exceptions.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -453,6 +455,42 @@ public:
         this->solution(/*timeIdx=*/1)[dofIdx].setPhasePresence(tmp);
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::binaryEntitySize
+     *
+     * The phase presence is appended to the raw primary variables.
+     */
+    size_t binaryEntitySize() const
+    { return ParentType::binaryEntitySize() + sizeof(int32_t); }
+
+    /*!
+     * \copydoc FvBaseDiscretization::serializeEntityBinary
+     */
+    template <class DofEntity>
+    void serializeEntityBinary(char* record, const DofEntity& dofEntity) const
+    {
+        ParentType::serializeEntityBinary(record, dofEntity);
+
+        unsigned dofIdx = static_cast<unsigned>(this->dofMapper().index(dofEntity));
+        int32_t phasePresence = this->solution(/*timeIdx=*/0)[dofIdx].phasePresence();
+        std::memcpy(record + ParentType::binaryEntitySize(), &phasePresence, sizeof(phasePresence));
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::deserializeEntityBinary
+     */
+    template <class DofEntity>
+    void deserializeEntityBinary(const char* record, const DofEntity& dofEntity)
+    {
+        ParentType::deserializeEntityBinary(record, dofEntity);
+
+        unsigned dofIdx = static_cast<unsigned>(this->dofMapper().index(dofEntity));
+        int32_t phasePresence;
+        std::memcpy(&phasePresence, record + ParentType::binaryEntitySize(), sizeof(phasePresence));
+        this->solution(/*timeIdx=*/0)[dofIdx].setPhasePresence(static_cast<short>(phasePresence));
+        this->solution(/*timeIdx=*/1)[dofIdx].setPhasePresence(static_cast<short>(phasePresence));
+    }
+
     /*!
      * \internal
      * \brief Do the primary variable switching after a Newton iteration.
@@ -193,7 +193,7 @@ public:
         : simulator_(simulator)
         , endIterMsgStream_(std::ostringstream::out)
         , linearSolver_(simulator)
-        , comm_(Dune::MPIHelper::getCommunicator())
+        , comm_(simulator.communicator())
         , convergenceWriter_(asImp_())
     {
         lastError_ = 1e100;
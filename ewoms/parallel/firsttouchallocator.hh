@@ -0,0 +1,123 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Ewoms::FirstTouchAllocator
+ */
+#ifndef EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+#define EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+
+#include <ewoms/common/alignedallocator.hh>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <unistd.h>
+
+#include <cstddef>
+
+namespace Ewoms {
+/*!
+ * \brief Writes to each memory page of a freshly allocated buffer using all OpenMP
+ *        threads.
+ *
+ * Linux places a page on the NUMA node of the thread which writes to it first. The
+ * pages are distributed using OpenMP's static schedule, i.e., for arrays of uniformly
+ * sized objects each thread touches the part of the array which it accesses in a loop
+ * of the form '#pragma omp parallel for' later on.
+ */
+inline void firstTouch(void* ptr, std::size_t numBytes)
+{
+#ifdef _OPENMP
+    static const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    // small buffers and allocations from within parallel regions are left alone
+    if (numBytes < 4*pageSize || omp_in_parallel())
+        return;
+
+    char* bytes = static_cast<char*>(ptr);
+    long numPages = static_cast<long>((numBytes + pageSize - 1)/pageSize);
+#pragma omp parallel for schedule(static)
+    for (long pageIdx = 0; pageIdx < numPages; ++pageIdx)
+        bytes[static_cast<std::size_t>(pageIdx)*pageSize] = 0;
+
+    // the buffer is usually not page aligned, so the stride above may miss the last
+    // page
+    bytes[numBytes - 1] = 0;
+#else
+    (void)ptr;
+    (void)numBytes;
+#endif
+}
+
+/*!
+ * \brief An aligned allocator which places the allocated memory on the NUMA nodes of
+ *        the threads which will later work on it.
+ *
+ * Besides the fact that the memory gets touched in parallel by firstTouch() before any
+ * objects are constructed, this allocator is identical to Ewoms::aligned_allocator. It
+ * is intended for the large per-degree of freedom arrays whose elements are traversed
+ * by multiple threads, e.g., the Jacobian matrix and the cached intensive quantities.
+ */
+template <class T, std::size_t Alignment = alignof(T)>
+class FirstTouchAllocator : public aligned_allocator<T, Alignment>
+{
+    typedef aligned_allocator<T, Alignment> ParentType;
+
+public:
+    typedef typename ParentType::pointer pointer;
+    typedef typename ParentType::size_type size_type;
+    typedef typename ParentType::const_void_pointer const_void_pointer;
+
+    template <class U>
+    struct rebind
+    { typedef FirstTouchAllocator<U, Alignment> other; };
+
+    FirstTouchAllocator() noexcept = default;
+
+    template <class U>
+    FirstTouchAllocator(const FirstTouchAllocator<U, Alignment>&) noexcept
+    {}
+
+    pointer allocate(size_type size, const_void_pointer hint = 0)
+    {
+        pointer p = ParentType::allocate(size, hint);
+        firstTouch(p, size*sizeof(T));
+        return p;
+    }
+};
+
+template <class T1, class T2, std::size_t Alignment>
+inline bool operator==(const FirstTouchAllocator<T1, Alignment>&,
+                       const FirstTouchAllocator<T2, Alignment>&) noexcept
+{ return true; }
+
+template <class T1, class T2, std::size_t Alignment>
+inline bool operator!=(const FirstTouchAllocator<T1, Alignment>&,
+                       const FirstTouchAllocator<T2, Alignment>&) noexcept
+{ return false; }
+
+} // namespace Ewoms
+
+#endif
@@ -34,6 +34,12 @@
 #include <dune/grid/common/datahandleif.hh>
 #include <dune/common/version.hh>
 
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace Ewoms {
 
 /*!
@@ -265,6 +271,191 @@ private:
     Container& container_;
 };
 
+/*!
+ * \brief Data handle for parallel communication which exchanges an arbitrary number of
+ *        fields attached to DOFs using a single message per neighboring process.
+ *
+ * Each field consists of a container and the operation which combines the received
+ * values with the local ones, i.e., the batch handle is equivalent to a sequence of
+ * sum, maximum, minimum and ghost synchronization handles which use the same
+ * communication interface. The entries of the containers are either scalars or
+ * fixed-size vectors of FieldType like Dune::FieldVector.
+ */
+template <class FieldType, class EntityMapper, unsigned commCodim>
+class GridCommHandleBatch
+    : public Dune::CommDataHandleIF<GridCommHandleBatch<FieldType, EntityMapper, commCodim>,
+                                    FieldType>
+{
+    enum Operation { sumOp, maxOp, minOp, copyOp };
+
+    // the number of scalars of a container entry and the access to them
+    template <class Value, bool isScalar = std::is_arithmetic<Value>::value>
+    struct ValueTraits_
+    {
+        static constexpr unsigned size = Value::dimension;
+
+        static FieldType get(const Value& value, unsigned i)
+        { return value[i]; }
+
+        static typename Value::field_type& ref(Value& value, unsigned i)
+        { return value[i]; }
+    };
+
+    template <class Value>
+    struct ValueTraits_<Value, /*isScalar=*/true>
+    {
+        static constexpr unsigned size = 1;
+
+        static FieldType get(const Value& value, unsigned i OPM_UNUSED)
+        { return value; }
+
+        static Value& ref(Value& value, unsigned i OPM_UNUSED)
+        { return value; }
+    };
+
+    class FieldBase_
+    {
+    public:
+        virtual ~FieldBase_()
+        {}
+
+        virtual unsigned numValues() const = 0;
+        virtual void gather(unsigned dofIdx, FieldType* values) const = 0;
+        virtual void scatter(unsigned dofIdx, const FieldType* values) = 0;
+    };
+
+    template <class Container>
+    class Field_ : public FieldBase_
+    {
+        typedef typename std::remove_reference<decltype(std::declval<Container&>()[0])>::type Value;
+        typedef ValueTraits_<Value> Traits;
+
+    public:
+        Field_(Container& container, Operation op)
+            : container_(container), op_(op)
+        {}
+
+        unsigned numValues() const override
+        { return Traits::size; }
+
+        void gather(unsigned dofIdx, FieldType* values) const override
+        {
+            for (unsigned i = 0; i < Traits::size; ++i)
+                values[i] = Traits::get(container_[dofIdx], i);
+        }
+
+        void scatter(unsigned dofIdx, const FieldType* values) override
+        {
+            for (unsigned i = 0; i < Traits::size; ++i) {
+                auto& dest = Traits::ref(container_[dofIdx], i);
+                switch (op_) {
+                case sumOp: dest += values[i]; break;
+                case maxOp: dest = std::max<FieldType>(dest, values[i]); break;
+                case minOp: dest = std::min<FieldType>(dest, values[i]); break;
+                case copyOp: dest = values[i]; break;
+                }
+            }
+        }
+
+    private:
+        Container& container_;
+        Operation op_;
+    };
+
+public:
+    GridCommHandleBatch(const EntityMapper& mapper)
+        : mapper_(mapper), numValues_(0)
+    {}
+
+    /*!
+     * \brief Add a field whose values are summed up over all processes.
+     */
+    template <class Container>
+    void addSum(Container& container)
+    { addField_(container, sumOp); }
+
+    /*!
+     * \brief Add a field for which the maximum value of all processes is taken.
+     */
+    template <class Container>
+    void addMax(Container& container)
+    { addField_(container, maxOp); }
+
+    /*!
+     * \brief Add a field for which the minimum value of all processes is taken.
+     */
+    template <class Container>
+    void addMin(Container& container)
+    { addField_(container, minOp); }
+
+    /*!
+     * \brief Add a field whose values of the ghost and overlap DOFs are set to the ones
+     *        of their respective master processes.
+     */
+    template <class Container>
+    void addGhostSync(Container& container)
+    { addField_(container, copyOp); }
+
+    /*!
+     * \brief Returns true if no fields have been added to the batch.
+     */
+    bool empty() const
+    { return fields_.empty(); }
+
+    bool contains(unsigned dim OPM_UNUSED, unsigned codim) const
+    {
+        // return true if the codim is the same as the codim which we
+        // are asked to communicate with.
+        return codim == commCodim;
+    }
+
+    bool fixedsize(unsigned dim OPM_UNUSED, unsigned codim OPM_UNUSED) const
+    {
+        // for each DOF we communicate the same number of values
+        return true;
+    }
+
+    template <class EntityType>
+    size_t size(const EntityType& e OPM_UNUSED) const
+    { return numValues_; }
+
+    template <class MessageBufferImp, class EntityType>
+    void gather(MessageBufferImp& buff, const EntityType& e) const
+    {
+        unsigned dofIdx = static_cast<unsigned>(mapper_.index(e));
+        for (const auto& field : fields_) {
+            field->gather(dofIdx, values_.data());
+            for (unsigned i = 0; i < field->numValues(); ++i)
+                buff.write(values_[i]);
+        }
+    }
+
+    template <class MessageBufferImp, class EntityType>
+    void scatter(MessageBufferImp& buff, const EntityType& e, size_t n OPM_UNUSED)
+    {
+        unsigned dofIdx = static_cast<unsigned>(mapper_.index(e));
+        for (auto& field : fields_) {
+            for (unsigned i = 0; i < field->numValues(); ++i)
+                buff.read(values_[i]);
+            field->scatter(dofIdx, values_.data());
+        }
+    }
+
+private:
+    template <class Container>
+    void addField_(Container& container, Operation op)
+    {
+        fields_.emplace_back(new Field_<Container>(container, op));
+        numValues_ += fields_.back()->numValues();
+        values_.resize(std::max<size_t>(values_.size(), fields_.back()->numValues()));
+    }
+
+    const EntityMapper& mapper_;
+    std::vector<std::unique_ptr<FieldBase_> > fields_;
+    size_t numValues_;
+    mutable std::vector<FieldType> values_;
+};
+
 } // namespace Ewoms
 
 #endif
@@ -31,6 +31,8 @@
 #include <mpi.h>
 #endif
 
+#include <dune/common/parallel/mpihelper.hh>
+
 #include <stddef.h>
 
 #include <type_traits>
@@ -45,6 +47,8 @@ template <class DataType>
 class MpiBuffer
 {
 public:
+    typedef Dune::MPIHelper::MPICommunicator Communicator;
+
     MpiBuffer()
     {
         data_ = NULL;
@@ -81,8 +85,11 @@ public:
 
     /*!
      * \brief Send the buffer asyncronously to a peer process.
+     *
+     * The rank of the peer process is relative to the communicator comm.
      */
-    void send(unsigned peerRank)
+    void send(unsigned peerRank,
+              Communicator comm = Dune::MPIHelper::getCommunicator())
     {
 #if HAVE_MPI
         MPI_Isend(data_,
@@ -90,13 +97,13 @@ public:
                   mpiDataType_,
                   static_cast<int>(peerRank),
                   0, // tag
-                  MPI_COMM_WORLD,
+                  comm,
                   &mpiRequest_);
 #endif
     }
 
     /*!
-     * \brief Wait until the buffer was send to the peer completely.
+     * \brief Wait until the buffer was send to or received from the peer completely.
      */
     void wait()
     {
@@ -108,7 +115,8 @@ public:
     /*!
      * \brief Receive the buffer syncronously from a peer rank
      */
-    void receive(unsigned peerRank)
+    void receive(unsigned peerRank,
+                 Communicator comm = Dune::MPIHelper::getCommunicator())
     {
 #if HAVE_MPI
         MPI_Recv(data_,
@@ -116,24 +124,43 @@ public:
                  mpiDataType_,
                  static_cast<int>(peerRank),
                  0, // tag
-                 MPI_COMM_WORLD,
+                 comm,
                  &mpiStatus_);
         assert(!mpiStatus_.MPI_ERROR);
 #endif // HAVE_MPI
     }
 
+    /*!
+     * \brief Start receiving the buffer asyncronously from a peer rank
+     *
+     * The data is only available after the wait() method was called.
+     */
+    void receiveAsync(unsigned peerRank,
+                      Communicator comm = Dune::MPIHelper::getCommunicator())
+    {
+#if HAVE_MPI
+        MPI_Irecv(data_,
+                  static_cast<int>(mpiDataSize_),
+                  mpiDataType_,
+                  static_cast<int>(peerRank),
+                  0, // tag
+                  comm,
+                  &mpiRequest_);
+#endif // HAVE_MPI
+    }
+
 #if HAVE_MPI
     /*!
      * \brief Returns the current MPI_Request object.
      *
-     * This object is only well defined after the send() method.
+     * This object is only well defined after the send() and receiveAsync() methods.
      */
     MPI_Request& request()
     { return mpiRequest_; }
     /*!
      * \brief Returns the current MPI_Request object.
      *
-     * This object is only well defined after the send() method.
+     * This object is only well defined after the send() and receiveAsync() methods.
      */
     const MPI_Request& request() const
     { return mpiRequest_; }
@@ -32,17 +32,40 @@
 #endif
 
 #include <ewoms/parallel/locks.hh>
+#include <ewoms/parallel/firsttouchallocator.hh>
 #include <ewoms/common/parametersystem.hh>
 #include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/timer.hh>
 
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/common/Exceptions.hpp>
+#include <opm/common/Unused.hpp>
 
 #include <dune/common/version.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/parallel/collectivecommunication.hh>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace Ewoms {
 namespace Properties {
 NEW_PROP_TAG(ThreadsPerProcess);
+NEW_PROP_TAG(ThreadAffinity);
+NEW_PROP_TAG(CheckMemoryBandwidth);
 }
 
 /*!
@@ -52,6 +75,8 @@ template <class TypeTag>
 class ThreadManager
 {
 public:
+    typedef Dune::MPIHelper::MPICommunicator Communicator;
+
     enum {
 #if defined(_OPENMP) || DOXYGEN
         //! Specify whether OpenMP is really available or not
@@ -69,9 +94,23 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, ThreadsPerProcess,
                              "The maximum number of threads to be instantiated per process "
                              "('-1' means 'automatic')");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ThreadAffinity,
+                             "How the threads are pinned to the CPU cores. Possible values: "
+                             "'none', 'compact' (fill the sockets one after another) and "
+                             "'scatter' (distribute the threads over the sockets)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, CheckMemoryBandwidth,
+                             "Measure and print the memory bandwidth which is achieved by "
+                             "the threads of all processes at startup");
     }
 
-    static void init()
+    /*!
+     * \brief Initialize the threads of the current process.
+     *
+     * \param comm The MPI communicator of the simulation. If the memory bandwidth is
+     *             checked, all processes of this communicator must call this method. If
+     *             the threads are pinned, all processes of MPI_COMM_WORLD must call it.
+     */
+    static void init(Communicator comm)
     {
         numThreads_ = EWOMS_GET_PARAM(TypeTag, int, ThreadsPerProcess);
 
@@ -105,6 +144,70 @@ public:
 
         numThreads_ = omp_get_max_threads();
 #endif
+
+        const std::string& affinity = EWOMS_GET_PARAM(TypeTag, std::string, ThreadAffinity);
+        if (affinity == "compact")
+            pinThreads_(/*scatter=*/false);
+        else if (affinity == "scatter")
+            pinThreads_(/*scatter=*/true);
+        else if (affinity != "none")
+            OPM_THROW(std::invalid_argument,
+                      "Unknown thread affinity '" << affinity << "'. Possible values are "
+                      "'none', 'compact' and 'scatter'.");
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, CheckMemoryBandwidth)) {
+            Dune::CollectiveCommunication<Communicator> collComm(comm);
+            double bandwidth = measureMemoryBandwidth();
+            double totalBandwidth = collComm.sum(bandwidth);
+            if (collComm.rank() == 0)
+                std::cout << "Memory bandwidth of the triad kernel: "
+                          << bandwidth/1e9 << " GB/s on rank 0, "
+                          << totalBandwidth/1e9 << " GB/s in total\n" << std::flush;
+        }
+    }
+
+    /*!
+     * \brief Measure the memory bandwidth [B/s] which is achieved by all threads of the
+     *        local process for a STREAM-like triad kernel.
+     *
+     * The arrays are first touched in parallel, i.e., the result reflects the bandwidth
+     * which the thread placement and the memory layout of the simulator achieve. If
+     * this method is called by all processes at the same time, the result is the share
+     * of the node's bandwidth which a single process gets.
+     */
+    static double measureMemoryBandwidth(unsigned numElements = 1 << 24, unsigned numRepetitions = 5)
+    {
+        typedef std::vector<double, FirstTouchAllocator<double, 64> > Vector;
+        Vector a(numElements), b(numElements), c(numElements);
+
+        int n = static_cast<int>(numElements);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < n; ++i) {
+            b[static_cast<unsigned>(i)] = 1.0;
+            c[static_cast<unsigned>(i)] = 2.0;
+        }
+
+        double bestTime = 1e100;
+        for (unsigned repIdx = 0; repIdx < numRepetitions; ++repIdx) {
+            Timer timer;
+            timer.start();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (int i = 0; i < n; ++i) {
+                unsigned j = static_cast<unsigned>(i);
+                a[j] = b[j] + 3.0*c[j];
+            }
+            bestTime = std::min(bestTime, timer.stop());
+        }
+
+        // make sure that the compiler cannot get rid of the kernel
+        if (a[numElements/2] != 7.0)
+            OPM_THROW(std::logic_error, "Triad kernel produced a wrong result");
+
+        return 3.0*sizeof(double)*numElements/bestTime;
     }
 
     /*!
@@ -126,6 +229,87 @@ public:
     }
 
 private:
+    /*!
+     * \brief Bind each OpenMP thread to a single CPU.
+     *
+     * If the launcher already restricted the process to a subset of the CPUs (e.g., via
+     * 'mpirun --bind-to'), the threads are distributed over this subset. Otherwise, the
+     * CPUs of the node are split into contiguous chunks for all processes which run on
+     * the same node. These are determined using MPI_COMM_WORLD because the simulation
+     * communicator may be a subset of the processes sharing the node.
+     */
+    static void pinThreads_(bool scatter OPM_UNUSED)
+    {
+#if defined(_OPENMP) && defined(__linux__)
+        cpu_set_t processSet;
+        CPU_ZERO(&processSet);
+        if (sched_getaffinity(0, sizeof(processSet), &processSet) != 0)
+            return;
+
+        // sort the available CPUs by socket. for the scatter policy the sockets are
+        // interleaved, i.e., consecutive threads end up on different sockets
+        std::map<int, std::vector<int> > socketCpus;
+        for (int cpuIdx = 0; cpuIdx < CPU_SETSIZE; ++cpuIdx)
+            if (CPU_ISSET(cpuIdx, &processSet))
+                socketCpus[socketIndex_(cpuIdx)].push_back(cpuIdx);
+
+        std::vector<int> cpus;
+        if (scatter) {
+            for (unsigned i = 0; cpus.size() < static_cast<size_t>(CPU_COUNT(&processSet)); ++i)
+                for (const auto& socket : socketCpus)
+                    if (i < socket.second.size())
+                        cpus.push_back(socket.second[i]);
+        }
+        else {
+            for (const auto& socket : socketCpus)
+                cpus.insert(cpus.end(), socket.second.begin(), socket.second.end());
+        }
+
+        int localRank = 0;
+        int localSize = 1;
+#if HAVE_MPI && MPI_VERSION >= 3
+        int mpiInitialized;
+        MPI_Initialized(&mpiInitialized);
+        if (mpiInitialized) {
+            MPI_Comm nodeComm;
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, /*key=*/0,
+                                MPI_INFO_NULL, &nodeComm);
+            MPI_Comm_rank(nodeComm, &localRank);
+            MPI_Comm_size(nodeComm, &localSize);
+            MPI_Comm_free(&nodeComm);
+        }
+#endif
+
+        long numOnlineCpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+        if (localSize > 1 && static_cast<long>(cpus.size()) == numOnlineCpus) {
+            size_t begin = cpus.size()*static_cast<size_t>(localRank)/static_cast<size_t>(localSize);
+            size_t end = cpus.size()*static_cast<size_t>(localRank + 1)/static_cast<size_t>(localSize);
+            if (begin == end)
+                end = begin + 1;
+            cpus = std::vector<int>(cpus.begin() + static_cast<long>(begin),
+                                    cpus.begin() + static_cast<long>(end));
+        }
+
+#pragma omp parallel
+        {
+            cpu_set_t threadSet;
+            CPU_ZERO(&threadSet);
+            CPU_SET(cpus[static_cast<size_t>(omp_get_thread_num()) % cpus.size()], &threadSet);
+            sched_setaffinity(/*pid=*/0, sizeof(threadSet), &threadSet);
+        }
+#endif
+    }
+
+    static int socketIndex_(int cpuIdx)
+    {
+        std::ifstream topologyFile("/sys/devices/system/cpu/cpu" + std::to_string(cpuIdx)
+                                   + "/topology/physical_package_id");
+        int socketIdx = 0;
+        if (!(topologyFile >> socketIdx))
+            return 0;
+        return socketIdx;
+    }
+
     static int numThreads_;
 };
 
@@ -0,0 +1,489 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Solves linear systems which were captured by a simulator using the linear
+ *        solvers and preconditioners of eWoms.
+ *
+ * A simulator writes the linear systems to disk if the LinearSystemCaptureDirectory
+ * parameter is set. This tool reads these files and solves them with a linear solver
+ * and preconditioner which can be selected at runtime. The time required for setting up
+ * the solver and for solving the linear system is printed along with the number of
+ * iterations, i.e., this allows to benchmark linear solvers without running the
+ * simulator. A system which was captured on N processes must be replayed on N processes.
+ */
+#include "config.h"
+
+#include <ewoms/common/start.hh>
+#include <ewoms/common/timer.hh>
+#include <ewoms/parallel/threadmanager.hh>
+#include <ewoms/linear/parallelbicgstabbackend.hh>
+#include <ewoms/linear/parallelgcrodrbackend.hh>
+#include <ewoms/linear/parallelamgbackend.hh>
+#include <ewoms/linear/linearsystemio.hh>
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef REPLAY_NUM_EQ
+// the number of equations per degree of freedom must be known at compile time. The
+// default is suitable for three-phase blackoil simulations.
+#define REPLAY_NUM_EQ 3
+#endif
+
+namespace Ewoms {
+template <class TypeTag>
+class ReplaySimulator;
+}
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(ReplayLinearSolver, INHERITS_FROM(NumericModel));
+
+NEW_PROP_TAG(NumEq);
+NEW_PROP_TAG(Simulator);
+NEW_PROP_TAG(JacobianMatrix);
+NEW_PROP_TAG(GlobalEqVector);
+NEW_PROP_TAG(BorderListCreator);
+NEW_PROP_TAG(ThreadManager);
+NEW_PROP_TAG(ThreadsPerProcess);
+NEW_PROP_TAG(ThreadAffinity);
+NEW_PROP_TAG(CheckMemoryBandwidth);
+NEW_PROP_TAG(NewtonTolerance);
+
+//! The linear solver which is used to solve the systems ("bicgstab", "gcrodr" or "amg")
+NEW_PROP_TAG(ReplaySolver);
+
+//! The preconditioner which is used by the Krylov solvers
+NEW_PROP_TAG(ReplayPreconditioner);
+
+//! A comma separated list of the base names of the captured linear systems
+NEW_PROP_TAG(ReplaySystems);
+
+//! The number of times each linear system is solved
+NEW_PROP_TAG(ReplayRepetitions);
+
+SET_INT_PROP(ReplayLinearSolver, NumEq, REPLAY_NUM_EQ);
+
+SET_PROP(ReplayLinearSolver, JacobianMatrix)
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    static constexpr int numEq = GET_PROP_VALUE(TypeTag, NumEq);
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<Scalar, numEq, numEq> > type;
+};
+
+SET_PROP(ReplayLinearSolver, GlobalEqVector)
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    static constexpr int numEq = GET_PROP_VALUE(TypeTag, NumEq);
+    typedef Dune::BlockVector<Dune::FieldVector<Scalar, numEq> > type;
+};
+
+SET_TYPE_PROP(ReplayLinearSolver, Simulator, Ewoms::ReplaySimulator<TypeTag>);
+SET_TYPE_PROP(ReplayLinearSolver, GridView, typename Ewoms::ReplaySimulator<TypeTag>::GridView);
+SET_TYPE_PROP(ReplayLinearSolver,
+              BorderListCreator,
+              typename Ewoms::ReplaySimulator<TypeTag>::BorderListCreator);
+SET_TYPE_PROP(ReplayLinearSolver, ThreadManager, Ewoms::ThreadManager<TypeTag>);
+SET_INT_PROP(ReplayLinearSolver, ThreadsPerProcess, 1);
+SET_STRING_PROP(ReplayLinearSolver, ThreadAffinity, "none");
+SET_BOOL_PROP(ReplayLinearSolver, CheckMemoryBandwidth, false);
+
+//! the absolute tolerance of the linear solvers is a tenth of the one of the
+//! non-linear solver
+SET_SCALAR_PROP(ReplayLinearSolver, NewtonTolerance, 1e-8);
+
+SET_STRING_PROP(ReplayLinearSolver, ReplaySolver, "bicgstab");
+SET_STRING_PROP(ReplayLinearSolver, ReplayPreconditioner, "ilu0");
+SET_STRING_PROP(ReplayLinearSolver, ReplaySystems, "");
+SET_INT_PROP(ReplayLinearSolver, ReplayRepetitions, 1);
+
+// define a type tag for each combination of Krylov solver and preconditioner
+#define EWOMS_REPLAY_SOLVER(SOLVER, PRECOND)                            \
+    NEW_TYPE_TAG(Replay##SOLVER##PRECOND,                               \
+                 INHERITS_FROM(ReplayLinearSolver,                      \
+                               Parallel##SOLVER##LinearSolver));        \
+    SET_TYPE_PROP(Replay##SOLVER##PRECOND,                              \
+                  PreconditionerWrapper,                                \
+                  Ewoms::Linear::PreconditionerWrapper##PRECOND<TypeTag>);
+
+EWOMS_REPLAY_SOLVER(BiCGStab, ILU0)
+EWOMS_REPLAY_SOLVER(BiCGStab, ILUn)
+EWOMS_REPLAY_SOLVER(BiCGStab, Jacobi)
+EWOMS_REPLAY_SOLVER(BiCGStab, SSOR)
+EWOMS_REPLAY_SOLVER(BiCGStab, LevelScheduledIlu0)
+EWOMS_REPLAY_SOLVER(GcroDr, ILU0)
+EWOMS_REPLAY_SOLVER(GcroDr, ILUn)
+EWOMS_REPLAY_SOLVER(GcroDr, Jacobi)
+EWOMS_REPLAY_SOLVER(GcroDr, SSOR)
+EWOMS_REPLAY_SOLVER(GcroDr, LevelScheduledIlu0)
+
+#undef EWOMS_REPLAY_SOLVER
+
+// the AMG backend always uses its own preconditioner
+NEW_TYPE_TAG(ReplayAmg, INHERITS_FROM(ReplayLinearSolver, ParallelAmgLinearSolver));
+}} // namespace Properties, Ewoms
+
+namespace Ewoms {
+/*!
+ * \brief Provides the parts of the simulator interface which are used by the linear
+ *        solver backends for a linear system which was read from disk.
+ */
+template <class TypeTag>
+class ReplaySimulator
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) Matrix;
+    typedef typename GET_PROP_TYPE(TypeTag, GlobalEqVector) Vector;
+    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverBackend) LinearSolverBackend;
+
+public:
+    /*!
+     * \brief A grid view which only provides the collective communication object.
+     */
+    class GridView
+    {
+    public:
+        typedef decltype(Dune::MPIHelper::getCollectiveCommunication()) CollectiveCommunication;
+
+        // the captured systems do not tell us anything about the grid. the dimension
+        // is only used as a hint for the AMG coarsening, so assume 3D.
+        static const int dimension = 3;
+        static const int dimensionworld = 3;
+
+        GridView()
+            : comm_(Dune::MPIHelper::getCollectiveCommunication())
+        {}
+
+        const CollectiveCommunication& comm() const
+        { return comm_; }
+
+    private:
+        CollectiveCommunication comm_;
+    };
+
+    /*!
+     * \brief The overlap related information of a captured linear system.
+     *
+     * This plays the role of the DOF mapper for the border list creator.
+     */
+    struct SystemTopology
+    {
+        Linear::BorderList borderList;
+        Linear::BlackList blackList;
+    };
+
+    /*!
+     * \brief Hands the border list and the black list of the captured system to the
+     *        linear solver backend.
+     */
+    class BorderListCreator
+    {
+    public:
+        BorderListCreator(const GridView& gridView OPM_UNUSED,
+                          const SystemTopology& topology)
+            : topology_(topology)
+        {}
+
+        const Linear::BorderList& borderList() const
+        { return topology_.borderList; }
+
+        const Linear::BlackList& blackList() const
+        { return topology_.blackList; }
+
+    private:
+        const SystemTopology& topology_;
+    };
+
+    class GridManager
+    {
+    public:
+        GridManager(const GridView& gridView)
+            : gridView_(gridView)
+            , sequenceNumber_(0)
+        {}
+
+        const GridView& gridView() const
+        { return gridView_; }
+
+        int gridSequenceNumber() const
+        { return sequenceNumber_; }
+
+        // each captured system may have a different sparsity pattern, so we pretend
+        // that the grid is changed for every system
+        void increaseSequenceNumber()
+        { ++sequenceNumber_; }
+
+    private:
+        const GridView& gridView_;
+        int sequenceNumber_;
+    };
+
+    class NewtonMethod
+    {
+    public:
+        Scalar tolerance() const
+        { return EWOMS_GET_PARAM(TypeTag, Scalar, NewtonTolerance); }
+
+        int numIterations() const
+        { return 0; }
+    };
+
+    class Model
+    {
+    public:
+        const SystemTopology& dofMapper() const
+        { return topology_; }
+
+        Scalar eqWeight(unsigned globalDofIdx, unsigned eqIdx) const
+        { return eqWeights_[globalDofIdx][eqIdx]; }
+
+        const NewtonMethod& newtonMethod() const
+        { return newtonMethod_; }
+
+    private:
+        friend class ReplaySimulator;
+
+        SystemTopology topology_;
+        Vector eqWeights_;
+        NewtonMethod newtonMethod_;
+    };
+
+    ReplaySimulator()
+        : gridManager_(gridView_)
+    {}
+
+    /*!
+     * \brief Register all run-time parameters of the replay tool.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ReplaySolver,
+                             "The linear solver used to solve the captured systems. "
+                             "Possible values: bicgstab, gcrodr, amg");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ReplayPreconditioner,
+                             "The preconditioner used by the Krylov solvers. Possible values: "
+                             "ilu0, ilun, jacobi, ssor, levelscheduledilu0");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ReplaySystems,
+                             "A comma separated list of the base names of the captured "
+                             "linear systems, e.g. 'capture/linsys_t10_i2'");
+        EWOMS_REGISTER_PARAM(TypeTag, int, ReplayRepetitions,
+                             "The number of times each linear system is solved");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonTolerance,
+                             "The tolerance of the non-linear solver which was used "
+                             "by the simulator");
+
+        LinearSolverBackend::registerParameters();
+    }
+
+    const GridView& gridView() const
+    { return gridView_; }
+
+    const GridManager& gridManager() const
+    { return gridManager_; }
+
+    const Model& model() const
+    { return model_; }
+
+    int timeStepIndex() const
+    { return 0; }
+
+    /*!
+     * \brief Read the part of a captured linear system which belongs to the current
+     *        process.
+     */
+    void loadSystem(const std::string& baseName, Matrix& matrix, Vector& rhs)
+    {
+        const auto& comm = gridView_.comm();
+        std::string fileName = Linear::LinearSystemIO::systemFileName(baseName, comm.rank());
+
+        model_.topology_ = SystemTopology();
+        auto header = Linear::LinearSystemIO::read(fileName,
+                                                   matrix,
+                                                   rhs,
+                                                   model_.eqWeights_,
+                                                   model_.topology_.borderList,
+                                                   model_.topology_.blackList);
+        if (static_cast<int>(header.commSize) != comm.size())
+            OPM_THROW(std::runtime_error,
+                      "The linear system '" << baseName << "' was captured using "
+                      << header.commSize << " processes but it is replayed using "
+                      << comm.size());
+
+        gridManager_.increaseSequenceNumber();
+    }
+
+private:
+    GridView gridView_;
+    GridManager gridManager_;
+    Model model_;
+};
+
+/*!
+ * \brief Solve all captured linear systems using the backend specified by a type tag.
+ */
+template <class TypeTag>
+int replay(int argc, char **argv)
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
+    typedef typename GET_PROP_TYPE(TypeTag, LinearSolverBackend) LinearSolverBackend;
+    typedef typename GET_PROP_TYPE(TypeTag, JacobianMatrix) Matrix;
+    typedef typename GET_PROP_TYPE(TypeTag, GlobalEqVector) Vector;
+
+    int paramStatus = setupParameters_<TypeTag>(argc, const_cast<const char**>(argv));
+    if (paramStatus == 1)
+        return 1;
+    if (paramStatus == 2)
+        return 0;
+
+    ThreadManager::init(Dune::MPIHelper::getCommunicator());
+
+    Simulator simulator;
+    const auto& comm = simulator.gridView().comm();
+    int numRepetitions = EWOMS_GET_PARAM(TypeTag, int, ReplayRepetitions);
+
+    std::vector<std::string> baseNames;
+    std::istringstream iss(EWOMS_GET_PARAM(TypeTag, std::string, ReplaySystems));
+    std::string token;
+    while (std::getline(iss, token, ','))
+        if (!token.empty())
+            baseNames.push_back(token);
+
+    if (baseNames.empty()) {
+        if (comm.rank() == 0)
+            std::cerr << "No linear systems specified. Use --replay-systems=BASE_NAME[,...]\n";
+        return 1;
+    }
+
+    if (comm.rank() == 0)
+        std::cout << std::left << std::setw(40) << "system"
+                  << std::setw(12) << "rows"
+                  << std::setw(12) << "converged"
+                  << std::setw(12) << "iterations"
+                  << std::setw(14) << "setup [s]"
+                  << std::setw(14) << "solve [s]"
+                  << "\n" << std::flush;
+
+    for (const auto& baseName : baseNames) {
+        Matrix M;
+        Vector b;
+        simulator.loadSystem(baseName, M, b);
+        int numRows = comm.sum(static_cast<int>(M.N()));
+
+        LinearSolverBackend backend(simulator);
+        for (int repIdx = 0; repIdx < numRepetitions; ++repIdx) {
+            Vector rhs(b);
+            Vector x(b.size());
+            x = 0.0;
+
+            Timer setupTimer;
+            setupTimer.start();
+            backend.prepareRhs(M, rhs);
+            backend.prepareMatrix(M);
+            double setupTime = comm.max(setupTimer.stop());
+
+            Timer solveTimer;
+            solveTimer.start();
+            bool converged = backend.solve(x);
+            double solveTime = comm.max(solveTimer.stop());
+
+            if (comm.rank() == 0)
+                std::cout << std::left << std::setw(40) << baseName
+                          << std::setw(12) << numRows
+                          << std::setw(12) << (converged ? "yes" : "no")
+                          << std::setw(12) << backend.numIterations()
+                          << std::setw(14) << setupTime
+                          << std::setw(14) << solveTime
+                          << "\n" << std::flush;
+        }
+    }
+
+    return 0;
+}
+
+// returns the value of a command line option of the form --name=value
+static std::string commandLineValue(int argc, char **argv, const std::string& name, const std::string& defaultValue)
+{
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, prefix.size(), prefix) == 0)
+            return arg.substr(prefix.size());
+    }
+    return defaultValue;
+}
+} // namespace Ewoms
+
+int main(int argc, char **argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    // the linear solver backend and the preconditioner are compile-time properties, so
+    // they must be selected before the parameter system gets initialized
+    std::string solver = Ewoms::commandLineValue(argc, argv, "replay-solver", "bicgstab");
+    std::string precond = Ewoms::commandLineValue(argc, argv, "replay-preconditioner", "ilu0");
+
+    try {
+#define EWOMS_REPLAY_DISPATCH(SOLVER_NAME, PRECOND_NAME, TYPE_TAG)           \
+        if (solver == SOLVER_NAME && precond == PRECOND_NAME)               \
+            return Ewoms::replay<TTAG(TYPE_TAG)>(argc, argv);
+
+        EWOMS_REPLAY_DISPATCH("bicgstab", "ilu0", ReplayBiCGStabILU0)
+        EWOMS_REPLAY_DISPATCH("bicgstab", "ilun", ReplayBiCGStabILUn)
+        EWOMS_REPLAY_DISPATCH("bicgstab", "jacobi", ReplayBiCGStabJacobi)
+        EWOMS_REPLAY_DISPATCH("bicgstab", "ssor", ReplayBiCGStabSSOR)
+        EWOMS_REPLAY_DISPATCH("bicgstab", "levelscheduledilu0", ReplayBiCGStabLevelScheduledIlu0)
+        EWOMS_REPLAY_DISPATCH("gcrodr", "ilu0", ReplayGcroDrILU0)
+        EWOMS_REPLAY_DISPATCH("gcrodr", "ilun", ReplayGcroDrILUn)
+        EWOMS_REPLAY_DISPATCH("gcrodr", "jacobi", ReplayGcroDrJacobi)
+        EWOMS_REPLAY_DISPATCH("gcrodr", "ssor", ReplayGcroDrSSOR)
+        EWOMS_REPLAY_DISPATCH("gcrodr", "levelscheduledilu0", ReplayGcroDrLevelScheduledIlu0)
+
+#undef EWOMS_REPLAY_DISPATCH
+
+        if (solver == "amg")
+            return Ewoms::replay<TTAG(ReplayAmg)>(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Replaying the linear systems failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cerr << "Unknown combination of linear solver '" << solver
+              << "' and preconditioner '" << precond << "'\n";
+    return 1;
+}